@@ -0,0 +1,135 @@
+/*
+ * ChangeStream.cpp
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "ChangeStream.h"
+
+ChangeStream::ChangeStream() {}
+
+void ChangeStream::subscribe(DeltaSink* sink, Backpressure policy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    sink->closed = false;
+    subscriptions.push_back(Subscription {sink, policy});
+
+    // The values emitted so far, so that the sink starts from a complete state
+    GeoDelta delta;
+    for (unsigned int i = 0; i < well_defined.size(); ++i) {
+        last(i, &delta);
+        deliver(subscriptions.back(), delta);
+    }
+    sink->end_pass();
+}
+
+void ChangeStream::unsubscribe(DeltaSink* sink) {
+    sink->closed = true;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = begin(subscriptions); it != end(subscriptions); ++it) {
+        if (it->sink == sink) {
+            subscriptions.erase(it);
+            break;
+        }
+    }
+}
+
+void ChangeStream::publish(GeoComponents& geo_components, const vector<unsigned int>& touched) {
+    std::lock_guard<std::mutex> lock(mutex);
+    sequence = geo_components.get_sequence();
+
+    // Pull mode: comparing would demand every touched construction, the next subscriber then starts from a new topology
+    if (subscriptions.empty() && geo_components.get_evaluation() == Evaluation::PULL) {
+        topology = static_cast<unsigned long>(-1);
+        data.clear();
+        well_defined.clear();
+        return;
+    }
+
+    // New topology: every construction is emitted
+    bool all = (topology != geo_components.get_topology() || well_defined.size() != geo_components.size());
+    if (all) {
+        topology = geo_components.get_topology();
+        data.assign(geo_components.size() * GeoNode::DATA_SIZE, 0);
+        well_defined.assign(geo_components.size(), 0);
+    }
+
+    GeoDelta delta;
+    unsigned int count = all ? geo_components.size() : touched.size();
+    for (unsigned int k = 0; k < count; ++k) {
+        unsigned int pid = all ? k : touched[k];
+        // After a topology change, the unchanged ones (not well-defined, as reset) are emitted as they are
+        if (!changed(geo_components, pid, &delta)) {
+            if (!all)
+                continue;
+            last(pid, &delta);
+        }
+        for (auto it = begin(subscriptions); it != end(subscriptions); ++it)
+            deliver(*it, delta);
+    }
+
+    for (auto it = begin(subscriptions); it != end(subscriptions); ++it)
+        it->sink->end_pass();
+}
+
+void ChangeStream::publish(GeoComponents& geo_components) {
+    if (topology != geo_components.get_topology())
+        publish(geo_components, vector<unsigned int>());
+}
+
+bool ChangeStream::changed(GeoComponents& geo_components, unsigned int pid, GeoDelta* delta) {
+    double values[GeoNode::DATA_SIZE] = {};
+    geo_components.access(pid, values);
+    char defined = geo_components.get_construction(pid)->get_well_defined();
+
+    double* previous = &data[pid * GeoNode::DATA_SIZE];
+    if (defined == well_defined[pid] && (!defined || equal(values, values + GeoNode::DATA_SIZE, previous)))
+        return false;
+
+    copy(values, values + GeoNode::DATA_SIZE, previous);
+    well_defined[pid] = defined;
+    last(pid, delta);
+    return true;
+}
+
+void ChangeStream::last(unsigned int pid, GeoDelta* delta) const {
+    delta->pid = pid;
+    delta->well_defined = well_defined[pid];
+    delta->sequence = sequence;
+    copy(&data[pid * GeoNode::DATA_SIZE], &data[(pid + 1) * GeoNode::DATA_SIZE], delta->data);
+}
+
+void ChangeStream::deliver(Subscription& subscription, const GeoDelta& delta) {
+    DeltaSink* sink = subscription.sink;
+
+    if (subscription.policy == Backpressure::DROP_OLDEST) {
+        if (!sink->offer_over(delta)) {
+            ++sink->dropped;
+            ++dropped;
+        }
+    } else {
+        // Blocked until the consumer makes room, or the sink is unsubscribed
+        while (!sink->offer(delta)) {
+            if (sink->closed) {
+                ++sink->dropped;
+                ++dropped;
+                return;
+            }
+            sink->end_pass();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    ++sink->emitted;
+    ++emitted;
+}
+
+unsigned long long ChangeStream::get_emitted() const {
+    return emitted;
+}
+
+unsigned long long ChangeStream::get_dropped() const {
+    return dropped;
+}
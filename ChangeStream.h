@@ -0,0 +1,68 @@
+/***************************************************************************
+This class, ChangeStream, emits the values recomputed by each propagation
+pass to subscribed sinks (see DeltaSinks.h). After a pass, only the
+constructions whose data or well-definedness actually changed are emitted,
+as GeoDeltas. After a topology change (constructions added or removed, pids
+renumbered), every construction is emitted again.
+
+Each subscription has a backpressure policy: drop the oldest delta held by
+the sink, or block the propagation until the consumer makes room. Emitted
+and dropped deltas are counted per sink and in total.
+
+In pull mode (see GeoComponents), the values compared are demanded, so
+nothing is compared while no sink is subscribed: a new sink then receives
+every construction at the next publication.
+****************************************************************************/
+
+#ifndef CHANGESTREAM_H_
+#define CHANGESTREAM_H_
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "DeltaSinks.h"
+#include "GeoComponents.h"
+
+class ChangeStream {
+
+public:
+    ChangeStream(); /**< @brief Constructor */
+
+    /** @brief Subscribes a sink (not owned), which receives every construction as last emitted first, then the changes. */
+    void subscribe(DeltaSink* sink, Backpressure policy = Backpressure::DROP_OLDEST);
+    /** @brief Unsubscribes a sink, giving up if the propagation is blocked on it. The sink may be deleted afterwards. */
+    void unsubscribe(DeltaSink* sink);
+
+    /** @brief Takes the constructions and the pids recomputed by the last pass, emits the ones that changed (all of them after a topology change). */
+    void publish(GeoComponents& geo_components, const vector<unsigned int>& touched);
+    /** @brief Takes the constructions after a structural change, and emits all of them if the topology changed. */
+    void publish(GeoComponents& geo_components);
+
+    unsigned long long get_emitted() const; /**< @brief Returns the number of deltas taken by the sinks, in total. */
+    unsigned long long get_dropped() const; /**< @brief Returns the number of deltas dropped by backpressure, in total. */
+
+private:
+    /** @brief A sink and its policy. */
+    struct Subscription {
+        DeltaSink* sink;
+        Backpressure policy;
+    };
+
+    /** @brief Compares the construction with the given pid to its last emitted values, and if it changed, sets delta and remembers it. */
+    bool changed(GeoComponents& geo_components, unsigned int pid, GeoDelta* delta);
+    /** @brief Takes a delta and hands it to a subscription, following its policy (the name emit is taken by Qt). */
+    void deliver(Subscription& subscription, const GeoDelta& delta);
+    /** @brief Takes a pid and sets delta to the last emitted values of the construction. */
+    void last(unsigned int pid, GeoDelta* delta) const;
+
+    std::mutex mutex; /**< @brief Protects the subscriptions and the last values, held during a publication. */
+    vector<Subscription> subscriptions; /**< @brief Subscribed sinks. */
+    vector<double> data; /**< @brief Last emitted data of each construction, DATA_SIZE per pid. */
+    vector<char> well_defined; /**< @brief Last emitted well-definedness of each construction. */
+    unsigned long topology {static_cast<unsigned long>(-1)}; /**< @brief Topology of the last emitted values. */
+    unsigned long sequence {0}; /**< @brief Sequence of the last publication. */
+    std::atomic<unsigned long long> emitted {0}; /**< @brief Total of the deltas taken by the sinks. */
+    std::atomic<unsigned long long> dropped {0}; /**< @brief Total of the deltas dropped. */
+};
+
+#endif /* CHANGESTREAM_H_ */
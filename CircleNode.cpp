@@ -3,14 +3,19 @@
  *
  */
 
+#include <algorithm>
 #include <cmath>
 #include "CircleNode.h"
+#include "GeoDescriptor.h"
+#include "FigurePool.h"
+#include "GeoPredicates.h"
 
 CircleNode::CircleNode(CircleType type, GeoNode* geo1, GeoNode* geo2) : GeoNode(2) {
+    this->type = type;
 
     // Identification of definition from CircleType
     switch(type) {
-    case CircleType::POINT_POINT_CENTER_THROUGH: definition = &CircleNode::point_point_center_through; break;
+    case CircleType::POINT_POINT_CENTER_THROUGH: identify<double>(); break;
     default: well_defined = false; return;
     }
 
@@ -23,11 +28,12 @@ CircleNode::CircleNode(CircleType type, GeoNode* geo1, GeoNode* geo2) : GeoNode(
 }
 
 CircleNode::CircleNode(CircleType type, GeoNode* geo1, GeoNode* geo2, GeoNode* geo3) : GeoNode(3) {
+    this->type = type;
 
     // Identification of definition from CircleType
     switch(type) {
-    case CircleType::POINT_POINT_POINT_THROUGH: definition = &CircleNode::point_point_point_through; break;
-    case CircleType::POINT_POINT_POINT_CENTER_RADIUS: definition = &CircleNode::point_point_point_center_radius; break;
+    case CircleType::POINT_POINT_POINT_THROUGH:
+    case CircleType::POINT_POINT_POINT_CENTER_RADIUS: identify<double>(); break;
     default: well_defined = false; return;
     }
 
@@ -40,6 +46,26 @@ CircleNode::CircleNode(CircleType type, GeoNode* geo1, GeoNode* geo2, GeoNode* g
     update();
 }
 
+template <class T>
+void CircleNode::identify() {
+    switch(type) {
+    case CircleType::POINT_POINT_POINT_THROUGH: definition = &CircleNode::point_point_point_through<T>; break;
+    case CircleType::POINT_POINT_CENTER_THROUGH: definition = &CircleNode::point_point_center_through<T>; break;
+    case CircleType::POINT_POINT_POINT_CENTER_RADIUS: definition = &CircleNode::point_point_point_center_radius<T>; break;
+    }
+}
+
+void CircleNode::set_precision(Precision precision) {
+    this->precision = precision;
+    if(definition == nullptr)
+        return;
+    switch(precision) {
+    case Precision::SINGLE: identify<float>(); break;
+    case Precision::DOUBLE: identify<double>(); break;
+    case Precision::DOUBLE_DOUBLE: identify<DoubleDouble>(); break;
+    }
+}
+
 CircleNode::~CircleNode() {
     if(circle != nullptr)
         (circle->parentPlot())->removeItem(circle);
@@ -55,23 +81,58 @@ void CircleNode::print() const {
     cout << endl;
 }
 
-void CircleNode::display(Ui::MainWindow *ui) {
-    if(circle == nullptr){ //Initialization
-        circle = new QCPItemEllipse(ui->custom_plot);
-        circle->setAntialiased(true);
-        circle->setPen(QPen(QColor(120, 120, 120), 2));
+void CircleNode::display(Ui::MainWindow *ui, FigurePool* pool, const double data[], bool defined) {
+    if(circle == nullptr){ //Initialization, only once there is something to be seen
+        if(!defined)
+            return;
+        circle = pool->acquire_circle(ui->custom_plot);
         circle->setObjectName(QString::fromStdString(this->get_label()));
     }
 
-    circle->setVisible(well_defined);
-    circle->topLeft->setCoords(center_x-radius, center_y+radius);
-    circle->bottomRight->setCoords(center_x+radius, center_y-radius);
+    circle->setVisible(defined);
+    circle->topLeft->setCoords(data[0]-data[2], data[1]+data[2]);
+    circle->bottomRight->setCoords(data[0]+data[2], data[1]-data[2]);
+}
+
+void CircleNode::release(FigurePool* pool) {
+    if(circle != nullptr){
+        pool->release(circle);
+        circle = nullptr;
+    }
+}
+
+bool CircleNode::in_view(const double data[], const double view[4]) const {
+
+    // Nearest and farthest points of the rectangle from the center
+    double near_x = max(view[0], min(data[0], view[1]));
+    double near_y = max(view[2], min(data[1], view[3]));
+    double far_x = max(abs(data[0] - view[0]), abs(data[0] - view[1]));
+    double far_y = max(abs(data[1] - view[2]), abs(data[1] - view[3]));
+
+    double near = (near_x - data[0]) * (near_x - data[0]) + (near_y - data[1]) * (near_y - data[1]);
+    double far = far_x * far_x + far_y * far_y;
+
+    // The circle crosses the rectangle unless the rectangle lies inside or outside of the disk
+    return near <= data[2] * data[2] && far >= data[2] * data[2];
+}
+
+void CircleNode::bounds(const double data[], double box[4]) const {
+    box[0] = data[0] - data[2];
+    box[1] = data[0] + data[2];
+    box[2] = data[1] - data[2];
+    box[3] = data[1] + data[2];
 }
 
 void CircleNode::labels(vector<string>*, vector<string>*, vector<string>* circle_labels, vector<string>*) const {
     circle_labels->push_back(this->get_label());
 }
 
+bool CircleNode::structure(vector<unsigned int>* key) const {
+    bool symmetric = (type == CircleType::POINT_POINT_POINT_THROUGH);
+    make_structure(static_cast<unsigned int>(GeoKind::CIRCLE), static_cast<unsigned int>(type), symmetric, key);
+    return true;
+}
+
 void CircleNode::access(double data[]) const {
     data[0] = center_x;
     data[1] = center_y;
@@ -86,13 +147,15 @@ void CircleNode::mutate(double data[]) {
 }
 
 void CircleNode::update() {
+    // Points at infinity (homogeneous coordinates) have no Cartesian coordinates to build on
     well_defined = true;
     for (int i = 0; i < num_parents; ++i)
-        well_defined &= parents[i]->get_well_defined();
+        well_defined &= parents[i]->get_well_defined() && parents[i]->is_finite();
     if (well_defined)
         (this->*definition)();
 }
 
+template <class T>
 void CircleNode::point_point_point_through() {
 
     // Data Access
@@ -102,51 +165,54 @@ void CircleNode::point_point_point_through() {
     parents[2]->access(p3);
 
     // Mathematical Formula
-    double distance = p3[0]*(p1[1] - p2[1]) + p3[1]*(p2[0] - p1[0]) - (p1[0]*(p1[1] - p2[1]) + p1[1]*(p2[0] - p1[0]));
-
-    if(distance < EPSILON && distance > -EPSILON) {
+    if(GeoPredicates::orientation(p1, p2, p3, GeoPredicates::tolerance<T>()) == 0) {
         well_defined = false;
 
     } else {
-        double x1=p1[0], x2=p2[0], x3=p3[0];
-        double y1=p1[1], y2=p2[1], y3=p3[1];
+        T x1=p1[0], x2=p2[0], x3=p3[0];
+        T y1=p1[1], y2=p2[1], y3=p3[1];
 
-        double x12 = x1 - x2, x13 = x1 - x3, x31 = x3 - x1, x21 = x2 - x1;
-        double y12 = y1 - y2, y13 = y1 - y3, y31 = y3 - y1, y21 = y2 - y1;
+        T x12 = x1 - x2, x13 = x1 - x3, x31 = x3 - x1, x21 = x2 - x1;
+        T y12 = y1 - y2, y13 = y1 - y3, y31 = y3 - y1, y21 = y2 - y1;
 
-        double sx13 = x1*x1 - x3*x3, sx21 = x2*x2 - x1*x1;
-        double sy13 = y1*y1 - y3*y3, sy21 = y2*y2 - y1*y1;
+        T sx13 = x1*x1 - x3*x3, sx21 = x2*x2 - x1*x1;
+        T sy13 = y1*y1 - y3*y3, sy21 = y2*y2 - y1*y1;
 
-        center_y = (-1)*((sx13) * (x12) + (sy13) * (x12) + (sx21) * (x13) + (sy21) * (x13));
-        center_y /= (2 * ((y31) * (x12) - (y21) * (x13)));
+        T y = (-1)*((sx13) * (x12) + (sy13) * (x12) + (sx21) * (x13) + (sy21) * (x13));
+        y /= (2 * ((y31) * (x12) - (y21) * (x13)));
 
-        center_x = (-1)*((sx13) * (y12) + (sy13) * (y12)  + (sx21) * (y13) + (sy21) * (y13));
-        center_x /= (2 * ((x31) * (y12) - (x21) * (y13)));
+        T x = (-1)*((sx13) * (y12) + (sy13) * (y12)  + (sx21) * (y13) + (sy21) * (y13));
+        x /= (2 * ((x31) * (y12) - (x21) * (y13)));
 
-        radius = sqrt((center_x - x1)*(center_x - x1) + (center_y - y1)*(center_y - y1));
+        center_x = static_cast<double>(x);
+        center_y = static_cast<double>(y);
+        radius = static_cast<double>(sqrt((x - x1)*(x - x1) + (y - y1)*(y - y1)));
 
         well_defined = true;
 
     }
 }
 
+template <class T>
 void CircleNode::point_point_center_through(){
 
     // Data Access
     double p1[2], p2[2];
     parents[0]->access(p1);
     parents[1]->access(p2);
+    T delta_x = T(p2[0]) - T(p1[0]), delta_y = T(p2[1]) - T(p1[1]);
 
     // Mathematical Formula
     center_x = p1[0];
     center_y = p1[1];
 
-    radius = sqrt((p2[0] - p1[0])*(p2[0] - p1[0]) + (p2[1] - p1[1])*(p2[1] - p1[1]));
+    radius = static_cast<double>(sqrt(delta_x*delta_x + delta_y*delta_y));
 
-    well_defined = (radius > EPSILON);
+    well_defined = !GeoPredicates::coincident(p1, p2, GeoPredicates::tolerance<T>());
 
 }
 
+template <class T>
 void CircleNode::point_point_point_center_radius(){
 
     // Data Access
@@ -154,12 +220,13 @@ void CircleNode::point_point_point_center_radius(){
     parents[0]->access(p1);
     parents[1]->access(p2);
     parents[2]->access(p3);
+    T delta_x = T(p3[0]) - T(p2[0]), delta_y = T(p3[1]) - T(p2[1]);
 
     // Mathematical Formula
     center_x = p1[0];
     center_y = p1[1];
 
-    radius = sqrt((p3[0] - p2[0])*(p3[0] - p2[0]) + (p3[1] - p2[1])*(p3[1] - p3[1]));
+    radius = static_cast<double>(sqrt(delta_x*delta_x + delta_y*delta_y));
 
-    well_defined = (radius > EPSILON);
+    well_defined = !GeoPredicates::coincident(p2, p3, GeoPredicates::tolerance<T>());
 }
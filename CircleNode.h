@@ -29,20 +29,32 @@ private:
     QCPItemEllipse *circle {nullptr}; /**< @brief Corresponding figure that represents the circle on the plot. */
     /** @brief Function pointer indicating the definition of the circle. */
     void (CircleNode::*definition)() {nullptr};
+    CircleType type; //!< Type of the circle, identifies its definition.
 
     virtual void print() const override; /**< @brief Prints all data components of the circle (Debugging purposes only). */
-    virtual void display(Ui::MainWindow* ui) override; /**< @brief Updates the corresponding figure on the plot (*circle). */
+    virtual void display(Ui::MainWindow* ui, FigurePool* pool, const double data[], bool defined) override; /**< @brief Updates the corresponding figure on the plot (*circle) from the given data, taking it from the pool on first need. */
+    virtual void release(FigurePool* pool) override; /**< @brief Gives the corresponding figure (*circle) back to the pool. */
+    virtual bool in_view(const double data[], const double view[4]) const override; /**< @brief Returns whether the circle crosses the view rectangle. */
+    virtual void bounds(const double data[], double box[4]) const override; /**< @brief Sets box to the square circumscribing the circle. */
     /** @brief Takes a collection of string vectors and adds the label of the circle to the circle_labels vector. */
     virtual void labels(vector<string>*, vector<string>*, vector<string>* circle_labels, vector<string>*) const override;
+    virtual bool structure(vector<unsigned int>* key) const override; /**< @brief Sets key to {kind, type, parent pids}. */
 
     virtual void access(double data[]) const override; /**< @brief Sets the array data as {x coordinate of the center, y coordinate of the center, radius}. */
     virtual void mutate(double data[]) override; /**< @brief Edits the circle based on the data = {new x coordinate of the center, new y coordinate of the center, new radius}. */
 
     virtual void update() override; /**< @brief Updates the construction to adjust for changes of the parents. */
 
-    void point_point_point_through(); /**< @brief Defines a circle passing through three given points. */
-    void point_point_center_through(); /**< @brief Defines a circle centered at the first point that passes through the second point. */
-    void point_point_point_center_radius(); /**< @brief Defines a circle centered at the first point with radius the distance between the second and third points. */
+    /** @brief Sets the definition of the type, computed in the scalar type T. */
+    template <class T> void identify();
+    virtual void set_precision(Precision precision) override; /**< @brief Sets the definition of the type again, computed in the given precision. */
+
+    //@{
+    /** @brief Definitions computed in the scalar type T (see GeoScalar.h), the data being kept in double. */
+    template <class T> void point_point_point_through(); /**< @brief Defines a circle passing through three given points. */
+    template <class T> void point_point_center_through(); /**< @brief Defines a circle centered at the first point that passes through the second point. */
+    template <class T> void point_point_point_center_radius(); /**< @brief Defines a circle centered at the first point with radius the distance between the second and third points. */
+    //@}
 
 };
 
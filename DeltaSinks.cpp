@@ -0,0 +1,119 @@
+/*
+ * DeltaSinks.cpp
+ *
+ */
+
+#include "DeltaSinks.h"
+
+// DeltaSink
+
+DeltaSink::~DeltaSink() {}
+
+unsigned long long DeltaSink::get_emitted() const {
+    return emitted;
+}
+
+unsigned long long DeltaSink::get_dropped() const {
+    return dropped;
+}
+
+// DeltaCallbackSink
+
+DeltaCallbackSink::DeltaCallbackSink(std::function<void(const std::vector<GeoDelta>&)> callback, unsigned int capacity)
+    : callback(callback), capacity(capacity) {
+    dispatcher = std::thread(&DeltaCallbackSink::dispatch, this);
+}
+
+DeltaCallbackSink::~DeltaCallbackSink() {
+    stop();
+}
+
+void DeltaCallbackSink::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running)
+            return;
+        running = false;
+    }
+    wake.notify_one();
+    dispatcher.join();
+}
+
+bool DeltaCallbackSink::offer(const GeoDelta& delta) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.size() >= capacity)
+        return false;
+    queue.push_back(delta);
+    return true;
+}
+
+bool DeltaCallbackSink::offer_over(const GeoDelta& delta) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bool full = (queue.size() >= capacity);
+    if (full)
+        queue.pop_front();
+    queue.push_back(delta);
+    return !full;
+}
+
+void DeltaCallbackSink::end_pass() {
+    wake.notify_one();
+}
+
+void DeltaCallbackSink::dispatch() {
+    std::vector<GeoDelta> deltas;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (running || !queue.empty()) {
+        if (queue.empty()) {
+            wake.wait(lock);
+            continue;
+        }
+
+        // The callback runs unlocked, the propagation keeps queueing meanwhile
+        deltas.assign(queue.begin(), queue.end());
+        queue.clear();
+        lock.unlock();
+        callback(deltas);
+        lock.lock();
+    }
+}
+
+// DeltaFileSink
+
+DeltaFileSink::DeltaFileSink(const std::string& path, unsigned int capacity)
+    : DeltaCallbackSink([this](const std::vector<GeoDelta>& deltas) { write(deltas); }, capacity),
+      file(path, std::ios::binary | std::ios::trunc) {}
+
+DeltaFileSink::~DeltaFileSink() {
+    // The dispatcher writes to the file, it is stopped before the file is closed
+    stop();
+}
+
+bool DeltaFileSink::is_open() const {
+    return file.is_open();
+}
+
+void DeltaFileSink::write(const std::vector<GeoDelta>& deltas) {
+    file.write(reinterpret_cast<const char*>(deltas.data()), deltas.size() * sizeof(GeoDelta));
+    file.flush();
+}
+
+// DeltaRingSink
+
+DeltaRingSink::DeltaRingSink(const QString& key): ring(key) {}
+
+bool DeltaRingSink::create(unsigned int capacity) {
+    return ring.create(capacity);
+}
+
+bool DeltaRingSink::offer(const GeoDelta& delta) {
+    // Checked first, so that a blocked propagation retrying does not count drops in the ring
+    return !ring.full() && ring.push(delta);
+}
+
+bool DeltaRingSink::offer_over(const GeoDelta& delta) {
+    quint64 dropped = ring.get_dropped();
+    ring.push_over(delta);
+    return ring.get_dropped() == dropped;
+}
@@ -0,0 +1,119 @@
+/***************************************************************************
+These classes are the transports of the ChangeStream. A DeltaSink takes the
+deltas (new values of a recomputed construction) of each propagation pass
+and hands them to a consumer:
+    - DeltaCallbackSink: calls a function of the same process, from its own
+      dispatcher thread, with the deltas queued since the last call.
+    - DeltaFileSink: appends the deltas, as raw GeoDelta records, to a file.
+    - DeltaRingSink: pushes the deltas into a SharedRing read by another
+      process.
+Sinks are bounded: when one is full, the ChangeStream either drops the
+oldest delta it holds or waits for room, depending on the subscription.
+****************************************************************************/
+
+#ifndef DELTASINKS_H_
+#define DELTASINKS_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GeoNode.h"
+#include "SharedRing.h"
+
+/** @brief New values of a construction after a propagation pass. */
+struct GeoDelta {
+    quint32 pid {0}; //!< Pid of the construction.
+    quint32 well_defined {0}; //!< Whether the construction is well-defined.
+    quint64 sequence {0}; //!< Propagation pass that produced the delta (GeoComponents::get_sequence).
+    double data[GeoNode::DATA_SIZE] {}; //!< New data, as returned by access.
+};
+
+/** @brief Policy of a subscription when its sink is full. */
+enum class Backpressure {
+    DROP_OLDEST, //!< The oldest delta held by the sink is dropped to make room.
+    BLOCK //!< The propagation waits until the consumer makes room.
+};
+
+class DeltaSink {
+
+public:
+    virtual ~DeltaSink();
+
+    /** @brief Takes a delta, returns false if there is no room for it. */
+    virtual bool offer(const GeoDelta& delta) = 0;
+    /** @brief Takes a delta, dropping the oldest one held if there is no room, returns false if one was dropped. */
+    virtual bool offer_over(const GeoDelta& delta) = 0;
+    virtual void end_pass() {} /**< @brief Called after the last delta of a pass. */
+
+    unsigned long long get_emitted() const; /**< @brief Returns the number of deltas taken by the sink. */
+    unsigned long long get_dropped() const; /**< @brief Returns the number of deltas dropped by backpressure. */
+
+protected:
+    friend class ChangeStream;
+    std::atomic<unsigned long long> emitted {0}; /**< @brief Number of deltas taken (counted by the ChangeStream). */
+    std::atomic<unsigned long long> dropped {0}; /**< @brief Number of deltas dropped (counted by the ChangeStream). */
+    std::atomic<bool> closed {false}; /**< @brief Set on unsubscribe, a blocked propagation then gives up on the sink. */
+};
+
+class DeltaCallbackSink : public DeltaSink {
+
+public:
+    /** @brief Constructor, takes the function called with the queued deltas and the capacity of the queue, starts the dispatcher thread. */
+    DeltaCallbackSink(std::function<void(const std::vector<GeoDelta>&)> callback, unsigned int capacity = 65536);
+    virtual ~DeltaCallbackSink(); /**< @brief Delivers the remaining deltas and joins the dispatcher thread. */
+
+    virtual bool offer(const GeoDelta& delta);
+    virtual bool offer_over(const GeoDelta& delta);
+    virtual void end_pass();
+
+protected:
+    void stop(); /**< @brief Delivers the remaining deltas and joins the dispatcher thread, must be called by the destructor of derived classes. */
+
+private:
+    void dispatch(); /**< @brief Loop of the dispatcher thread. */
+
+    std::function<void(const std::vector<GeoDelta>&)> callback; /**< @brief Consumer of the deltas. */
+    unsigned int capacity; /**< @brief Largest number of queued deltas. */
+    std::deque<GeoDelta> queue; /**< @brief Deltas not yet delivered. */
+    std::mutex mutex; /**< @brief Protects queue and running. */
+    std::condition_variable wake; /**< @brief Notified at the end of each pass and on stop. */
+    bool running {true}; /**< @brief Cleared to stop the dispatcher thread. */
+    std::thread dispatcher; /**< @brief Calls the callback. */
+};
+
+class DeltaFileSink : public DeltaCallbackSink {
+
+public:
+    /** @brief Constructor, takes the path of the file (truncated) and the capacity of the queue. */
+    DeltaFileSink(const std::string& path, unsigned int capacity = 65536);
+    virtual ~DeltaFileSink(); /**< @brief Writes the remaining deltas and closes the file. */
+
+    bool is_open() const; /**< @brief Returns whether the file could be opened. */
+
+private:
+    void write(const std::vector<GeoDelta>& deltas); /**< @brief Appends deltas to the file. */
+
+    std::ofstream file; /**< @brief The file, written by the dispatcher thread. */
+};
+
+class DeltaRingSink : public DeltaSink {
+
+public:
+    DeltaRingSink(const QString& key); /**< @brief Constructor, takes the key of the shared memory segment. */
+    /** @brief Creates the ring with room for capacity deltas, returns false if it cannot. */
+    bool create(unsigned int capacity = 4096);
+
+    virtual bool offer(const GeoDelta& delta);
+    virtual bool offer_over(const GeoDelta& delta);
+
+private:
+    SharedRing<GeoDelta> ring; /**< @brief The shared memory ring. */
+};
+
+#endif /* DELTASINKS_H_ */
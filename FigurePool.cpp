@@ -0,0 +1,116 @@
+/*
+ * FigurePool.cpp
+ *
+ */
+
+#include "FigurePool.h"
+
+FigurePool::FigurePool() {}
+
+FigurePool::~FigurePool() {
+    for (auto it = points.begin(); it != points.end(); ++it)
+        ((*it)->parentPlot())->removeGraph(*it);
+    for (auto it = lines.begin(); it != lines.end(); ++it)
+        ((*it)->parentPlot())->removeItem(*it);
+    for (auto it = circles.begin(); it != circles.end(); ++it)
+        ((*it)->parentPlot())->removeItem(*it);
+    for (auto it = triangles.begin(); it != triangles.end(); ++it)
+        ((*it)->parentPlot())->removePlottable(*it);
+}
+
+QCPGraph* FigurePool::acquire_point(QCustomPlot* plot) {
+    if (!points.empty()) {
+        QCPGraph* point = points.back();
+        points.pop_back();
+        point->setVisible(true);
+        ++reused;
+        return point;
+    }
+
+    QCPGraph* point = plot->addGraph();
+    point->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, QPen(Qt::black, 1.5), QBrush(Qt::white), 9));
+    point->setPen(QPen(QColor(120, 120, 120), 2));
+    point->setLayer("front");
+    ++created;
+    return point;
+}
+
+QCPItemStraightLine* FigurePool::acquire_line(QCustomPlot* plot) {
+    if (!lines.empty()) {
+        QCPItemStraightLine* line = lines.back();
+        lines.pop_back();
+        line->setVisible(true);
+        ++reused;
+        return line;
+    }
+
+    QCPItemStraightLine* line = new QCPItemStraightLine(plot);
+    line->setPen(QPen(QColor(120, 120, 120), 2));
+    ++created;
+    return line;
+}
+
+QCPItemEllipse* FigurePool::acquire_circle(QCustomPlot* plot) {
+    if (!circles.empty()) {
+        QCPItemEllipse* circle = circles.back();
+        circles.pop_back();
+        circle->setVisible(true);
+        ++reused;
+        return circle;
+    }
+
+    QCPItemEllipse* circle = new QCPItemEllipse(plot);
+    circle->setAntialiased(true);
+    circle->setPen(QPen(QColor(120, 120, 120), 2));
+    ++created;
+    return circle;
+}
+
+QCPCurve* FigurePool::acquire_triangle(QCustomPlot* plot) {
+    if (!triangles.empty()) {
+        QCPCurve* triangle = triangles.back();
+        triangles.pop_back();
+        triangle->setVisible(true);
+        ++reused;
+        return triangle;
+    }
+
+    QCPCurve* triangle = new QCPCurve(plot->xAxis, plot->yAxis);
+    triangle->setPen(Qt::NoPen);
+    triangle->setBrush(QColor(10, 100, 50, 160));
+    triangle->setLayer("main");
+    ++created;
+    return triangle;
+}
+
+void FigurePool::release(QCPGraph* point) {
+    point->setVisible(false);
+    point->setName("");
+    points.push_back(point);
+}
+
+void FigurePool::release(QCPItemStraightLine* line) {
+    line->setVisible(false);
+    line->setObjectName("");
+    lines.push_back(line);
+}
+
+void FigurePool::release(QCPItemEllipse* circle) {
+    circle->setVisible(false);
+    circle->setObjectName("");
+    circles.push_back(circle);
+}
+
+void FigurePool::release(QCPCurve* triangle) {
+    triangle->setVisible(false);
+    triangle->setName("");
+    triangles.push_back(triangle);
+}
+
+unsigned int FigurePool::get_created() const {
+    return created;
+}
+
+unsigned int FigurePool::get_reused() const {
+    return reused;
+}
@@ -0,0 +1,50 @@
+/***************************************************************************
+This class, FigurePool, creates and recycles the figures (QCustomPlot
+plottables and items) that represent constructions on the plot. Figures
+are only requested when a construction first has to be seen, and are given
+back when it leaves the view or is removed, so that the number of figures
+follows what is visible rather than the size of the scene.
+****************************************************************************/
+
+#ifndef FIGUREPOOL_H_
+#define FIGUREPOOL_H_
+
+#include <vector>
+#include "qcustomplot.h"
+
+class FigurePool {
+
+public:
+    FigurePool(); /**< @brief Constructor */
+
+    //@{
+    /** @brief Takes the plot and returns a visible figure of the given kind, reused from the pool when possible. */
+    QCPGraph* acquire_point(QCustomPlot* plot);
+    QCPItemStraightLine* acquire_line(QCustomPlot* plot);
+    QCPItemEllipse* acquire_circle(QCustomPlot* plot);
+    QCPCurve* acquire_triangle(QCustomPlot* plot);
+    //@}
+    //@{
+    /** @brief Hides a figure and keeps it for reuse. */
+    void release(QCPGraph* point);
+    void release(QCPItemStraightLine* line);
+    void release(QCPItemEllipse* circle);
+    void release(QCPCurve* triangle);
+    //@}
+
+    unsigned int get_created() const; /**< @brief Returns the number of figures created so far. */
+    unsigned int get_reused() const; /**< @brief Returns the number of figures handed out again after being released. */
+
+    virtual ~FigurePool(); /**< @brief Removes the pooled figures from their plot. */
+
+private:
+    std::vector<QCPGraph*> points; /**< @brief Released point figures. */
+    std::vector<QCPItemStraightLine*> lines; /**< @brief Released line figures. */
+    std::vector<QCPItemEllipse*> circles; /**< @brief Released circle figures. */
+    std::vector<QCPCurve*> triangles; /**< @brief Released triangle figures. */
+
+    unsigned int created {0}; /**< @brief Number of figures created so far. */
+    unsigned int reused {0}; /**< @brief Number of figures handed out again. */
+};
+
+#endif /* FIGUREPOOL_H_ */
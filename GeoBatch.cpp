@@ -0,0 +1,816 @@
+/*
+ * GeoBatch.cpp
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "GeoBatch.h"
+#include "PointNode.h"
+#include "LineNode.h"
+#include "CircleNode.h"
+#include "TriangleCentersNode.h"
+#include "GeoPredicates.h"
+
+namespace {
+
+const double UNIT_ROUNDOFF = numeric_limits<double>::epsilon() / 2;
+const signed char AMBIGUOUS = 2;
+
+// Floating-point value of a predicate and the magnitude of its terms, computed in the order of GeoPredicates
+struct Bound {
+    double value, magnitude;
+};
+
+// Sign of the value as the filter of GeoPredicates decides it (depth being the depth of the expression), AMBIGUOUS if it cannot tell
+inline signed char filter(const Bound& bound, int depth, double tolerance) {
+    double error = 2 * (depth + 1) * UNIT_ROUNDOFF * bound.magnitude, threshold = tolerance * bound.magnitude;
+    double size = abs(bound.value);
+    signed char sign = (bound.value > 0) - (bound.value < 0);
+    signed char decided = (size > (threshold + error) * (1 + 4 * UNIT_ROUNDOFF)) ? sign : AMBIGUOUS;
+    return ((size + error) * (1 + 4 * UNIT_ROUNDOFF) <= threshold) ? 0 : decided;
+}
+
+// Sets sign to the decision of a predicate in every configuration: the filter on value(k) for all of them first,
+// then exact(k), the predicate itself, for the ones the filter cannot settle (only where the parents are well-defined)
+template <class Value, class Exact>
+void decide(unsigned int configurations, const unsigned char ok[], signed char sign[], int depth, double tolerance, Value value, Exact exact) {
+    #pragma omp simd
+    for (unsigned int k = 0; k < configurations; ++k)
+        sign[k] = filter(value(k), depth, tolerance);
+    for (unsigned int k = 0; k < configurations; ++k) {
+        if (sign[k] == AMBIGUOUS)
+            sign[k] = ok[k] ? exact(k) : 0;
+    }
+}
+
+// Expressions of the predicates (see GeoPredicates.cpp), with their depths
+const int ORIENTATION_DEPTH = 3, DISTANCE_DEPTH = 3, CROSSING_DEPTH = 2, LINE_CIRCLE_DEPTH = 5, POINT_CIRCLE_DEPTH = 4,
+    CIRCLE_CIRCLE_DEPTH = 4, COMPARE_SQUARES_DEPTH = 2, INCIRCLE_DEPTH = 6;
+
+inline Bound orientation(double ax, double ay, double bx, double by, double cx, double cy) {
+    return {(bx - ax) * (cy - ay) - (by - ay) * (cx - ax),
+            (abs(bx) + abs(ax)) * (abs(cy) + abs(ay)) + (abs(by) + abs(ay)) * (abs(cx) + abs(ax))};
+}
+
+inline Bound distance(double ax, double ay, double bx, double by) {
+    double delta_x = bx - ax, delta_y = by - ay;
+    double size_x = abs(bx) + abs(ax), size_y = abs(by) + abs(ay);
+    return {delta_x * delta_x + delta_y * delta_y, size_x * size_x + size_y * size_y};
+}
+
+inline Bound crossing(double a1, double b1, double a2, double b2) {
+    return {a1 * b2 - b1 * a2, abs(a1) * abs(b2) + abs(b1) * abs(a2)};
+}
+
+inline Bound line_circle(double a, double b, double c, double center_x, double center_y, double radius) {
+    double t = a * center_x + b * center_y + c, size = abs(a) * abs(center_x) + abs(b) * abs(center_y) + abs(c);
+    return {radius * radius - t * t, abs(radius) * abs(radius) + size * size};
+}
+
+inline Bound point_circle(double x, double y, double center_x, double center_y, double radius) {
+    Bound squared = distance(x, y, center_x, center_y);
+    return {squared.value - radius * radius, squared.magnitude + abs(radius) * abs(radius)};
+}
+
+inline Bound circle_circle_outer(double x1, double y1, double r1, double x2, double y2, double r2) {
+    Bound squared = distance(x1, y1, x2, y2);
+    double sum = r1 + r2, size = abs(r1) + abs(r2);
+    return {sum * sum - squared.value, size * size + squared.magnitude};
+}
+
+inline Bound circle_circle_inner(double x1, double y1, double r1, double x2, double y2, double r2) {
+    Bound squared = distance(x1, y1, x2, y2);
+    double difference = r1 - r2, size = abs(r1) + abs(r2);
+    return {squared.value - difference * difference, squared.magnitude + size * size};
+}
+
+inline Bound compare_squares(double a, double b) {
+    return {a * a - b * b, abs(a) * abs(a) + abs(b) * abs(b)};
+}
+
+inline Bound incircle(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy) {
+    double a_x = ax - dx, a_y = ay - dy, b_x = bx - dx, b_y = by - dy, c_x = cx - dx, c_y = cy - dy;
+    double size_ax = abs(ax) + abs(dx), size_ay = abs(ay) + abs(dy), size_bx = abs(bx) + abs(dx), size_by = abs(by) + abs(dy);
+    double size_cx = abs(cx) + abs(dx), size_cy = abs(cy) + abs(dy);
+    double a_lift = a_x * a_x + a_y * a_y, b_lift = b_x * b_x + b_y * b_y, c_lift = c_x * c_x + c_y * c_y;
+    double size_a = size_ax * size_ax + size_ay * size_ay, size_b = size_bx * size_bx + size_by * size_by;
+    double size_c = size_cx * size_cx + size_cy * size_cy;
+    return {a_lift * (b_x * c_y - c_x * b_y) + b_lift * (c_x * a_y - a_x * c_y) + c_lift * (a_x * b_y - b_x * a_y),
+            size_a * (size_bx * size_cy + size_cx * size_by) + size_b * (size_cx * size_ay + size_ax * size_cy)
+            + size_c * (size_ax * size_by + size_bx * size_ay)};
+}
+
+// Coincidence of two points given by columns, as GeoPredicates::coincident (0 if they coincide)
+void coincident(unsigned int configurations, const unsigned char ok[], signed char sign[],
+                const double* x1, const double* y1, const double* x2, const double* y2, double tolerance = GeoPredicates::TOLERANCE) {
+    decide(configurations, ok, sign, DISTANCE_DEPTH, tolerance * tolerance,
+           [&](unsigned int k) { return distance(x1[k], y1[k], x2[k], y2[k]); },
+           [&](unsigned int k) {
+               double a[2] = {x1[k], y1[k]}, b[2] = {x2[k], y2[k]};
+               return GeoPredicates::coincident(a, b, tolerance) ? 0 : 1;
+           });
+}
+
+}
+
+GeoBatch::GeoBatch(GeoComponents* geo_components): geo_components(geo_components) {}
+
+int GeoBatch::width(GeoKind kind) {
+    switch (kind) {
+    case GeoKind::POINT: return 2;
+    case GeoKind::LINE: return 3;
+    case GeoKind::CIRCLE: return 3;
+    case GeoKind::TRIANGLE: return 9;
+    case GeoKind::TRIANGLE_CENTER: return 2;
+    case GeoKind::SOLVER: return 8;
+    }
+    return 0;
+}
+
+bool GeoBatch::compile(const vector<unsigned int>& inputs) {
+    compiled = false;
+    if (geo_components->get_coordinates() == Coordinates::HOMOGENEOUS)
+        return false;
+
+    // The inputs must be free points, the only constructions without a structure
+    unsigned int size = geo_components->size();
+    vector<unsigned int> key;
+    vector<int> index(size, -1);
+    for (unsigned int i = 0; i < inputs.size(); ++i) {
+        if (inputs[i] >= size || geo_components->get_structure(inputs[i], &key))
+            return false;
+        index[inputs[i]] = i;
+    }
+
+    // In pid order, the parents are compiled first
+    this->inputs = inputs;
+    steps.assign(size, Step());
+    offsets.assign(size, 0);
+    columns = 0;
+    for (unsigned int pid = 0; pid < size; ++pid) {
+        Step& step = steps[pid];
+        geo_components->get_structure(pid, &key);
+        step.kind = static_cast<GeoKind>(key[0]);
+        step.type = key[1];
+        step.num_parents = key.size() - 2;
+        step.input = index[pid];
+        step.varying = (step.input >= 0);
+        for (int j = 0; j < step.num_parents; ++j) {
+            step.parents[j] = key[2 + j];
+            step.varying |= steps[step.parents[j]].varying;
+        }
+
+        // Current values, repeated if the construction does not vary, and the position of a free point
+        fill(step.constant, step.constant + GeoNode::DATA_SIZE, 0);
+        geo_components->access(pid, step.constant);
+        step.defined = geo_components->get_construction(pid)->get_well_defined();
+        step.hint[0] = step.constant[0];
+        step.hint[1] = step.constant[1];
+
+        offsets[pid] = columns;
+        columns += width(step.kind);
+    }
+
+    topology = geo_components->get_topology();
+    compiled = true;
+    return true;
+}
+
+bool GeoBatch::evaluate(unsigned int configurations, const double inputs[]) {
+    if (!compiled || geo_components->get_topology() != topology)
+        return false;
+
+    this->configurations = configurations;
+    words = (configurations + 63) / 64;
+    values.resize(static_cast<size_t>(columns) * configurations);
+    well_defined.assign(steps.size() * words, 0);
+    scratch.resize(10 * static_cast<size_t>(configurations));
+    ok.resize(configurations);
+    signs.resize(3 * static_cast<size_t>(configurations));
+    if (configurations == 0)
+        return true;
+
+    for (unsigned int pid = 0; pid < steps.size(); ++pid) {
+        const Step& step = steps[pid];
+        if (!step.varying) {
+            // Same values in every configuration
+            for (int c = 0; c < width(step.kind); ++c)
+                fill_n(column(pid, c), configurations, step.constant[c]);
+            fill(begin(ok), end(ok), step.defined);
+            scatter(pid, &ok[0]);
+            continue;
+        }
+
+        gather(pid, &ok[0]);
+        switch (step.kind) {
+        case GeoKind::POINT: point(pid, inputs, &ok[0]); break;
+        case GeoKind::LINE: line(pid, &ok[0]); break;
+        case GeoKind::CIRCLE: circle(pid, &ok[0]); break;
+        case GeoKind::TRIANGLE: triangle(pid, &ok[0]); break;
+        case GeoKind::TRIANGLE_CENTER: triangle_center(pid, &ok[0]); break;
+        case GeoKind::SOLVER: {
+            double* out[8];
+            for (int c = 0; c < 8; ++c)
+                out[c] = column(pid, c);
+            solve(static_cast<SolverType>(step.type), step.parents, out, &ok[0]);
+            break;
+        }
+        }
+        scatter(pid, &ok[0]);
+    }
+    return true;
+}
+
+unsigned int GeoBatch::get_configurations() const {
+    return configurations;
+}
+
+unsigned int GeoBatch::get_width(unsigned int pid) const {
+    return width(steps[pid].kind);
+}
+
+const double* GeoBatch::get_column(unsigned int pid, unsigned int component) const {
+    return &values[(offsets[pid] + component) * static_cast<size_t>(configurations)];
+}
+
+void GeoBatch::get_values(unsigned int pid, vector<double>* values) const {
+    unsigned int columns = get_width(pid);
+    values->resize(static_cast<size_t>(configurations) * columns);
+    for (unsigned int c = 0; c < columns; ++c) {
+        const double* values_c = get_column(pid, c);
+        for (unsigned int k = 0; k < configurations; ++k)
+            (*values)[static_cast<size_t>(k) * columns + c] = values_c[k];
+    }
+}
+
+const uint64_t* GeoBatch::get_well_defined(unsigned int pid) const {
+    return &well_defined[static_cast<size_t>(pid) * words];
+}
+
+bool GeoBatch::is_well_defined(unsigned int pid, unsigned int configuration) const {
+    return (get_well_defined(pid)[configuration / 64] >> (configuration % 64)) & 1;
+}
+
+unsigned int GeoBatch::count_well_defined(unsigned int pid) const {
+    const uint64_t* mask = get_well_defined(pid);
+    unsigned int count = 0;
+    for (unsigned int w = 0; w < words; ++w) {
+        for (uint64_t word = mask[w]; word != 0; word &= word - 1)
+            ++count;
+    }
+    return count;
+}
+
+void GeoBatch::decide_coincident(unsigned int a, unsigned int b, signed char sign[], double tolerance) {
+    const unsigned int points[2] = {a, b};
+    defined(points, 2, &ok[0]);
+    coincident(configurations, &ok[0], sign, get_column(a, 0), get_column(a, 1), get_column(b, 0), get_column(b, 1), tolerance);
+}
+
+void GeoBatch::decide_orientation(unsigned int a, unsigned int b, unsigned int c, signed char sign[], double tolerance) {
+    const unsigned int points[3] = {a, b, c};
+    defined(points, 3, &ok[0]);
+    const double *x1 = get_column(a, 0), *y1 = get_column(a, 1), *x2 = get_column(b, 0), *y2 = get_column(b, 1);
+    const double *x3 = get_column(c, 0), *y3 = get_column(c, 1);
+    decide(configurations, &ok[0], sign, ORIENTATION_DEPTH, tolerance,
+           [&](unsigned int k) { return orientation(x1[k], y1[k], x2[k], y2[k], x3[k], y3[k]); },
+           [&](unsigned int k) {
+               double p1[2] = {x1[k], y1[k]}, p2[2] = {x2[k], y2[k]}, p3[2] = {x3[k], y3[k]};
+               return GeoPredicates::orientation(p1, p2, p3, tolerance);
+           });
+}
+
+void GeoBatch::decide_incircle(unsigned int a, unsigned int b, unsigned int c, unsigned int d, signed char sign[], double tolerance) {
+    const unsigned int points[4] = {a, b, c, d};
+    defined(points, 4, &ok[0]);
+    const double *x1 = get_column(a, 0), *y1 = get_column(a, 1), *x2 = get_column(b, 0), *y2 = get_column(b, 1);
+    const double *x3 = get_column(c, 0), *y3 = get_column(c, 1), *x4 = get_column(d, 0), *y4 = get_column(d, 1);
+    decide(configurations, &ok[0], sign, INCIRCLE_DEPTH, tolerance,
+           [&](unsigned int k) { return incircle(x1[k], y1[k], x2[k], y2[k], x3[k], y3[k], x4[k], y4[k]); },
+           [&](unsigned int k) {
+               double p1[2] = {x1[k], y1[k]}, p2[2] = {x2[k], y2[k]}, p3[2] = {x3[k], y3[k]}, p4[2] = {x4[k], y4[k]};
+               return GeoPredicates::incircle(p1, p2, p3, p4, tolerance);
+           });
+}
+
+double* GeoBatch::column(unsigned int pid, unsigned int component) {
+    return &values[(offsets[pid] + component) * static_cast<size_t>(configurations)];
+}
+
+void GeoBatch::gather(unsigned int pid, unsigned char ok[]) {
+    const Step& step = steps[pid];
+    defined(step.parents, step.num_parents, ok);
+}
+
+void GeoBatch::defined(const unsigned int pids[], int count, unsigned char ok[]) {
+    fill_n(ok, configurations, 1);
+    for (int j = 0; j < count; ++j) {
+        const uint64_t* mask = get_well_defined(pids[j]);
+        #pragma omp simd
+        for (unsigned int k = 0; k < configurations; ++k)
+            ok[k] &= (mask[k / 64] >> (k % 64)) & 1;
+    }
+}
+
+void GeoBatch::scatter(unsigned int pid, const unsigned char ok[]) {
+    uint64_t* mask = &well_defined[static_cast<size_t>(pid) * words];
+    for (unsigned int w = 0; w < words; ++w) {
+        unsigned int first = 64 * w, last = min(first + 64, configurations);
+        uint64_t word = 0;
+        #pragma omp simd reduction(|:word)
+        for (unsigned int k = first; k < last; ++k)
+            word |= static_cast<uint64_t>(ok[k] != 0) << (k - first);
+        mask[w] = word;
+    }
+}
+
+void GeoBatch::point(unsigned int pid, const double inputs[], unsigned char ok[]) {
+    const Step& step = steps[pid];
+    const unsigned int n = configurations;
+    double *x = column(pid, 0), *y = column(pid, 1);
+    signed char* sign = &signs[0];
+
+    // Position of a free point: its row of the inputs, or the same one in every configuration
+    double *hint_x = &scratch[8 * static_cast<size_t>(n)], *hint_y = &scratch[9 * static_cast<size_t>(n)];
+    PointType type = static_cast<PointType>(step.type);
+    if (type == PointType::INDEPENDENT || type == PointType::ON_LINE || type == PointType::ON_CIRCLE) {
+        if (step.input >= 0) {
+            size_t stride = 2 * this->inputs.size();
+            const double* row = inputs + 2 * step.input;
+            for (unsigned int k = 0; k < n; ++k) {
+                hint_x[k] = row[k * stride];
+                hint_y[k] = row[k * stride + 1];
+            }
+        } else {
+            fill_n(hint_x, n, step.hint[0]);
+            fill_n(hint_y, n, step.hint[1]);
+        }
+    }
+
+    switch (type) {
+    case PointType::INDEPENDENT:
+        copy(hint_x, hint_x + n, x);
+        copy(hint_y, hint_y + n, y);
+        break;
+
+    case PointType::ON_LINE: {
+        const double *a = column(step.parents[0], 0), *b = column(step.parents[0], 1), *c = column(step.parents[0], 2);
+        #pragma omp simd
+        for (unsigned int k = 0; k < n; ++k) {
+            double t = a[k] * hint_x[k] + b[k] * hint_y[k] + c[k];
+            x[k] = hint_x[k] - a[k] * t;
+            y[k] = hint_y[k] - b[k] * t;
+        }
+        break;
+    }
+
+    case PointType::ON_CIRCLE: {
+        const double *center_x = column(step.parents[0], 0), *center_y = column(step.parents[0], 1), *radius = column(step.parents[0], 2);
+        coincident(n, ok, sign, hint_x, hint_y, center_x, center_y);
+        #pragma omp simd
+        for (unsigned int k = 0; k < n; ++k) {
+            double delta_x = hint_x[k] - center_x[k], delta_y = hint_y[k] - center_y[k];
+            double current_radius = sqrt(delta_x * delta_x + delta_y * delta_y);
+            x[k] = center_x[k] + delta_x * radius[k] / current_radius;
+            y[k] = center_y[k] + delta_y * radius[k] / current_radius;
+            ok[k] &= (sign[k] != 0);
+        }
+        break;
+    }
+
+    case PointType::POINT_POINT_MIDPOINT: {
+        const double *x1 = column(step.parents[0], 0), *y1 = column(step.parents[0], 1);
+        const double *x2 = column(step.parents[1], 0), *y2 = column(step.parents[1], 1);
+        #pragma omp simd
+        for (unsigned int k = 0; k < n; ++k) {
+            x[k] = (x1[k] + x2[k]) / 2;
+            y[k] = (y1[k] + y2[k]) / 2;
+        }
+        break;
+    }
+
+    case PointType::LINE_LINE_INTERSECTION: {
+        const double *a1 = column(step.parents[0], 0), *b1 = column(step.parents[0], 1), *c1 = column(step.parents[0], 2);
+        const double *a2 = column(step.parents[1], 0), *b2 = column(step.parents[1], 1), *c2 = column(step.parents[1], 2);
+        decide(n, ok, sign, CROSSING_DEPTH, GeoPredicates::TOLERANCE,
+               [&](unsigned int k) { return crossing(a1[k], b1[k], a2[k], b2[k]); },
+               [&](unsigned int k) {
+                   double line1[3] = {a1[k], b1[k], c1[k]}, line2[3] = {a2[k], b2[k], c2[k]};
+                   return GeoPredicates::crossing(line1, line2);
+               });
+        #pragma omp simd
+        for (unsigned int k = 0; k < n; ++k) {
+            double delta = a1[k] * b2[k] - b1[k] * a2[k];
+            double delta_x = - c1[k] * b2[k] + b1[k] * c2[k];
+            double delta_y = - a1[k] * c2[k] + c1[k] * a2[k];
+            x[k] = delta_x / delta;
+            y[k] = delta_y / delta;
+            ok[k] &= (sign[k] != 0);
+        }
+        break;
+    }
+
+    case PointType::LINE_CIRCLE_FIRST_INTERSECTION:
+    case PointType::LINE_CIRCLE_SECOND_INTERSECTION:
+    case PointType::CIRCLE_CIRCLE_FIRST_INTERSECTION:
+    case PointType::CIRCLE_CIRCLE_SECOND_INTERSECTION: {
+        // Both roots solved into the scratch columns, as the single-root types do with the kernels of SolverNode
+        bool line_circle = (type == PointType::LINE_CIRCLE_FIRST_INTERSECTION || type == PointType::LINE_CIRCLE_SECOND_INTERSECTION);
+        bool first = (type == PointType::LINE_CIRCLE_FIRST_INTERSECTION || type == PointType::CIRCLE_CIRCLE_FIRST_INTERSECTION);
+        double* out[8];
+        for (int c = 0; c < 8; ++c)
+            out[c] = &scratch[c * static_cast<size_t>(n)];
+        solve(line_circle ? SolverType::LINE_CIRCLE_INTERSECTIONS : SolverType::CIRCLE_CIRCLE_INTERSECTIONS, step.parents, out, ok);
+        select(pid, out, first ? 0 : 1, ok);
+        break;
+    }
+
+    case PointType::FIRST_SOLUTION:
+    case PointType::SECOND_SOLUTION: {
+        double* out[8];
+        for (int c = 0; c < 8; ++c)
+            out[c] = column(step.parents[0], c);
+        select(pid, out, (type == PointType::FIRST_SOLUTION) ? 0 : 1, ok);
+        break;
+    }
+    }
+}
+
+void GeoBatch::line(unsigned int pid, unsigned char ok[]) {
+    const Step& step = steps[pid];
+    const unsigned int n = configurations;
+    double *a = column(pid, 0), *b = column(pid, 1), *c = column(pid, 2);
+    signed char* sign = &signs[0];
+
+    LineType type = static_cast<LineType>(step.type);
+    switch (type) {
+    case LineType::POINT_POINT_LINE_THROUGH:
+    case LineType::POINT_POINT_PERPENDICULAR_BISECTOR: {
+        const double *x1 = column(step.parents[0], 0), *y1 = column(step.parents[0], 1);
+        const double *x2 = column(step.parents[1], 0), *y2 = column(step.parents[1], 1);
+        coincident(n, ok, sign, x1, y1, x2, y2);
+        if (type == LineType::POINT_POINT_LINE_THROUGH) {
+            #pragma omp simd
+            for (unsigned int k = 0; k < n; ++k) {
+                a[k] = y1[k] - y2[k];
+                b[k] = x2[k] - x1[k];
+                c[k] = (-b[k])*y1[k] + (-a[k])*x1[k];
+                ok[k] &= (sign[k] != 0);
+            }
+        } else {
+            #pragma omp simd
+            for (unsigned int k = 0; k < n; ++k) {
+                a[k] = x2[k] - x1[k];
+                b[k] = y2[k] - y1[k];
+                c[k] = (-a[k])*(x1[k] + x2[k])/2 + (-b[k])*(y1[k] + y2[k])/2;
+                ok[k] &= (sign[k] != 0);
+            }
+        }
+        break;
+    }
+
+    case LineType::POINT_LINE_PARALLEL_LINE_THROUGH: {
+        const double *x = column(step.parents[0], 0), *y = column(step.parents[0], 1);
+        const double *a1 = column(step.parents[1], 0), *b1 = column(step.parents[1], 1);
+        #pragma omp simd
+        for (unsigned int k = 0; k < n; ++k) {
+            a[k] = a1[k];
+            b[k] = b1[k];
+            c[k] = (-b1[k])*y[k] + (-a1[k])*x[k];
+        }
+        break;
+    }
+
+    case LineType::POINT_CIRCLE_FIRST_TANGENT:
+    case LineType::POINT_CIRCLE_SECOND_TANGENT: {
+        double* out[8];
+        for (int c = 0; c < 8; ++c)
+            out[c] = &scratch[c * static_cast<size_t>(n)];
+        solve(SolverType::POINT_CIRCLE_TANGENTS, step.parents, out, ok);
+        select(pid, out, (type == LineType::POINT_CIRCLE_FIRST_TANGENT) ? 0 : 1, ok);
+        break;
+    }
+
+    case LineType::FIRST_SOLUTION:
+    case LineType::SECOND_SOLUTION: {
+        double* out[8];
+        for (int c = 0; c < 8; ++c)
+            out[c] = column(step.parents[0], c);
+        select(pid, out, (type == LineType::FIRST_SOLUTION) ? 0 : 1, ok);
+        break;
+    }
+    }
+
+    normalize(pid, ok);
+}
+
+void GeoBatch::normalize(unsigned int pid, unsigned char ok[]) {
+    double *a = column(pid, 0), *b = column(pid, 1), *c = column(pid, 2);
+    double tolerance = GeoPredicates::TOLERANCE;
+    #pragma omp simd
+    for (unsigned int k = 0; k < configurations; ++k) {
+        double norm = a[k] * a[k] + b[k] * b[k];
+        double inverse = 1 / sqrt(norm);
+        ok[k] &= !(norm == 0 || norm <= tolerance * tolerance * c[k] * c[k]);
+        a[k] *= inverse;
+        b[k] *= inverse;
+        c[k] *= inverse;
+    }
+}
+
+void GeoBatch::circle(unsigned int pid, unsigned char ok[]) {
+    const Step& step = steps[pid];
+    const unsigned int n = configurations;
+    double *center_x = column(pid, 0), *center_y = column(pid, 1), *radius = column(pid, 2);
+    signed char* sign = &signs[0];
+
+    const double *x1 = column(step.parents[0], 0), *y1 = column(step.parents[0], 1);
+    const double *x2 = column(step.parents[1], 0), *y2 = column(step.parents[1], 1);
+    switch (static_cast<CircleType>(step.type)) {
+    case CircleType::POINT_POINT_POINT_THROUGH: {
+        const double *x3 = column(step.parents[2], 0), *y3 = column(step.parents[2], 1);
+        decide(n, ok, sign, ORIENTATION_DEPTH, GeoPredicates::TOLERANCE,
+               [&](unsigned int k) { return orientation(x1[k], y1[k], x2[k], y2[k], x3[k], y3[k]); },
+               [&](unsigned int k) {
+                   double p1[2] = {x1[k], y1[k]}, p2[2] = {x2[k], y2[k]}, p3[2] = {x3[k], y3[k]};
+                   return GeoPredicates::orientation(p1, p2, p3);
+               });
+        #pragma omp simd
+        for (unsigned int k = 0; k < n; ++k) {
+            double x12 = x1[k] - x2[k], x13 = x1[k] - x3[k], x31 = x3[k] - x1[k], x21 = x2[k] - x1[k];
+            double y12 = y1[k] - y2[k], y13 = y1[k] - y3[k], y31 = y3[k] - y1[k], y21 = y2[k] - y1[k];
+
+            double sx13 = x1[k]*x1[k] - x3[k]*x3[k], sx21 = x2[k]*x2[k] - x1[k]*x1[k];
+            double sy13 = y1[k]*y1[k] - y3[k]*y3[k], sy21 = y2[k]*y2[k] - y1[k]*y1[k];
+
+            double y = (-1)*((sx13) * (x12) + (sy13) * (x12) + (sx21) * (x13) + (sy21) * (x13));
+            y /= (2 * ((y31) * (x12) - (y21) * (x13)));
+
+            double x = (-1)*((sx13) * (y12) + (sy13) * (y12)  + (sx21) * (y13) + (sy21) * (y13));
+            x /= (2 * ((x31) * (y12) - (x21) * (y13)));
+
+            center_x[k] = x;
+            center_y[k] = y;
+            radius[k] = sqrt((x - x1[k])*(x - x1[k]) + (y - y1[k])*(y - y1[k]));
+            ok[k] &= (sign[k] != 0);
+        }
+        break;
+    }
+
+    case CircleType::POINT_POINT_CENTER_THROUGH:
+    case CircleType::POINT_POINT_POINT_CENTER_RADIUS: {
+        // Center at the first point, radius from the first and second points or from the second and third ones
+        bool through = (static_cast<CircleType>(step.type) == CircleType::POINT_POINT_CENTER_THROUGH);
+        const double *from_x = through ? x1 : x2, *from_y = through ? y1 : y2;
+        const double *to_x = through ? x2 : column(step.parents[2], 0), *to_y = through ? y2 : column(step.parents[2], 1);
+        coincident(n, ok, sign, from_x, from_y, to_x, to_y);
+        #pragma omp simd
+        for (unsigned int k = 0; k < n; ++k) {
+            double delta_x = to_x[k] - from_x[k], delta_y = to_y[k] - from_y[k];
+            center_x[k] = x1[k];
+            center_y[k] = y1[k];
+            radius[k] = sqrt(delta_x*delta_x + delta_y*delta_y);
+            ok[k] &= (sign[k] != 0);
+        }
+        break;
+    }
+    }
+}
+
+void GeoBatch::triangle(unsigned int pid, unsigned char ok[]) {
+    const Step& step = steps[pid];
+    const unsigned int n = configurations;
+    const double *x1 = column(step.parents[0], 0), *y1 = column(step.parents[0], 1);
+    const double *x2 = column(step.parents[1], 0), *y2 = column(step.parents[1], 1);
+    const double *x3 = column(step.parents[2], 0), *y3 = column(step.parents[2], 1);
+
+    // The vertices, then the sides (see TriangleNode::access)
+    const double* vertices[6] = {x1, y1, x2, y2, x3, y3};
+    for (int c = 0; c < 6; ++c)
+        copy(vertices[c], vertices[c] + n, column(pid, c));
+
+    signed char *sign_a = &signs[0], *sign_b = &signs[n], *sign_c = &signs[2 * static_cast<size_t>(n)];
+    coincident(n, ok, sign_a, x2, y2, x3, y3);
+    coincident(n, ok, sign_b, x3, y3, x1, y1);
+    coincident(n, ok, sign_c, x1, y1, x2, y2);
+
+    double *side_a = column(pid, 6), *side_b = column(pid, 7), *side_c = column(pid, 8);
+    #pragma omp simd
+    for (unsigned int k = 0; k < n; ++k) {
+        side_a[k] = sqrt((x2[k] - x3[k]) * (x2[k] - x3[k]) + (y2[k] - y3[k]) * (y2[k] - y3[k]));
+        side_b[k] = sqrt((x3[k] - x1[k]) * (x3[k] - x1[k]) + (y3[k] - y1[k]) * (y3[k] - y1[k]));
+        side_c[k] = sqrt((x1[k] - x2[k]) * (x1[k] - x2[k]) + (y1[k] - y2[k]) * (y1[k] - y2[k]));
+        ok[k] &= (sign_a[k] != 0) & (sign_b[k] != 0) & (sign_c[k] != 0);
+    }
+}
+
+void GeoBatch::triangle_center(unsigned int pid, unsigned char[]) {
+    const Step& step = steps[pid];
+    const unsigned int n = configurations;
+    double *x = column(pid, 0), *y = column(pid, 1);
+    const double* triangle[9];
+    for (int c = 0; c < 9; ++c)
+        triangle[c] = column(step.parents[0], c);
+    const double *side_a = triangle[6], *side_b = triangle[7], *side_c = triangle[8];
+
+    // Barycentric coefficients (see TriangleCentersNode) in the scratch columns, then the Cartesian conversion
+    double *barycoeff_a = &scratch[0], *barycoeff_b = &scratch[n], *barycoeff_c = &scratch[2 * static_cast<size_t>(n)];
+    switch (static_cast<TriangleCentersType>(step.type)) {
+    case TriangleCentersType::CENTROID:
+        fill_n(barycoeff_a, n, 1);
+        fill_n(barycoeff_b, n, 1);
+        fill_n(barycoeff_c, n, 1);
+        break;
+
+    case TriangleCentersType::INCENTER:
+        copy(side_a, side_a + n, barycoeff_a);
+        copy(side_b, side_b + n, barycoeff_b);
+        copy(side_c, side_c + n, barycoeff_c);
+        break;
+
+    case TriangleCentersType::CIRCUMCENTER:
+        #pragma omp simd
+        for (unsigned int k = 0; k < n; ++k) {
+            double a = side_a[k], b = side_b[k], c = side_c[k];
+            barycoeff_a[k] = a*a * (b * b + c * c - a * a);
+            barycoeff_b[k] = b*b * (c * c + a * a - b * b);
+            barycoeff_c[k] = c*c * (a * a + b * b - c * c);
+        }
+        break;
+
+    case TriangleCentersType::ORTHOCENTER:
+        // A right angle at a vertex, relative to the size of the triangle, puts the center there (the later vertices being checked last)
+        #pragma omp simd
+        for (unsigned int k = 0; k < n; ++k) {
+            double sum = side_a[k] * side_a[k] + side_b[k] * side_b[k] + side_c[k] * side_c[k];
+            double coeff_a = sum - 2*side_a[k]*side_a[k], coeff_b = sum - 2*side_b[k]*side_b[k], coeff_c = sum - 2*side_c[k]*side_c[k];
+            bool right_a = abs(coeff_a) <= GeoPredicates::TOLERANCE * sum;
+            bool right_b = abs(coeff_b) <= GeoPredicates::TOLERANCE * sum;
+            bool right_c = abs(coeff_c) <= GeoPredicates::TOLERANCE * sum;
+            barycoeff_a[k] = right_c ? 0 : (right_b ? 0 : (right_a ? 1 : 1 / coeff_a));
+            barycoeff_b[k] = right_c ? 0 : (right_b ? 1 : 1 / coeff_b);
+            barycoeff_c[k] = right_c ? 1 : 1 / coeff_c;
+        }
+        break;
+
+    case TriangleCentersType::NINEPOINTCENTER:
+        #pragma omp simd
+        for (unsigned int k = 0; k < n; ++k) {
+            double a = side_a[k] * side_a[k], b = side_b[k] * side_b[k], c = side_c[k] * side_c[k];
+            barycoeff_a[k] = a * (b + c) - (b - c) * (b - c);
+            barycoeff_b[k] = b * (c + a) - (c - a) * (c - a);
+            barycoeff_c[k] = c * (a + b) - (a - b) * (a - b);
+        }
+        break;
+
+    case TriangleCentersType::LEMOINEPOINT:
+        #pragma omp simd
+        for (unsigned int k = 0; k < n; ++k) {
+            barycoeff_a[k] = side_a[k] * side_a[k];
+            barycoeff_b[k] = side_b[k] * side_b[k];
+            barycoeff_c[k] = side_c[k] * side_c[k];
+        }
+        break;
+    }
+
+    #pragma omp simd
+    for (unsigned int k = 0; k < n; ++k) {
+        double sum = barycoeff_a[k] + barycoeff_b[k] + barycoeff_c[k];
+        x[k] = barycoeff_a[k] * triangle[0][k] + barycoeff_b[k] * triangle[2][k] + barycoeff_c[k] * triangle[4][k];
+        x[k] /= sum;
+        y[k] = barycoeff_a[k] * triangle[1][k] + barycoeff_b[k] * triangle[3][k] + barycoeff_c[k] * triangle[5][k];
+        y[k] /= sum;
+    }
+}
+
+void GeoBatch::solve(SolverType type, const unsigned int parents[2], double* out[8], unsigned char ok[]) {
+    const unsigned int n = configurations;
+    double tolerance = GeoPredicates::TOLERANCE;
+    signed char *sign = &signs[0], *sign_outer = &signs[n], *sign_inner = &signs[2 * static_cast<size_t>(n)];
+
+    switch (type) {
+    case SolverType::LINE_CIRCLE_INTERSECTIONS: {
+        const double *a = column(parents[0], 0), *b = column(parents[0], 1), *c = column(parents[0], 2);
+        const double *center_x = column(parents[1], 0), *center_y = column(parents[1], 1), *radius = column(parents[1], 2);
+        decide(n, ok, sign, LINE_CIRCLE_DEPTH, tolerance,
+               [&](unsigned int k) { return line_circle(a[k], b[k], c[k], center_x[k], center_y[k], radius[k]); },
+               [&](unsigned int k) {
+                   double line[3] = {a[k], b[k], c[k]}, circle[3] = {center_x[k], center_y[k], radius[k]};
+                   return GeoPredicates::line_circle(line, circle);
+               });
+
+        // Shift along the direction (-b, a) of the line from the projection of the center, none at tangency
+        #pragma omp simd
+        for (unsigned int k = 0; k < n; ++k) {
+            double t = a[k] * center_x[k] + b[k] * center_y[k] + c[k];
+            double project_x = center_x[k] - a[k] * t;
+            double project_y = center_y[k] - b[k] * t;
+            double to_shift = (sign[k] > 0) ? sqrt(max(0.0, radius[k] * radius[k] - t * t)) : 0;
+
+            out[0][k] = project_x - to_shift * b[k];
+            out[1][k] = project_y + to_shift * a[k];
+            out[3][k] = project_x + to_shift * b[k];
+            out[4][k] = project_y - to_shift * a[k];
+            out[2][k] = out[5][k] = 0;
+            out[6][k] = ok[k] & (sign[k] >= 0);
+            out[7][k] = ok[k] & (sign[k] > 0);
+        }
+        break;
+    }
+
+    case SolverType::CIRCLE_CIRCLE_INTERSECTIONS: {
+        const double *x1 = column(parents[0], 0), *y1 = column(parents[0], 1), *r1 = column(parents[0], 2);
+        const double *x2 = column(parents[1], 0), *y2 = column(parents[1], 1), *r2 = column(parents[1], 2);
+        coincident(n, ok, sign, x1, y1, x2, y2);
+        decide(n, ok, sign_outer, CIRCLE_CIRCLE_DEPTH, tolerance,
+               [&](unsigned int k) { return circle_circle_outer(x1[k], y1[k], r1[k], x2[k], y2[k], r2[k]); },
+               [&](unsigned int k) {
+                   double circle1[3] = {x1[k], y1[k], r1[k]}, circle2[3] = {x2[k], y2[k], r2[k]};
+                   return GeoPredicates::circle_circle_outer(circle1, circle2);
+               });
+        decide(n, ok, sign_inner, CIRCLE_CIRCLE_DEPTH, tolerance,
+               [&](unsigned int k) { return circle_circle_inner(x1[k], y1[k], r1[k], x2[k], y2[k], r2[k]); },
+               [&](unsigned int k) {
+                   double circle1[3] = {x1[k], y1[k], r1[k]}, circle2[3] = {x2[k], y2[k], r2[k]};
+                   return GeoPredicates::circle_circle_inner(circle1, circle2);
+               });
+
+        // Foot of the common chord on the line of centers, then half of the chord on both sides
+        #pragma omp simd
+        for (unsigned int k = 0; k < n; ++k) {
+            double delta_x = x2[k] - x1[k], delta_y = y2[k] - y1[k];
+            double dist = sqrt(delta_x * delta_x + delta_y * delta_y);
+            double shift_horizontal = (dist * dist + r1[k] * r1[k] - r2[k] * r2[k]) / (2 * dist);
+            double shift_vertical = sqrt(max(0.0, r1[k] * r1[k] - shift_horizontal * shift_horizontal));
+
+            double foot_x = x1[k] + delta_x * shift_horizontal / dist;
+            double foot_y = y1[k] + delta_y * shift_horizontal / dist;
+
+            out[0][k] = foot_x + delta_y * shift_vertical / dist;
+            out[1][k] = foot_y - delta_x * shift_vertical / dist;
+            out[3][k] = foot_x - delta_y * shift_vertical / dist;
+            out[4][k] = foot_y + delta_x * shift_vertical / dist;
+            out[2][k] = out[5][k] = 0;
+            out[6][k] = out[7][k] = ok[k] & (sign[k] != 0) & (sign_outer[k] >= 0) & (sign_inner[k] >= 0);
+        }
+        break;
+    }
+
+    case SolverType::POINT_CIRCLE_TANGENTS: {
+        const double *point_x = column(parents[0], 0), *point_y = column(parents[0], 1);
+        const double *center_x = column(parents[1], 0), *center_y = column(parents[1], 1), *radius = column(parents[1], 2);
+        signed char* sign_vertical = sign_outer;
+        decide(n, ok, sign, POINT_CIRCLE_DEPTH, tolerance,
+               [&](unsigned int k) { return point_circle(point_x[k], point_y[k], center_x[k], center_y[k], radius[k]); },
+               [&](unsigned int k) {
+                   double point[2] = {point_x[k], point_y[k]}, circle[3] = {center_x[k], center_y[k], radius[k]};
+                   return GeoPredicates::point_circle(point, circle);
+               });
+        decide(n, ok, sign_vertical, COMPARE_SQUARES_DEPTH, tolerance,
+               [&](unsigned int k) { return compare_squares(center_x[k] - point_x[k], radius[k]); },
+               [&](unsigned int k) { return GeoPredicates::compare_squares(center_x[k] - point_x[k], radius[k]); });
+
+        #pragma omp simd
+        for (unsigned int k = 0; k < n; ++k) {
+            // Point on the circle: a single tangent, perpendicular to the radius
+            double normal_x = point_x[k] - center_x[k], normal_y = point_y[k] - center_y[k];
+
+            // Otherwise the lines (y-point_y)=k(x-point_x), the slopes being the roots of a quadratic
+            double delta_x = center_x[k] - point_x[k], delta_y = point_y[k] - center_y[k];
+            double sk_coeff = delta_x*delta_x - radius[k]*radius[k];
+            double k_coeff = 2*delta_x*delta_y;
+            double c = delta_y*delta_y - radius[k]*radius[k];
+            double root = sqrt(k_coeff*k_coeff - 4*sk_coeff*c);
+            double k1 = (-k_coeff + root)/(2*sk_coeff);
+            double k2 = (sign_vertical[k] == 0) ? -c/k_coeff : (-k_coeff - root)/(2*sk_coeff);
+
+            // Linear case: the first tangent is vertical
+            bool on = (sign[k] == 0), vertical = (sign_vertical[k] == 0);
+            out[0][k] = on ? normal_x : (vertical ? 1 : k1);
+            out[1][k] = on ? normal_y : (vertical ? 0 : -1);
+            out[2][k] = on ? (-normal_x)*point_x[k] + (-normal_y)*point_y[k] : (vertical ? -point_x[k] : -k1*point_x[k] + point_y[k]);
+            out[3][k] = k2;
+            out[4][k] = -1;
+            out[5][k] = -k2*point_x[k] + point_y[k];
+            out[6][k] = ok[k] & (sign[k] >= 0);
+            out[7][k] = ok[k] & (sign[k] > 0);
+        }
+        break;
+    }
+    }
+
+    #pragma omp simd
+    for (unsigned int k = 0; k < n; ++k)
+        ok[k] &= (out[6][k] != 0) | (out[7][k] != 0);
+}
+
+void GeoBatch::select(unsigned int pid, double* const out[8], int root, unsigned char ok[]) {
+    int columns = width(steps[pid].kind);
+    for (int c = 0; c < columns; ++c)
+        copy(out[3 * root + c], out[3 * root + c] + configurations, column(pid, c));
+    #pragma omp simd
+    for (unsigned int k = 0; k < configurations; ++k)
+        ok[k] &= (out[6 + root][k] != 0);
+}
@@ -0,0 +1,115 @@
+/***************************************************************************
+This class, GeoBatch, evaluates the constructions of a GeoComponents for
+many configurations of chosen free points at once (what-if analysis),
+leaving the constructions themselves untouched. The scene is compiled into
+one step per construction, in pid order; a batch of K configurations is
+then kept by columns, one array of K values for each component of each
+construction (as returned by access), so that every step runs its kernel
+over the K configurations in a single loop the compiler can vectorize.
+Whether each construction is well-defined in each configuration is kept as
+a bitmask. Degenerate cases are decided as GeoPredicates decides them: the
+floating-point filter runs over all the configurations, and only the
+configurations it cannot settle go through the predicate itself, so that
+each configuration gets the decisions of a propagation pass. Predicates
+can also be decided on the points of a batch (see GeoChecker).
+The constructions that depend on none of the free points given as inputs
+are not evaluated again, their current values are repeated. Batches are
+computed in double and in Cartesian coordinates.
+****************************************************************************/
+
+#ifndef GEOBATCH_H_
+#define GEOBATCH_H_
+
+#include <cstdint>
+#include <vector>
+#include "GeoComponents.h"
+#include "GeoPredicates.h"
+#include "SolverNode.h"
+
+class GeoBatch {
+
+public:
+    GeoBatch(GeoComponents* geo_components); /**< @brief Constructor, takes the (not owned) GeoComponents object. */
+
+    /** @brief Takes the pids of the free points (independent, on a line or on a circle) whose positions vary between configurations, and compiles the constructions.
+     *  Returns false (and compiles nothing) if one of them is not a free point, or if the constructions are in homogeneous coordinates. */
+    bool compile(const vector<unsigned int>& inputs);
+    /** @brief Takes a number of configurations and their inputs, a row-major matrix with one row per configuration and the (x, y) of each input in a row,
+     *  and evaluates every construction in every configuration (points on a line or circle are projected from their (x, y)).
+     *  Returns false (and evaluates nothing) if the constructions were added or removed since the compilation. */
+    bool evaluate(unsigned int configurations, const double inputs[]);
+
+    unsigned int get_configurations() const; /**< @brief Returns the number of configurations of the last batch evaluated. */
+    unsigned int get_width(unsigned int pid) const; /**< @brief Returns the number of values of the construction with the given pid (the size of its access). */
+    /** @brief Returns the values of one component of the construction with the given pid, one per configuration (meaningless where it is not well-defined). */
+    const double* get_column(unsigned int pid, unsigned int component) const;
+    /** @brief Sets values to the matrix of the construction with the given pid, one row per configuration and one column per component. */
+    void get_values(unsigned int pid, vector<double>* values) const;
+    /** @brief Returns the bitmask of the configurations in which the construction with the given pid is well-defined, configuration k being bit k % 64 of word k / 64. */
+    const uint64_t* get_well_defined(unsigned int pid) const;
+    bool is_well_defined(unsigned int pid, unsigned int configuration) const; /**< @brief Returns whether the construction with the given pid is well-defined in a configuration. */
+    unsigned int count_well_defined(unsigned int pid) const; /**< @brief Returns the number of configurations in which the construction with the given pid is well-defined. */
+
+    //@{
+    /** @brief Predicates on points of the last batch: take their pids and set sign to the decision of GeoPredicates in every configuration, with the given tolerance
+     *  (meaningless where one of the points is not well-defined). Coincidence sets 0 where the points coincide, 1 elsewhere. */
+    void decide_coincident(unsigned int a, unsigned int b, signed char sign[], double tolerance = GeoPredicates::TOLERANCE);
+    void decide_orientation(unsigned int a, unsigned int b, unsigned int c, signed char sign[], double tolerance = GeoPredicates::TOLERANCE);
+    void decide_incircle(unsigned int a, unsigned int b, unsigned int c, unsigned int d, signed char sign[], double tolerance = GeoPredicates::TOLERANCE);
+    //@}
+
+private:
+    /** @brief Compiled construction. */
+    struct Step {
+        GeoKind kind; //!< Kind of the construction.
+        unsigned int type; //!< Type of the construction, depending on its kind.
+        unsigned int parents[3]; //!< Pids of the parents, in the order of the definition.
+        int num_parents; //!< Number of parents.
+        int input; //!< Index of the construction among the inputs, -1 if it is not one.
+        bool varying; //!< Indicates whether the construction depends on an input.
+        double hint[2]; //!< Coordinates of a free point that is not an input, projected again on its line or circle.
+        double constant[GeoNode::DATA_SIZE]; //!< Values of a construction that does not vary.
+        bool defined; //!< Well-definedness of a construction that does not vary.
+    };
+    static int width(GeoKind kind); /**< @brief Returns the number of values of a construction of the given kind. */
+
+    double* column(unsigned int pid, unsigned int component); /**< @brief Returns the values of one component of the construction with the given pid. */
+    /** @brief Sets ok to whether every parent of the construction with the given pid is well-defined, one byte per configuration. */
+    void gather(unsigned int pid, unsigned char ok[]);
+    /** @brief Sets ok to whether every construction of the given pids is well-defined, one byte per configuration. */
+    void defined(const unsigned int pids[], int count, unsigned char ok[]);
+    /** @brief Packs ok (one byte per configuration) into the bitmask of the construction with the given pid. */
+    void scatter(unsigned int pid, const unsigned char ok[]);
+
+    //@{
+    /** @brief Kernels: evaluate the construction with the given pid in every configuration, and clear ok where it is not well-defined. */
+    void point(unsigned int pid, const double inputs[], unsigned char ok[]);
+    void line(unsigned int pid, unsigned char ok[]);
+    void circle(unsigned int pid, unsigned char ok[]);
+    void triangle(unsigned int pid, unsigned char ok[]);
+    void triangle_center(unsigned int pid, unsigned char ok[]);
+    //@}
+    /** @brief Solves both roots of a solver of the given type, from the columns of its parents into out (8 columns: the roots, then whether each one exists, as SolverNode::access). */
+    void solve(SolverType type, const unsigned int parents[2], double* out[8], unsigned char ok[]);
+    /** @brief Takes the roots solved into out and sets the columns of the construction with the given pid to the one with the given index, clearing ok where it does not exist. */
+    void select(unsigned int pid, double* const out[8], int root, unsigned char ok[]);
+    void normalize(unsigned int pid, unsigned char ok[]); /**< @brief Scales the coefficients of a line to a unit normal, clearing ok where the normal vanishes (see LineNode::normalize). */
+
+    GeoComponents* geo_components {nullptr}; /**< @brief Constructions compiled (not owned). */
+    unsigned long topology {0}; /**< @brief Topology of the constructions compiled. */
+    bool compiled {false}; /**< @brief Indicates whether the constructions were compiled. */
+    vector<unsigned int> inputs; /**< @brief Pids of the inputs. */
+    vector<Step> steps; /**< @brief Compiled constructions, indexed by pid. */
+    vector<unsigned int> offsets; /**< @brief Index of the first column of each construction, indexed by pid. */
+    unsigned int columns {0}; /**< @brief Number of columns of all the constructions. */
+
+    unsigned int configurations {0}; /**< @brief Number of configurations of the last batch. */
+    unsigned int words {0}; /**< @brief Number of 64-bit words of a bitmask. */
+    vector<double> values; /**< @brief Columns of all the constructions, column c of pid starting at (offsets[pid] + c) * configurations. */
+    vector<uint64_t> well_defined; /**< @brief Bitmasks of all the constructions, words per pid. */
+    vector<double> scratch; /**< @brief Columns for the roots of the single-root types, and for the projected coordinates of free points. */
+    vector<unsigned char> ok; /**< @brief Well-definedness of the current step, one byte per configuration. */
+    vector<signed char> signs; /**< @brief Signs decided by the predicates of the current step, one byte per configuration and predicate. */
+};
+
+#endif /* GEOBATCH_H_ */
@@ -0,0 +1,292 @@
+/*
+ * GeoBench.cpp
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include "GeoBench.h"
+#include "GeoBatch.h"
+#include "GeoDescriptor.h"
+#include "PointNode.h"
+#include "LineNode.h"
+#include "CircleNode.h"
+#include "GeoPredicates.h"
+
+const unsigned int GeoBench::BATCH_CONFIGURATIONS;
+
+GeoBench::GeoBench(unsigned int size, unsigned int passes): size(size), passes(passes) {}
+
+vector<string> GeoBench::names() {
+    return {"line-circle", "line-line", "line-line-homogeneous", "tangency"};
+}
+
+GeoBench::Scene GeoBench::scene(const string& name) {
+    if (name == "line-circle")
+        return &GeoBench::line_circle;
+    if (name == "line-line")
+        return &GeoBench::line_line;
+    if (name == "line-line-homogeneous")
+        return &GeoBench::line_line_homogeneous;
+    if (name == "tangency")
+        return &GeoBench::tangency;
+    return nullptr;
+}
+
+bool GeoBench::run(const string& name, ostream& out) {
+    vector<string> selected = (name == "all") ? names() : vector<string>(1, name);
+    for (auto it = begin(selected); it != end(selected); ++it) {
+        Scene build = scene(*it);
+        if (build == nullptr)
+            return false;
+
+        // The scene in each precision, then the precisions against double-double
+        const Precision precisions[3] = {Precision::SINGLE, Precision::DOUBLE, Precision::DOUBLE_DOUBLE};
+        for (int p = 0; p < 3; ++p) {
+            GeoComponents geo;
+            vector<unsigned int> moved;
+            (this->*build)(&geo, &moved);
+            geo.set_precision(precisions[p]);
+            measure(*it + " (" + precision_name(precisions[p]) + ")", &geo, moved, out);
+        }
+        compare(*it, build, out);
+        batch(*it, build, out);
+    }
+    return true;
+}
+
+void GeoBench::line_circle(GeoComponents* geo, vector<unsigned int>* moved) {
+    const unsigned int circles = 8;
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> coordinate(-50, 50);
+
+    vector<GeoDescriptor> batch;
+    for (unsigned int k = 0; k < circles; ++k) {
+        string i = to_string(k);
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::INDEPENDENT), "O" + i, {}, coordinate(random) / 5, coordinate(random) / 5));
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::INDEPENDENT), "R" + i, {}, 40 + k, 0));
+        batch.push_back(GeoDescriptor(GeoKind::CIRCLE, static_cast<int>(CircleType::POINT_POINT_CENTER_THROUGH), "C" + i, {"O" + i, "R" + i}));
+    }
+    for (unsigned int k = 0; k < size; ++k) {
+        string i = to_string(k), circle = "C" + to_string(k % circles);
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::INDEPENDENT), "A" + i, {}, coordinate(random) / 5, coordinate(random) / 5));
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::INDEPENDENT), "B" + i, {}, coordinate(random), coordinate(random)));
+        batch.push_back(GeoDescriptor(GeoKind::LINE, static_cast<int>(LineType::POINT_POINT_LINE_THROUGH), "L" + i, {"A" + i, "B" + i}));
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::LINE_CIRCLE_FIRST_INTERSECTION), "P" + i, {"L" + i, circle}));
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::LINE_CIRCLE_SECOND_INTERSECTION), "Q" + i, {"L" + i, circle}));
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::ON_LINE), "M" + i, {"L" + i}, coordinate(random), coordinate(random)));
+    }
+    geo->add_constructions(batch);
+
+    moved->clear();
+    for (unsigned int k = 0; k < size; ++k)
+        moved->push_back(geo->get_pid("A" + to_string(k)));
+}
+
+void GeoBench::line_line(GeoComponents* geo, vector<unsigned int>* moved) {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> coordinate(-50, 50);
+
+    vector<GeoDescriptor> batch;
+    for (unsigned int k = 0; k < size; ++k) {
+        string i = to_string(k), previous = "L" + to_string(k - 1);
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::INDEPENDENT), "A" + i, {}, coordinate(random), coordinate(random)));
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::INDEPENDENT), "B" + i, {}, coordinate(random), coordinate(random)));
+        batch.push_back(GeoDescriptor(GeoKind::LINE, static_cast<int>(LineType::POINT_POINT_LINE_THROUGH), "L" + i, {"A" + i, "B" + i}));
+        if (k == 0)
+            continue;
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::LINE_LINE_INTERSECTION), "X" + i, {"L" + i, previous}));
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::POINT_POINT_MIDPOINT), "M" + i, {"X" + i, "B" + i}));
+        batch.push_back(GeoDescriptor(GeoKind::LINE, static_cast<int>(LineType::POINT_LINE_PARALLEL_LINE_THROUGH), "K" + i, {"M" + i, previous}));
+        batch.push_back(GeoDescriptor(GeoKind::LINE, static_cast<int>(LineType::POINT_POINT_PERPENDICULAR_BISECTOR), "N" + i, {"X" + i, "A" + i}));
+    }
+    geo->add_constructions(batch);
+
+    moved->clear();
+    for (unsigned int k = 0; k < size; ++k)
+        moved->push_back(geo->get_pid("A" + to_string(k)));
+}
+
+void GeoBench::line_line_homogeneous(GeoComponents* geo, vector<unsigned int>* moved) {
+    geo->set_coordinates(Coordinates::HOMOGENEOUS);
+    line_line(geo, moved);
+}
+
+void GeoBench::tangency(GeoComponents* geo, vector<unsigned int>* moved) {
+    const unsigned int circles = 8;
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> coordinate(-50, 50);
+
+    vector<GeoDescriptor> batch;
+    for (unsigned int k = 0; k < circles; ++k) {
+        string i = to_string(k);
+        double x = coordinate(random) / 5, y = coordinate(random) / 5;
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::INDEPENDENT), "O" + i, {}, x, y));
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::INDEPENDENT), "R" + i, {}, x + 1 + k / 4.0, y));
+        batch.push_back(GeoDescriptor(GeoKind::CIRCLE, static_cast<int>(CircleType::POINT_POINT_CENTER_THROUGH), "C" + i, {"O" + i, "R" + i}));
+    }
+    for (unsigned int k = 0; k < size; ++k) {
+        // Outside of every circle, so that the tangents exist when they are added
+        string i = to_string(k), circle = "C" + to_string(k % circles);
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::INDEPENDENT), "A" + i, {}, 30 + coordinate(random) / 5, coordinate(random)));
+        batch.push_back(GeoDescriptor(GeoKind::LINE, static_cast<int>(LineType::POINT_CIRCLE_FIRST_TANGENT), "T" + i, {"A" + i, circle}));
+        batch.push_back(GeoDescriptor(GeoKind::LINE, static_cast<int>(LineType::POINT_CIRCLE_SECOND_TANGENT), "U" + i, {"A" + i, circle}));
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::LINE_CIRCLE_FIRST_INTERSECTION), "P" + i, {"T" + i, circle}));
+        batch.push_back(GeoDescriptor(GeoKind::POINT, static_cast<int>(PointType::LINE_CIRCLE_FIRST_INTERSECTION), "Q" + i, {"U" + i, circle}));
+    }
+    geo->add_constructions(batch);
+
+    moved->clear();
+    for (unsigned int k = 0; k < size; ++k)
+        moved->push_back(geo->get_pid("A" + to_string(k)));
+}
+
+string GeoBench::precision_name(Precision precision) {
+    switch (precision) {
+    case Precision::SINGLE: return "single";
+    case Precision::DOUBLE: return "double";
+    case Precision::DOUBLE_DOUBLE: return "double-double";
+    }
+    return "";
+}
+
+void GeoBench::compare(const string& name, Scene build, ostream& out) {
+    // Same scene and same drags in the three precisions, double-double being the reference
+    const Precision precisions[3] = {Precision::SINGLE, Precision::DOUBLE, Precision::DOUBLE_DOUBLE};
+    GeoComponents geo[3];
+    vector<unsigned int> moved;
+    for (int p = 0; p < 3; ++p) {
+        (this->*build)(&geo[p], &moved);
+        geo[p].set_precision(precisions[p]);
+    }
+
+    std::mt19937 random(3);
+    std::uniform_real_distribution<double> coordinate(-10, 10);
+    vector<double> data(2 * moved.size());
+    double max_error[2] = {0, 0}, sum_error[2] = {0, 0};
+    unsigned long long compared = 0, mismatched[2] = {0, 0};
+    unsigned int compared_passes = min(passes, 10u);
+
+    for (unsigned int pass = 0; pass < compared_passes; ++pass) {
+        for (auto it = begin(data); it != end(data); ++it)
+            *it = coordinate(random);
+        for (int p = 0; p < 3; ++p)
+            geo[p].edit_constructions(moved, &data[0]);
+
+        for (unsigned int pid = 0; pid < geo[2].size(); ++pid) {
+            double reference[GeoNode::DATA_SIZE] = {0}, value[GeoNode::DATA_SIZE];
+            bool defined = geo[2].get_construction(pid)->get_well_defined();
+            geo[2].access(pid, reference);
+            ++compared;
+
+            for (int p = 0; p < 2; ++p) {
+                if (geo[p].get_construction(pid)->get_well_defined() != defined) {
+                    ++mismatched[p];
+                    continue;
+                }
+                if (!defined)
+                    continue;
+
+                // Error relative to the value, or absolute below 1 (the scenes span about 100 units)
+                fill(value, value + GeoNode::DATA_SIZE, 0);
+                geo[p].access(pid, value);
+                double error = 0;
+                for (int i = 0; i < GeoNode::DATA_SIZE; ++i) {
+                    if (std::isfinite(reference[i]))
+                        error = max(error, abs(value[i] - reference[i]) / max(1.0, abs(reference[i])));
+                }
+                max_error[p] = max(max_error[p], error);
+                sum_error[p] += error;
+            }
+        }
+    }
+
+    for (int p = 0; p < 2; ++p) {
+        out << name << " (" << precision_name(precisions[p]) << " against double-double): " << compared << " values, max error "
+            << max_error[p] << ", mean error " << ((compared != 0) ? sum_error[p] / compared : 0) << ", "
+            << mismatched[p] << " defined differently" << endl;
+    }
+}
+
+void GeoBench::batch(const string& name, Scene build, ostream& out) {
+    GeoComponents geo;
+    vector<unsigned int> moved;
+    (this->*build)(&geo, &moved);
+    GeoBatch batch(&geo);
+    if (!batch.compile(moved)) {
+        out << name << " (batch): not compiled, batches are in Cartesian coordinates" << endl;
+        return;
+    }
+
+    // The drags of measure, one configuration per pass
+    std::mt19937 random(2);
+    std::uniform_real_distribution<double> coordinate(-10, 10);
+    size_t stride = 2 * moved.size();
+    vector<double> data(stride * passes);
+    for (auto it = begin(data); it != end(data); ++it)
+        *it = coordinate(random);
+
+    double elapsed = 0;
+    unsigned int first = 0, configurations = 0;
+    for (; first < passes; first += configurations) {
+        configurations = min(BATCH_CONFIGURATIONS, passes - first);
+        auto start = std::chrono::steady_clock::now();
+        batch.evaluate(configurations, &data[first * stride]);
+        elapsed += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    first -= configurations;
+
+    // The first configurations of the last batch against a pass each, from the scene as built
+    double max_difference = 0;
+    unsigned long long mismatched = 0;
+    for (unsigned int k = 0; k < min(configurations, 3u); ++k) {
+        GeoComponents reference;
+        (this->*build)(&reference, &moved);
+        reference.edit_constructions(moved, &data[(first + k) * stride]);
+        for (unsigned int pid = 0; pid < reference.size(); ++pid) {
+            bool defined = reference.get_construction(pid)->get_well_defined();
+            if (defined != batch.is_well_defined(pid, k)) {
+                ++mismatched;
+                continue;
+            }
+            if (!defined || reference.get_construction(pid)->is_solver())
+                continue;
+
+            double value[GeoNode::DATA_SIZE];
+            reference.access(pid, value);
+            for (unsigned int i = 0; i < batch.get_width(pid); ++i)
+                max_difference = max(max_difference, abs(batch.get_column(pid, i)[k] - value[i]));
+        }
+    }
+
+    out << name << " (batch): " << geo.size() << " constructions, " << passes << " configurations in batches of " << BATCH_CONFIGURATIONS
+        << ", " << ((passes != 0) ? elapsed / passes : 0) << " ms per configuration, " << mismatched
+        << " defined differently from passes, max difference " << max_difference << endl;
+}
+
+void GeoBench::measure(const string& name, GeoComponents* geo, const vector<unsigned int>& moved, ostream& out) {
+    std::mt19937 random(2);
+    std::uniform_real_distribution<double> coordinate(-10, 10);
+    vector<double> data(2 * moved.size());
+
+    double elapsed = 0;
+    unsigned long long evaluations = geo->get_evaluations();
+    unsigned long long predicates = GeoPredicates::get_evaluations(), escalations = GeoPredicates::get_escalations();
+    for (unsigned int pass = 0; pass < passes; ++pass) {
+        for (auto it = begin(data); it != end(data); ++it)
+            *it = coordinate(random);
+
+        auto start = std::chrono::steady_clock::now();
+        geo->edit_constructions(moved, &data[0]);
+        elapsed += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    evaluations = geo->get_evaluations() - evaluations;
+    predicates = GeoPredicates::get_evaluations() - predicates;
+    escalations = GeoPredicates::get_escalations() - escalations;
+
+    out << name << ": " << geo->size() << " constructions, " << passes << " passes, " << elapsed / passes << " ms per pass, "
+        << ((evaluations != 0) ? 1e6 * elapsed / evaluations : 0) << " ns per evaluation, " << predicates << " predicates ("
+        << ((predicates != 0) ? 100.0 * escalations / predicates : 0) << "% escalated)" << endl;
+}
@@ -0,0 +1,63 @@
+/***************************************************************************
+This class, GeoBench, measures the propagation passes of GeoComponents on
+synthetic scenes, without the user interface. Each benchmark builds its
+scene from descriptors, then drags a set of independent points to random
+positions for a number of passes and reports the mean time of a pass and
+of a single evaluation, with the share of predicates escalated to exact
+arithmetic (see GeoPredicates). Every benchmark is measured in the three
+precisions (see GeoScalar.h), then the values in float and in double are
+compared with those in double-double after the same drags. Finally the
+drags are evaluated as batches of configurations (see GeoBatch), checked
+against propagation passes.
+****************************************************************************/
+
+#ifndef GEOBENCH_H_
+#define GEOBENCH_H_
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "GeoComponents.h"
+
+class GeoBench {
+
+public:
+    /** @brief Constructor, takes the size of the scenes (in units depending on the benchmark) and the number of passes measured. */
+    GeoBench(unsigned int size = 10000, unsigned int passes = 100);
+
+    /** @brief Takes the name of a benchmark ("all" for every one), runs it and writes one line per measure to out. Returns false if there is none by that name. */
+    bool run(const string& name, ostream& out);
+    static vector<string> names(); /**< @brief Returns the names of the benchmarks. */
+
+private:
+    /** @brief Function pointer building the scene of a benchmark, and setting moved to the pids of the points dragged. */
+    typedef void (GeoBench::*Scene)(GeoComponents* geo, vector<unsigned int>* moved);
+    /** @brief Takes a name and returns its scene, nullptr if unknown. */
+    static Scene scene(const string& name);
+
+    /** @brief Line-circle intersections: size lines through dragged points, each cut by one of a few circles (both roots) and holding a point. */
+    void line_circle(GeoComponents* geo, vector<unsigned int>* moved);
+    /** @brief Joins and meets: a chain of size lines through dragged points, each met by the next, with midpoints, parallels and bisectors on the meets. */
+    void line_line(GeoComponents* geo, vector<unsigned int>* moved);
+    /** @brief The line_line scene in homogeneous coordinates. */
+    void line_line_homogeneous(GeoComponents* geo, vector<unsigned int>* moved);
+
+    /** @brief Tangency: both tangents from size dragged points to one of a few circles, and the points where they touch it (tangent predicates). */
+    void tangency(GeoComponents* geo, vector<unsigned int>* moved);
+
+    /** @brief Takes the scene of a benchmark, drags it in the three precisions and writes the errors of single and double against double-double to out. */
+    void compare(const string& name, Scene build, ostream& out);
+    static string precision_name(Precision precision); /**< @brief Returns the name of a precision, as written by the script command. */
+    /** @brief Takes the scene of a benchmark, evaluates the drags of measure as batches of configurations and writes the mean time per configuration to out,
+     *  with the differences against propagation passes from the same scene. */
+    void batch(const string& name, Scene build, ostream& out);
+    static const unsigned int BATCH_CONFIGURATIONS = 16; /**< @brief Number of configurations evaluated per batch. */
+
+    /** @brief Drags the moved points for the passes and writes the mean time per pass and per evaluation to out, labeled by name. */
+    void measure(const string& name, GeoComponents* geo, const vector<unsigned int>& moved, ostream& out);
+
+    unsigned int size {10000}; /**< @brief Size of the scenes. */
+    unsigned int passes {100}; /**< @brief Number of passes measured. */
+};
+
+#endif /* GEOBENCH_H_ */
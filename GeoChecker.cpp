@@ -0,0 +1,262 @@
+/*
+ * GeoChecker.cpp
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include "GeoChecker.h"
+#include "GeoScript.h"
+
+const double GeoChecker::TOLERANCE = 1e-8;
+const unsigned int GeoChecker::MAX_COUNTEREXAMPLES;
+const unsigned int GeoChecker::BATCH_CONFIGURATIONS;
+const unsigned char GeoChecker::DEGENERATE;
+const unsigned char GeoChecker::FAILED;
+
+string GeoConjecture::text() const {
+    string text = (incidence == Incidence::COLLINEAR) ? "collinear" : "concyclic";
+    for (auto it = begin(labels); it != end(labels); ++it)
+        text += ' ' + *it;
+    return text;
+}
+
+GeoChecker::GeoChecker(unsigned long long samples, unsigned int threads, double tolerance, unsigned int seed):
+    samples(samples), threads(max(threads, 1u)), tolerance(tolerance), seed(seed) {}
+
+bool GeoChecker::run(const string& text, ostream& out) {
+    error.clear();
+    conjectures.clear();
+    outcomes.clear();
+    rate = 0;
+
+    // Built once here to report the errors, then once per worker
+    Scene scene;
+    string message;
+    if (!build(text, &scene, &message))
+        return fail(message);
+    conjectures = scene.conjectures;
+
+    batches = (samples + BATCH_CONFIGURATIONS - 1) / BATCH_CONFIGURATIONS;
+    next.store(0);
+    unsigned int workers = static_cast<unsigned int>(min<unsigned long long>(threads, max(batches, 1ull)));
+    vector<vector<Outcome>> partial(workers);
+    auto start = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (unsigned int i = 0; i < workers; ++i)
+        pool.push_back(thread(&GeoChecker::work, this, cref(text), &partial[i]));
+    for (auto it = begin(pool); it != end(pool); ++it)
+        it->join();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    rate = (elapsed > 0) ? samples / elapsed : 0;
+
+    // The first counterexamples of each worker include the first ones overall
+    outcomes.assign(conjectures.size(), Outcome());
+    for (unsigned int c = 0; c < conjectures.size(); ++c) {
+        Outcome& outcome = outcomes[c];
+        for (auto it = begin(partial); it != end(partial); ++it) {
+            const Outcome& part = (*it)[c];
+            outcome.held += part.held;
+            outcome.failed += part.failed;
+            outcome.degenerate += part.degenerate;
+            outcome.counterexamples.insert(outcome.counterexamples.end(), part.counterexamples.begin(), part.counterexamples.end());
+        }
+        sort(outcome.counterexamples.begin(), outcome.counterexamples.end());
+        if (outcome.counterexamples.size() > MAX_COUNTEREXAMPLES)
+            outcome.counterexamples.resize(MAX_COUNTEREXAMPLES);
+    }
+
+    // One line per conjecture, then its counterexamples as the moves that reproduce them
+    vector<double> inputs;
+    streamsize precision = out.precision();
+    for (unsigned int c = 0; c < conjectures.size(); ++c) {
+        const Outcome& outcome = outcomes[c];
+        unsigned long long tested = outcome.held + outcome.failed;
+        out << conjectures[c].text() << ": " << samples << " samples, " << outcome.held << " hold ("
+            << ((tested > 0) ? 100.0 * outcome.held / tested : 0) << "% of those tested), " << outcome.failed << " fail, "
+            << outcome.degenerate << " degenerate" << endl;
+
+        for (auto it = begin(outcome.counterexamples); it != end(outcome.counterexamples); ++it) {
+            unsigned int row = *it % BATCH_CONFIGURATIONS, stride = 2 * scene.inputs.size();
+            place(scene.box, scene.inputs.size(), seed, *it / BATCH_CONFIGURATIONS, row + 1, &inputs);
+            out << "  sample " << *it << ":" << setprecision(17);
+            for (unsigned int i = 0; i < scene.inputs.size(); ++i)
+                out << ((i > 0) ? ", move " : " move ") << scene.geo.get_construction(scene.inputs[i])->get_label() << ' '
+                    << inputs[row * stride + 2 * i] << ' ' << inputs[row * stride + 2 * i + 1];
+            out << setprecision(precision) << endl;
+        }
+    }
+    out << samples << " samples of " << scene.inputs.size() << " free points in " << elapsed << " s on " << workers << " threads, "
+        << rate << " configurations per second" << endl;
+    return true;
+}
+
+bool GeoChecker::build(const string& text, Scene* scene, string* message) {
+    GeoScript script(&scene->geo);
+    if (!script.run(text)) {
+        *message = script.get_error();
+        return false;
+    }
+    scene->conjectures = script.get_conjectures();
+    if (scene->conjectures.empty()) {
+        *message = "no conjecture, see the check command";
+        return false;
+    }
+
+    GeoComponents& geo = scene->geo;
+    if (!free_points(&geo, &scene->inputs, scene->box)) {
+        *message = "no free point to place";
+        return false;
+    }
+
+    for (auto it = begin(scene->conjectures); it != end(scene->conjectures); ++it) {
+        vector<unsigned int> points;
+        for (auto label = begin(it->labels); label != end(it->labels); ++label) {
+            unsigned int pid = geo.get_pid(*label);
+            if (pid == static_cast<unsigned int>(-1)) {
+                *message = "unknown construction '" + *label + "'";
+                return false;
+            }
+            points.push_back(pid);
+        }
+        scene->points.push_back(points);
+    }
+
+    GeoBatch batch(&geo);
+    if (!batch.compile(scene->inputs)) {
+        *message = "samples are evaluated in Cartesian coordinates";
+        return false;
+    }
+    return true;
+}
+
+bool GeoChecker::free_points(GeoComponents* geo, vector<unsigned int>* inputs, double box[4]) {
+    // Free points are the constructions without a structure, those that are fixed stay in place
+    vector<unsigned int> key;
+    double data[GeoNode::DATA_SIZE];
+    double low[2] = {0, 0}, high[2] = {0, 0};
+    inputs->clear();
+    for (unsigned int pid = 0; pid < geo->size(); ++pid) {
+        if (geo->get_structure(pid, &key) || geo->is_frozen(pid))
+            continue;
+        geo->access(pid, data);
+        for (int j = 0; j < 2; ++j) {
+            low[j] = inputs->empty() ? data[j] : min(low[j], data[j]);
+            high[j] = inputs->empty() ? data[j] : max(high[j], data[j]);
+        }
+        inputs->push_back(pid);
+    }
+
+    // Placements around the free points, half their extent beyond on each side
+    double extent = max(max(high[0] - low[0], high[1] - low[1]), 1.0);
+    box[0] = low[0] - extent / 2;
+    box[1] = low[1] - extent / 2;
+    box[2] = high[0] - low[0] + extent;
+    box[3] = high[1] - low[1] + extent;
+    return !inputs->empty();
+}
+
+void GeoChecker::place(const double box[4], unsigned int inputs, unsigned int seed, unsigned long long index, unsigned int count, vector<double>* placements) {
+    seed_seq sequence {seed, static_cast<unsigned int>(index), static_cast<unsigned int>(index >> 32)};
+    mt19937 random(sequence);
+    uniform_real_distribution<double> x(box[0], box[0] + box[2]), y(box[1], box[1] + box[3]);
+
+    placements->resize(static_cast<size_t>(count) * 2 * inputs);
+    for (auto it = placements->begin(); it != placements->end(); it += 2) {
+        *it = x(random);
+        *(it + 1) = y(random);
+    }
+}
+
+void GeoChecker::work(const string& text, vector<Outcome>* outcomes) {
+    Scene scene;
+    string message;
+    outcomes->assign(conjectures.size(), Outcome());
+    if (!build(text, &scene, &message))
+        return;
+
+    GeoBatch batch(&scene.geo);
+    batch.compile(scene.inputs);
+    vector<double> inputs;
+    vector<signed char> sign(BATCH_CONFIGURATIONS);
+    vector<unsigned char> verdict(BATCH_CONFIGURATIONS);
+    for (unsigned long long index = next.fetch_add(1); index < batches; index = next.fetch_add(1)) {
+        unsigned long long first = index * BATCH_CONFIGURATIONS;
+        unsigned int count = static_cast<unsigned int>(min<unsigned long long>(BATCH_CONFIGURATIONS, samples - first));
+        place(scene.box, scene.inputs.size(), seed, index, count, &inputs);
+        batch.evaluate(count, &inputs[0]);
+        for (unsigned int c = 0; c < conjectures.size(); ++c)
+            test(&batch, conjectures[c].incidence, scene.points[c], first, &sign[0], &verdict[0], &(*outcomes)[c]);
+    }
+}
+
+void GeoChecker::decide(GeoBatch* batch, Incidence incidence, const vector<unsigned int>& points, double tolerance, signed char sign[],
+                        unsigned char verdict[]) {
+    const unsigned int n = batch->get_configurations();
+
+    // The samples where a point is not well-defined, or where the first points do not fix a line or a circle, cannot be tested
+    fill_n(verdict, n, 0);
+    for (auto it = begin(points); it != end(points); ++it) {
+        const uint64_t* mask = batch->get_well_defined(*it);
+        for (unsigned int k = 0; k < n; ++k)
+            verdict[k] |= ((mask[k / 64] >> (k % 64)) & 1) ? 0 : DEGENERATE;
+    }
+    unsigned int fixed = 2;
+    if (incidence == Incidence::COLLINEAR) {
+        batch->decide_coincident(points[0], points[1], sign, tolerance);
+    } else {
+        batch->decide_orientation(points[0], points[1], points[2], sign, tolerance);
+        fixed = 3;
+    }
+    for (unsigned int k = 0; k < n; ++k)
+        verdict[k] |= (sign[k] == 0) ? DEGENERATE : 0;
+
+    // Each further point must lie on them
+    for (unsigned int i = fixed; i < points.size(); ++i) {
+        if (incidence == Incidence::COLLINEAR)
+            batch->decide_orientation(points[0], points[1], points[i], sign, tolerance);
+        else
+            batch->decide_incircle(points[0], points[1], points[2], points[i], sign, tolerance);
+        for (unsigned int k = 0; k < n; ++k)
+            verdict[k] |= (sign[k] != 0) ? FAILED : 0;
+    }
+}
+
+void GeoChecker::test(GeoBatch* batch, Incidence incidence, const vector<unsigned int>& points, unsigned long long first, signed char sign[],
+                      unsigned char verdict[], Outcome* outcome) const {
+    decide(batch, incidence, points, tolerance, sign, verdict);
+    for (unsigned int k = 0; k < batch->get_configurations(); ++k) {
+        if (verdict[k] & DEGENERATE) {
+            ++outcome->degenerate;
+        } else if (verdict[k] & FAILED) {
+            ++outcome->failed;
+            if (outcome->counterexamples.size() < MAX_COUNTEREXAMPLES)
+                outcome->counterexamples.push_back(first + k);
+        } else {
+            ++outcome->held;
+        }
+    }
+}
+
+bool GeoChecker::fail(const string& message) {
+    error = message;
+    return false;
+}
+
+const string& GeoChecker::get_error() const {
+    return error;
+}
+
+const vector<GeoConjecture>& GeoChecker::get_conjectures() const {
+    return conjectures;
+}
+
+const vector<GeoChecker::Outcome>& GeoChecker::get_outcomes() const {
+    return outcomes;
+}
+
+double GeoChecker::get_rate() const {
+    return rate;
+}
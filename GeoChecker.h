@@ -0,0 +1,116 @@
+/***************************************************************************
+This class, GeoChecker, checks conjectures on a scene by Monte-Carlo
+sampling: the free points of the scene (the points that can be moved and
+are not fixed) are placed at random around their positions, the scene is
+evaluated in each placement and the conjecture is tested in each one.
+Conjectures are incidences of points (collinear, concyclic), declared in
+the script of the scene by check commands (see GeoScript). The samples are
+evaluated in batches (see GeoBatch) spread over worker threads, each of
+which builds its own copy of the scene. A placement in which a point of
+the conjecture is not well-defined, or in which it cannot be tested (the
+first two points of a collinearity coincide, the first three of a
+concyclicity are collinear), is counted as degenerate rather than as a
+counterexample. Each batch draws its placements from its own seed, so that
+the outcome does not depend on the number of threads, and the placement of
+a counterexample can be found again from its index.
+****************************************************************************/
+
+#ifndef GEOCHECKER_H_
+#define GEOCHECKER_H_
+
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GeoBatch.h"
+#include "GeoComponents.h"
+
+/** @brief Incidences that can be conjectured. */
+enum class Incidence {
+    COLLINEAR, //!< The points lie on a line (at least 3).
+    CONCYCLIC //!< The points lie on a circle (at least 4).
+};
+
+/** @brief Conjecture on labelled points. */
+struct GeoConjecture {
+    Incidence incidence; //!< Incidence conjectured.
+    vector<string> labels; //!< Labels of the points.
+
+    string text() const; /**< @brief Returns the conjecture as written by the check command, without the command. */
+};
+
+class GeoChecker {
+
+public:
+    /** @brief Outcome of a conjecture over the samples. */
+    struct Outcome {
+        unsigned long long held {0}; //!< Number of samples in which the conjecture holds.
+        unsigned long long failed {0}; //!< Number of samples in which the conjecture fails (counterexamples).
+        unsigned long long degenerate {0}; //!< Number of samples in which the conjecture cannot be tested.
+        vector<unsigned long long> counterexamples; //!< Indices of the first counterexamples, in increasing order.
+    };
+
+    /** @brief Constructor, takes the number of samples, the number of worker threads (at least 1), the relative tolerance of the incidences and the seed of the placements. */
+    GeoChecker(unsigned long long samples = 1000000, unsigned int threads = thread::hardware_concurrency(), double tolerance = TOLERANCE, unsigned int seed = 1);
+
+    /** @brief Takes the text of a script, builds its scene and checks its conjectures, writing one line per conjecture and its first counterexamples to out.
+     *  Returns false if the script fails, declares no conjecture or has no free point, or if the scene is in homogeneous coordinates (see get_error). */
+    bool run(const string& text, ostream& out);
+
+    const string& get_error() const; /**< @brief Returns the message of the last error. */
+    const vector<GeoConjecture>& get_conjectures() const; /**< @brief Returns the conjectures of the last run. */
+    const vector<Outcome>& get_outcomes() const; /**< @brief Returns the outcome of each conjecture of the last run. */
+    double get_rate() const; /**< @brief Returns the number of samples evaluated per second by the last run. */
+
+    /** @brief Takes a scene and sets inputs to its free points that are not fixed, and box to {min x, min y, width, height} of their placements,
+     *  around their current positions. Returns false if there is none. */
+    static bool free_points(GeoComponents* geo, vector<unsigned int>* inputs, double box[4]);
+    /** @brief Takes a box, the number of free points and a seed, and sets placements to the count placements of the batch with the given index,
+     *  one row of (x, y) per free point and per sample (row-major, as GeoBatch::evaluate). The first rows do not depend on count. */
+    static void place(const double box[4], unsigned int inputs, unsigned int seed, unsigned long long index, unsigned int count, vector<double>* placements);
+    /** @brief Takes an evaluated batch and the pids of the points of an incidence, and sets the verdict of each sample to a combination of DEGENERATE and FAILED
+     *  (0 if it holds), sign and verdict holding one byte per sample. */
+    static void decide(GeoBatch* batch, Incidence incidence, const vector<unsigned int>& points, double tolerance, signed char sign[], unsigned char verdict[]);
+    static const unsigned char DEGENERATE = 1; /**< @brief Verdict of a sample in which the incidence cannot be tested. */
+    static const unsigned char FAILED = 2; /**< @brief Verdict of a sample in which the incidence does not hold. */
+
+    static const double TOLERANCE; /**< @brief Default relative tolerance, looser than that of the constructions since the points tested come out of long computations. */
+    static const unsigned int MAX_COUNTEREXAMPLES = 5; /**< @brief Number of counterexamples kept per conjecture. */
+
+private:
+    /** @brief Scene built by a worker. */
+    struct Scene {
+        GeoComponents geo; //!< Constructions of the script.
+        vector<GeoConjecture> conjectures; //!< Conjectures of the script.
+        vector<unsigned int> inputs; //!< Pids of the free points.
+        double box[4]; //!< {min x, min y, width, height} of the placements.
+        vector<vector<unsigned int>> points; //!< Pids of the points of each conjecture.
+    };
+    /** @brief Takes the text of the script and builds the scene, returns false and sets message on error. */
+    static bool build(const string& text, Scene* scene, string* message);
+    /** @brief Worker thread: evaluates the batches claimed and tests the conjectures, setting outcomes. */
+    void work(const string& text, vector<Outcome>* outcomes);
+    /** @brief Takes an evaluated batch and the pids of the points of a conjecture, and adds the verdicts of its samples to outcome, first being the index
+     *  of its first sample (sign and verdict hold one byte per sample). */
+    void test(GeoBatch* batch, Incidence incidence, const vector<unsigned int>& points, unsigned long long first, signed char sign[],
+              unsigned char verdict[], Outcome* outcome) const;
+
+    bool fail(const string& message); /**< @brief Sets the error message and returns false. */
+
+    static const unsigned int BATCH_CONFIGURATIONS = 64; /**< @brief Number of samples evaluated per batch. */
+
+    unsigned long long samples {1000000}; /**< @brief Number of samples. */
+    unsigned int threads {1}; /**< @brief Number of worker threads. */
+    double tolerance {TOLERANCE}; /**< @brief Relative tolerance of the incidences. */
+    unsigned int seed {1}; /**< @brief Seed of the placements. */
+
+    unsigned long long batches {0}; /**< @brief Number of batches of the run. */
+    std::atomic<unsigned long long> next {0}; /**< @brief Index of the next batch to be claimed by a worker. */
+    vector<GeoConjecture> conjectures; /**< @brief Conjectures of the last run. */
+    vector<Outcome> outcomes; /**< @brief Outcomes of the last run. */
+    double rate {0}; /**< @brief Samples per second of the last run. */
+    string error {""}; /**< @brief Message of the last error. */
+};
+
+#endif /* GEOCHECKER_H_ */
@@ -3,8 +3,15 @@
  *
  */
 
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
 #include "GeoComponents.h"
 
+const char GeoComponents::CLEAN;
+const char GeoComponents::DIRTY;
+const char GeoComponents::COLLECTED;
+
 GeoComponents::GeoComponents() {}
 
 GeoComponents::~GeoComponents() {
@@ -14,51 +21,240 @@ GeoComponents::~GeoComponents() {
     }
 }
 
-void GeoComponents::add_construction(GeoNode* geo, string label) {
-    if (geo->well_defined) {
-        geo->pid = next_pid++;
-        geo->label = label;
-        geo_components.push_back(geo);
-    } else {
+unsigned int GeoComponents::add_construction(GeoNode* geo, string label) {
+
+    // A constructor given a type it does not take leaves no parents, and nothing to evaluate
+    if (geo->num_parents > 0 && geo->parents == nullptr) {
+        delete geo;
+        return static_cast<unsigned int>(-1);
+    }
+
+    // Pull mode: a construction built from dirty parents is evaluated again once they are up to date
+    bool stale = false;
+    for (int j = 0; j < geo->num_parents; ++j)
+        stale |= evaluate(geo->parents[j]->pid);
+    // Constructors evaluate in Cartesian coordinates and in double
+    bool projective = (coordinates == Coordinates::HOMOGENEOUS);
+    if (precision != Precision::DOUBLE)
+        geo->set_precision(precision);
+    if (stale || geo->projective != projective || precision != Precision::DOUBLE) {
+        geo->projective = projective;
+        geo->update();
+    }
+
+    if (!geo->well_defined) {
         delete geo;
+        return static_cast<unsigned int>(-1);
     }
+
+    // Hash-consing: a duplicate is merged into the existing construction, the label becomes an alias
+    bool structured = geo->structure(&key);
+    if (structured && merging) {
+        auto it = structure_index.find(key);
+        if (it != structure_index.end()) {
+            unsigned int pid = it->second;
+            delete geo;
+            // Only a registered alias counts, remove_alias takes it back
+            if (!label.empty() && label_index.emplace(label, pid).second) {
+                aliases.emplace(label, geo_components[pid]);
+                ++duplicates[pid];
+                ++merged;
+            }
+            return pid;
+        }
+    }
+
+    geo->pid = next_pid++;
+    geo->label = label;
+    geo_components.push_back(geo);
+    if (!label.empty())
+        label_index.emplace(label, geo->pid);
+    if (structured)
+        structure_index.emplace(key, geo->pid);
+    hidden.push_back(0);
+    released.push_back(0);
+    dirty.push_back(CLEAN);
+    duplicates.push_back(0);
+    free_parameters.push_back(!structured);
+    fixed.push_back(false);
+    frozen.push_back(foldable(geo->pid));
+    if (!frozen[geo->pid])
+        live.push_back(geo->pid);
+    boxes.resize(4 * geo_components.size());
+    update_box(geo->pid);
+    ++topology;
+    return geo->pid;
+}
+
+unsigned int GeoComponents::add_constructions(const vector<GeoDescriptor>& batch, vector<unsigned int>* pids) {
+    if (pids != nullptr)
+        pids->clear();
+
+    // Validation: labels of the batch are indexed once, references resolved against both indices, and the kinds of the parents checked
+    unordered_map<string, unsigned int> batch_index;
+    vector<GeoKind> parent_kinds;
+    vector<unsigned int> parent_key;
+    for (unsigned int k = 0; k < batch.size(); ++k) {
+        const GeoDescriptor& descriptor = batch[k];
+        parent_kinds.clear();
+        for (auto it = begin(descriptor.parents); it != end(descriptor.parents); ++it) {
+            unsigned int pid = it->handle;
+            GeoKind kind = GeoKind::POINT;
+            if (pid == GeoRef::NO_HANDLE) {
+                auto existing = label_index.find(it->label);
+                auto earlier = batch_index.find(it->label);
+                if (existing != label_index.end())
+                    pid = existing->second;
+                else if (earlier != batch_index.end())
+                    kind = batch[earlier->second].kind;
+                else
+                    return 0;
+            } else if (pid >= geo_components.size()) {
+                return 0;
+            }
+            if (pid != GeoRef::NO_HANDLE) {
+                geo_components[pid]->structure(&parent_key);
+                kind = static_cast<GeoKind>(parent_key[0]);
+            }
+            parent_kinds.push_back((kind == GeoKind::TRIANGLE_CENTER) ? GeoKind::POINT : kind);
+        }
+        if (!descriptor.accepts(parent_kinds))
+            return 0;
+        if (!descriptor.label.empty()) {
+            if (label_index.count(descriptor.label) != 0 || !batch_index.emplace(descriptor.label, k).second)
+                return 0;
+        }
+    }
+
+    // Creation, parents always precede their children so each construction is evaluated once
+    vector<unsigned int> batch_pids(batch.size());
+    GeoNode* parent_nodes[3];
+    unsigned int added = 0;
+    for (unsigned int k = 0; k < batch.size(); ++k) {
+        const GeoDescriptor& descriptor = batch[k];
+        if (descriptor.parents.size() > 3)
+            break;
+
+        for (unsigned int j = 0; j < descriptor.parents.size(); ++j) {
+            const GeoRef& ref = descriptor.parents[j];
+            unsigned int pid = ref.handle;
+            if (pid == GeoRef::NO_HANDLE) {
+                auto it = batch_index.find(ref.label);
+                pid = (it != batch_index.end()) ? batch_pids[it->second] : label_index.find(ref.label)->second;
+            }
+            parent_nodes[j] = geo_components[pid];
+        }
+
+        // One of two solutions: both are solved by a single solver node, shared with the other one, the construction only selects its own
+        unsigned int solver_pid = static_cast<unsigned int>(-1);
+        bool new_solver = false;
+        GeoNode* solver = descriptor.create_solver(parent_nodes);
+        if (solver != nullptr) {
+            unsigned int solvers = next_pid;
+            solver_pid = share(solver);
+            if (solver_pid == static_cast<unsigned int>(-1))
+                break;
+            new_solver = (next_pid != solvers);
+        }
+
+        GeoNode* geo = (solver != nullptr) ? descriptor.create_selector(geo_components[solver_pid]) : descriptor.create(parent_nodes);
+        if (geo == nullptr)
+            break;
+        // Ill-defined constructions are deleted by add_construction, their children cannot be built
+        unsigned int pid = add_construction(geo, descriptor.label);
+        if (pid == static_cast<unsigned int>(-1)) {
+            // A solver added for the construction alone goes with it
+            if (new_solver)
+                remove_construction(solver_pid);
+            break;
+        }
+        batch_pids[k] = pid;
+        if (pids != nullptr)
+            pids->push_back(pid);
+        ++added;
+    }
+
+    return added;
 }
 
 void GeoComponents::edit_construction(unsigned int pid, double data[]) {
+    edit_constructions(vector<unsigned int>(1, pid), data);
+}
 
-    // Record for dependences
-    bool* is_ancestor = new bool[next_pid];
+void GeoComponents::edit_constructions(const vector<unsigned int>& pids, double data[], unsigned int stride, vector<unsigned int>* touched) {
+    if (touched != nullptr)
+        touched->clear();
+    if (pids.empty())
+        return;
 
-    // Simultaneous loop through array and vector
-    unsigned int i = 0;
-    for (auto it = begin(geo_components); it != end(geo_components); ++it, ++i){
+    // Edits in pid order, so that an edited construction sees its parents already updated
+    vector<unsigned int> order(pids.size());
+    for (unsigned int k = 0; k < order.size(); ++k)
+        order[k] = k;
+    stable_sort(begin(order), end(order), [&pids](unsigned int a, unsigned int b) { return pids[a] < pids[b]; });
 
-        if (i < pid) {
-            is_ancestor[i] = false;
+    // Record for dependences, frozen constructions are never swept and stay false
+    bool* is_ancestor = new bool[next_pid]();
 
-        } else if (i == pid) {
+    // Single sweep from the first edited construction, over the constructions not frozen
+    auto next = begin(order);
+    for (auto live_it = lower_bound(begin(live), end(live), pids[order[0]]); live_it != end(live); ++live_it) {
+        unsigned int i = *live_it;
+        GeoNode* geo = geo_components[i];
+
+        // Edits of frozen (fixed) constructions are ignored, and so are those of constructions computed from their parents
+        while (next != end(order) && pids[*next] < i)
+            ++next;
+
+        if (next != end(order) && pids[*next] == i && free_parameters[i]) {
             is_ancestor[i] = true;
-            (*it)->mutate(data);
+            // Repeated pids: the last edit wins
+            while (next + 1 != end(order) && pids[*(next + 1)] == i)
+                ++next;
+            // Pull mode: mutate reads the parents, which have to be up to date
+            for (int j = 0; j < geo->num_parents; ++j)
+                evaluate(geo->parents[j]->pid);
+            if (dirty[i] != CLEAN) {
+                dirty[i] = CLEAN;
+                --dirty_count;
+            }
+            geo->mutate(&data[*next * stride]);
+            evaluated(i);
+            update_box(i);
+            ++next;
+            if (touched != nullptr)
+                touched->push_back(i);
 
         } else {
             is_ancestor[i] = false;
 
             // Check for dependence
-            int num = (*it)->num_parents;
-            for (int j = 0; j < num; ++j) {
-                if (is_ancestor[(*it)->parents[j]->pid]) {
+            for (int j = 0; j < geo->num_parents; ++j) {
+                if (is_ancestor[geo->parents[j]->pid]) {
                     is_ancestor[i] = true;
                     break;
                 }
             }
 
-            // Update if dependent
-            if (is_ancestor[i])
-                (*it)->update();
+            // Update if dependent, or only mark it dirty in pull mode
+            if (is_ancestor[i]) {
+                if (evaluation == Evaluation::PUSH) {
+                    geo->update();
+                    evaluated(i);
+                    update_box(i);
+                } else if (dirty[i] == CLEAN) {
+                    dirty[i] = DIRTY;
+                    ++dirty_count;
+                    first_dirty = min(first_dirty, i);
+                }
+                if (touched != nullptr)
+                    touched->push_back(i);
+            }
         }
     }
 
     delete [] is_ancestor;
+    ++sequence;
 }
 
 void GeoComponents::remove_construction(unsigned int pid) {
@@ -90,15 +286,47 @@ void GeoComponents::remove_construction(unsigned int pid) {
         }
     }
 
+    // Solvers left without any selector are removed too
+    vector<char> used(next_pid, false);
+    i = 0;
+    for (auto it = begin(geo_components); it != end(geo_components); ++it, ++i) {
+        if (!is_ancestor[i]) {
+            for (int j = 0; j < (*it)->num_parents; ++j)
+                used[(*it)->parents[j]->pid] = true;
+        }
+    }
+    for (i = 0; i < next_pid; ++i) {
+        if (!used[i] && geo_components[i]->is_solver())
+            is_ancestor[i] = true;
+    }
+
     // Reverse simultaneous loop through array and vector for deleting nodes
+    unordered_set<GeoNode*> deleted;
     i = next_pid - 1;
     for (auto it = geo_components.rbegin(); it != geo_components.rend(); ++it, --i) {
         if (is_ancestor[i]) {
+            deleted.insert(*it);
+            (*it)->release(&pool);
             delete (*it);
             geo_components.erase((it+1).base());
+            dirty_count -= (dirty[i] != CLEAN);
+            dirty.erase(begin(dirty) + i);
+            merged -= duplicates[i];
+            duplicates.erase(begin(duplicates) + i);
+            free_parameters.erase(begin(free_parameters) + i);
+            fixed.erase(begin(fixed) + i);
         }
     }
 
+    // Aliases of the deleted constructions go with them
+    for (auto it = begin(aliases); it != end(aliases);) {
+        if (deleted.count(it->second) != 0)
+            it = aliases.erase(it);
+        else
+            ++it;
+    }
+    first_dirty = 0;
+
     delete [] is_ancestor;
 
     // Simultaneous loop through array and vector for updating pid's
@@ -106,12 +334,305 @@ void GeoComponents::remove_construction(unsigned int pid) {
     for (auto it = begin(geo_components); it != end(geo_components); ++it, ++i)
         (*it)->pid = i;
     next_pid = geo_components.size();
+    index_labels();
+    index_structures();
+    hidden.assign(next_pid, 0);
+    released.assign(next_pid, 0);
+    boxes.resize(4 * next_pid);
+    for (i = 0; i < next_pid; ++i)
+        update_box(i);
+    fold();
+    ++topology;
 
 }
 
+bool GeoComponents::remove_alias(const string& label) {
+    auto it = aliases.find(label);
+    if (it == aliases.end())
+        return false;
+
+    unsigned int pid = it->second->pid;
+    aliases.erase(it);
+    label_index.erase(label);
+    --duplicates[pid];
+    --merged;
+
+    // The label may also have been given to another construction, shadowed so far
+    index_labels();
+    return true;
+}
+
 void GeoComponents::display_all_constructions(Ui::MainWindow *ui){
-    for (auto it = begin(geo_components); it != end(geo_components); ++it)
-        (*it)->display(ui);
+    double data[GeoNode::DATA_SIZE];
+    unsigned int i = 0;
+    for (auto it = begin(geo_components); it != end(geo_components); ++it, ++i) {
+        // Pull mode: only the constructions to be seen are evaluated
+        if (hidden[i] == 0)
+            evaluate(i);
+        (*it)->access(data);
+        display_node(ui, i, data, (*it)->well_defined);
+    }
+}
+
+void GeoComponents::display_node(Ui::MainWindow *ui, unsigned int pid, const double data[], bool defined){
+    // Hidden constructions give their figure back, and take one again once they are to be seen
+    if (hidden[pid] != 0) {
+        if (!released[pid]) {
+            geo_components[pid]->release(&pool);
+            released[pid] = true;
+        }
+        return;
+    }
+
+    geo_components[pid]->display(ui, &pool, data, defined);
+    released[pid] = false;
+}
+
+void GeoComponents::index_labels(){
+    label_index.clear();
+    for (auto it = begin(geo_components); it != end(geo_components); ++it){
+        if (!(*it)->label.empty())
+            label_index.emplace((*it)->label, (*it)->pid);
+    }
+    for (auto it = begin(aliases); it != end(aliases); ++it)
+        label_index.emplace(it->first, it->second->pid);
+}
+
+void GeoComponents::index_structures(){
+    structure_index.clear();
+    for (auto it = begin(geo_components); it != end(geo_components); ++it){
+        if ((*it)->structure(&key))
+            structure_index.emplace(key, (*it)->pid);
+    }
+}
+
+size_t GeoComponents::StructureHash::operator()(const vector<unsigned int>& key) const {
+    // FNV-1a over the values
+    size_t hash = 2166136261u;
+    for (auto it = begin(key); it != end(key); ++it) {
+        hash ^= *it;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void GeoComponents::evaluated(unsigned int pid){
+    ++evaluations;
+    saved_evaluations += duplicates[pid];
+}
+
+void GeoComponents::set_evaluation(Evaluation evaluation){
+    if (evaluation == Evaluation::PUSH)
+        evaluate_all();
+    this->evaluation = evaluation;
+}
+
+Evaluation GeoComponents::get_evaluation() const {
+    return evaluation;
+}
+
+void GeoComponents::set_coordinates(Coordinates coordinates){
+    if (coordinates == this->coordinates)
+        return;
+    this->coordinates = coordinates;
+
+    bool projective = (coordinates == Coordinates::HOMOGENEOUS);
+    for (unsigned int i = 0; i < next_pid; ++i)
+        geo_components[i]->projective = projective;
+    reevaluate_all();
+}
+
+Coordinates GeoComponents::get_coordinates() const {
+    return coordinates;
+}
+
+void GeoComponents::set_precision(Precision precision){
+    if (precision == this->precision)
+        return;
+    this->precision = precision;
+
+    for (unsigned int i = 0; i < next_pid; ++i)
+        geo_components[i]->set_precision(precision);
+    reevaluate_all();
+}
+
+Precision GeoComponents::get_precision() const {
+    return precision;
+}
+
+void GeoComponents::reevaluate_all(){
+    // Every construction, frozen ones included, in pid order
+    for (unsigned int i = 0; i < next_pid; ++i) {
+        if (dirty[i] != CLEAN) {
+            recompute(i);
+        } else {
+            geo_components[i]->update();
+            evaluated(i);
+            update_box(i);
+        }
+    }
+    first_dirty = next_pid;
+    ++sequence;
+}
+
+void GeoComponents::access(unsigned int pid, double data[]){
+    evaluate(pid);
+    geo_components[pid]->access(data);
+}
+
+bool GeoComponents::evaluate(unsigned int pid){
+    if (dirty[pid] == CLEAN)
+        return false;
+
+    // Dirty ancestors, depth first: the search stops at clean constructions, whose ancestors are all clean
+    collected.clear();
+    collected.push_back(pid);
+    dirty[pid] = COLLECTED;
+    for (unsigned int k = 0; k < collected.size(); ++k) {
+        GeoNode* geo = geo_components[collected[k]];
+        for (int j = 0; j < geo->num_parents; ++j) {
+            unsigned int parent = geo->parents[j]->pid;
+            if (dirty[parent] == DIRTY) {
+                dirty[parent] = COLLECTED;
+                collected.push_back(parent);
+            }
+        }
+    }
+
+    // Parents come before their children in pid order
+    sort(begin(collected), end(collected));
+    for (auto it = begin(collected); it != end(collected); ++it)
+        recompute(*it);
+
+    return true;
+}
+
+unsigned int GeoComponents::evaluate_view(const double view[4]){
+    unsigned long long before = evaluations;
+    double data[GeoNode::DATA_SIZE];
+
+    for (unsigned int i = first_dirty; i < next_pid && dirty_count != 0; ++i) {
+        if (dirty[i] == CLEAN)
+            continue;
+
+        // Same tests as culling, on the last values
+        const double* box = &boxes[4 * i];
+        if (box[1] < view[0] || box[0] > view[1] || box[3] < view[2] || box[2] > view[3])
+            continue;
+        geo_components[i]->access(data);
+        if (geo_components[i]->in_view(data, view))
+            evaluate(i);
+    }
+
+    return static_cast<unsigned int>(evaluations - before);
+}
+
+unsigned int GeoComponents::evaluate_all(){
+    unsigned int count = dirty_count;
+
+    // In pid order the parents of a dirty construction are always up to date
+    for (unsigned int i = first_dirty; i < next_pid && dirty_count != 0; ++i) {
+        if (dirty[i] != CLEAN)
+            recompute(i);
+    }
+    first_dirty = next_pid;
+
+    return count;
+}
+
+unsigned int GeoComponents::evaluate_for(double budget_ms){
+    auto deadline = chrono::steady_clock::now() + chrono::duration<double, milli>(budget_ms);
+    unsigned int count = 0;
+
+    // Check the clock every few constructions only
+    const unsigned int CHUNK = 64;
+    while (dirty_count != 0 && first_dirty < next_pid) {
+        unsigned int end = min(first_dirty + CHUNK, next_pid);
+        for (; first_dirty < end; ++first_dirty) {
+            if (dirty[first_dirty] != CLEAN) {
+                recompute(first_dirty);
+                ++count;
+            }
+        }
+
+        if (chrono::steady_clock::now() >= deadline)
+            break;
+    }
+
+    return count;
+}
+
+void GeoComponents::recompute(unsigned int pid){
+    geo_components[pid]->update();
+    evaluated(pid);
+    update_box(pid);
+    dirty[pid] = CLEAN;
+    --dirty_count;
+}
+
+bool GeoComponents::is_dirty(unsigned int pid) const {
+    return dirty[pid] != CLEAN;
+}
+
+unsigned int GeoComponents::get_dirty() const {
+    return dirty_count;
+}
+
+unsigned long long GeoComponents::get_evaluations() const {
+    return evaluations;
+}
+
+void GeoComponents::update_box(unsigned int pid){
+    double data[GeoNode::DATA_SIZE];
+    geo_components[pid]->access(data);
+    geo_components[pid]->bounds(data, &boxes[4 * pid]);
+}
+
+void GeoComponents::take_snapshot(GeoSnapshot* snapshot) const {
+    snapshot->sequence = sequence;
+    snapshot->topology = topology;
+    snapshot->data.resize(geo_components.size() * GeoNode::DATA_SIZE);
+    snapshot->well_defined.resize(geo_components.size());
+    snapshot->stale = dirty;
+    snapshot->boxes = boxes;
+
+    unsigned int i = 0;
+    for (auto it = begin(geo_components); it != end(geo_components); ++it, ++i) {
+        (*it)->access(&snapshot->data[i * GeoNode::DATA_SIZE]);
+        snapshot->well_defined[i] = (*it)->well_defined;
+    }
+}
+
+bool GeoComponents::display_snapshot(Ui::MainWindow *ui, const GeoSnapshot& snapshot){
+    if (snapshot.topology != topology || snapshot.size() != geo_components.size())
+        return false;
+
+    for (unsigned int i = 0; i < snapshot.size(); ++i)
+        display_node(ui, i, snapshot.access(i), snapshot.well_defined[i]);
+
+    return true;
+}
+
+void GeoComponents::display_construction(Ui::MainWindow *ui, unsigned int pid, const GeoSnapshot& snapshot){
+    display_node(ui, pid, snapshot.access(pid), snapshot.well_defined[pid]);
+}
+
+void GeoComponents::visibility_order(const GeoSnapshot& snapshot, const double view[4], vector<unsigned int>* order) const {
+    order->clear();
+    order->reserve(snapshot.size());
+
+    // Constructions in view first, the rest afterwards, both in pid order
+    for (unsigned int i = 0; i < snapshot.size(); ++i) {
+        if (geo_components[i]->in_view(snapshot.access(i), view))
+            order->push_back(i);
+    }
+    unsigned int in_view = order->size();
+    for (unsigned int i = 0, j = 0; i < snapshot.size(); ++i) {
+        if (j < in_view && (*order)[j] == i)
+            ++j;
+        else
+            order->push_back(i);
+    }
 }
 
 void GeoComponents::update_ui_labels(vector<string>* point_labels, vector<string>* line_labels, vector<string>* circle_labels, vector<string>* triangle_labels, bool undefined) {
@@ -124,6 +645,21 @@ void GeoComponents::update_ui_labels(vector<string>* point_labels, vector<string
         if((*it)->well_defined || undefined)
             (*it)->labels(point_labels, line_labels, circle_labels, triangle_labels);
     }
+
+    // An alias goes with the labels of its construction: the vector the construction adds its label to gets the alias instead
+    vector<string>* all[4] = {point_labels, line_labels, circle_labels, triangle_labels};
+    for (auto it = begin(aliases); it != end(aliases); ++it){
+        if(!it->second->well_defined && !undefined)
+            continue;
+        size_t sizes[4];
+        for (int k = 0; k < 4; ++k)
+            sizes[k] = all[k]->size();
+        it->second->labels(point_labels, line_labels, circle_labels, triangle_labels);
+        for (int k = 0; k < 4; ++k) {
+            if (all[k]->size() != sizes[k])
+                all[k]->back() = it->first;
+        }
+    }
 }
 
 void GeoComponents::print_all_constructions(){
@@ -133,19 +669,148 @@ void GeoComponents::print_all_constructions(){
 }
 
 unsigned int GeoComponents::get_pid(string label){
-    for (auto it = begin(geo_components); it != end(geo_components); ++it){
-        if((*it)->label == label)
-            return (*it)->pid;
-    }
+    auto it = label_index.find(label);
+    if (it != label_index.end())
+        return it->second;
 
     return static_cast<unsigned int>(-1);
 }
 
-GeoNode* GeoComponents::get_construction(unsigned int pid){
-    for (auto it = begin(geo_components); it != end(geo_components); ++it){
-        if((*it)->pid == pid)
-            return (*it);
+unsigned int GeoComponents::size() const {
+    return geo_components.size();
+}
+
+bool GeoComponents::is_point(unsigned int pid) const {
+    return geo_components[pid]->is_point();
+}
+
+bool GeoComponents::get_structure(unsigned int pid, vector<unsigned int>* key) const {
+    // The parents of symmetric constructions are sorted by structure, they are put back in order
+    const GeoNode* geo = geo_components[pid];
+    bool structured = geo->structure(key);
+    for (int j = 0; j < geo->num_parents; ++j)
+        (*key)[2 + j] = geo->parents[j]->pid;
+    return structured;
+}
+
+bool GeoComponents::set_hidden(unsigned int pid, unsigned char flag, bool hide) {
+    bool was_hidden = (hidden[pid] != 0);
+    hidden[pid] = hide ? (hidden[pid] | flag) : (hidden[pid] & ~flag);
+    return was_hidden != (hidden[pid] != 0);
+}
+
+unsigned int GeoComponents::cull(const GeoSnapshot& snapshot, const double view[4], vector<unsigned int>* changed) {
+    if (snapshot.topology != topology || snapshot.size() != geo_components.size())
+        return 0;
+
+    unsigned int culled = 0;
+    for (unsigned int i = 0; i < snapshot.size(); ++i) {
+
+        // Cheap test on the bounding box, then the exact one (lines, circle outlines)
+        const double* box = snapshot.box(i);
+        bool outside = (box[1] < view[0] || box[0] > view[1] || box[3] < view[2] || box[2] > view[3]);
+        if (!outside)
+            outside = !geo_components[i]->in_view(snapshot.access(i), view);
+
+        // Solvers are never seen (see SolverNode::in_view), they stay hidden but are not counted
+        culled += outside && !geo_components[i]->is_solver();
+        if (set_hidden(i, HIDE_CULLED, outside))
+            changed->push_back(i);
+    }
+
+    return culled;
+}
+
+unsigned int GeoComponents::share(GeoNode* solver) {
+    // Found by its structure even when merging is off, the whole point of a solver is to be shared
+    solver->structure(&key);
+    auto it = structure_index.find(key);
+    if (it != structure_index.end()) {
+        delete solver;
+        return it->second;
+    }
+    return add_construction(solver);
+}
+
+bool GeoComponents::set_fixed(unsigned int pid, bool fixed) {
+    // Only constructions with free parameters can be moved, and so fixed (see GeoNode::structure)
+    if (pid >= next_pid || geo_components[pid]->structure(&key))
+        return false;
+
+    if (this->fixed[pid] != fixed) {
+        this->fixed[pid] = fixed;
+        fold();
+    }
+    return true;
+}
+
+bool GeoComponents::is_fixed(unsigned int pid) const {
+    return fixed[pid];
+}
+
+bool GeoComponents::is_frozen(unsigned int pid) const {
+    return frozen[pid];
+}
+
+bool GeoComponents::is_movable(unsigned int pid) const {
+    return pid < next_pid && free_parameters[pid] && !frozen[pid];
+}
+
+unsigned int GeoComponents::get_frozen() const {
+    return next_pid - live.size();
+}
+
+bool GeoComponents::foldable(unsigned int pid) {
+    GeoNode* geo = geo_components[pid];
+
+    // Free constructions are frozen only if fixed, the others if all their parents are frozen
+    if (!fixed[pid] && !geo->structure(&key))
+        return false;
+    for (int j = 0; j < geo->num_parents; ++j) {
+        if (!frozen[geo->parents[j]->pid])
+            return false;
+    }
+    return true;
+}
+
+void GeoComponents::fold() {
+    frozen.assign(next_pid, false);
+    live.clear();
+
+    // In pid order, the parents are classified first
+    for (unsigned int i = 0; i < next_pid; ++i) {
+        frozen[i] = foldable(i);
+        if (!frozen[i])
+            live.push_back(i);
+        // Pull mode: a frozen construction is never evaluated on demand again by propagation, it is brought up to date now
+        else if (dirty[i] != CLEAN)
+            evaluate(i);
     }
+}
+
+void GeoComponents::set_merging(bool merging) {
+    this->merging = merging;
+}
+
+unsigned int GeoComponents::get_merged() const {
+    return merged;
+}
+
+unsigned long long GeoComponents::get_saved_evaluations() const {
+    return saved_evaluations;
+}
+
+unsigned long GeoComponents::get_sequence() const {
+    return sequence;
+}
+
+unsigned long GeoComponents::get_topology() const {
+    return topology;
+}
+
+GeoNode* GeoComponents::get_construction(unsigned int pid){
+    if (pid < geo_components.size())
+        return geo_components[pid];
 
     return nullptr;
 }
@@ -1,26 +1,94 @@
 /***************************************************************************
 This class, GeoComponents, serves as the container of all our constructions
 (GeoNodes), they are stored as a STL vector of pointers to GeoNode.
+Edits are propagated to the dependent constructions right away (push mode),
+or only mark them dirty until their values are demanded (pull mode).
+Constructions that no edit can change (every free input they depend on is
+fixed) are frozen: they are left out of propagation until the topology or
+the fixed points change.
 ****************************************************************************/
 
 #ifndef GEOCOMPONENTS_H_
 #define GEOCOMPONENTS_H_
 
 #include <vector>
+#include <unordered_map>
+#include "FigurePool.h"
+#include "GeoDescriptor.h"
 #include "GeoNode.h"
+#include "GeoSnapshot.h"
+
+/** @brief Evaluation modes of the constructions. */
+enum class Evaluation {
+    PUSH, //!< Edits recompute every dependent construction right away.
+    PULL //!< Edits only mark dependent constructions dirty, they are recomputed when demanded (access, display, evaluate).
+};
+
+/** @brief Coordinates in which the points and lines are computed. */
+enum class Coordinates {
+    CARTESIAN, //!< Points are (x, y), constructions that would lie at infinity are not well-defined.
+    HOMOGENEOUS //!< Points are (x, y, w), divided only on access: points at infinity are well-defined, and joins and meets do not branch.
+};
 
 class GeoComponents {
 
 public:
+    //@{
+    /** @brief Reasons for hiding the figure of a well-defined construction, combined as bit flags. */
+    static const unsigned char HIDE_CLUSTERED = 1;
+    static const unsigned char HIDE_CULLED = 2;
+    //@}
+
     GeoComponents(); /**< @brief Constructor */
-    /** @brief Takes a pointer to a construction and a label, updates the label of the construction and adds it to the back of the vector. */
-    void add_construction(GeoNode* geo, string label = "");
+    /** @brief Takes a pointer to a construction and a label, updates the label of the construction and adds it to the back of the vector.
+     *  If merging is on and an identical construction (same kind, type and parents) exists, the new one is deleted and the label becomes an alias of the existing one.
+     *  Returns the pid of the construction (added or existing), -1 if it is not well-defined (it is then deleted). */
+    unsigned int add_construction(GeoNode* geo, string label = "");
+    /** @brief Takes a batch of descriptors, in an order where parents come before their children, and adds the corresponding constructions.
+     *  All labels, references and kinds of parents are validated first (nothing is added if one is taken, unknown or of the wrong kind), each construction is then evaluated once.
+     *  Intersections and tangents select their root from a solver node shared by both roots of the same parents (see SolverNode).
+     *  Returns the number of constructions added (less than the batch size if one turned out ill-defined, the rest is then skipped) and sets pids if given. */
+    unsigned int add_constructions(const vector<GeoDescriptor>& batch, vector<unsigned int>* pids = nullptr);
     /** @brief Takes a pid of a construction and an array of data to update the construction. */
     void edit_construction(unsigned int pid, double data[]);
-    /** @brief Takes a pid of a construction and removes it, along with any derived constructions (children) of this construction. */
+    /** @brief Takes pids of constructions and their data (stride values each) and updates them, along with their children, in a single propagation pass.
+     *  Edits of constructions that cannot be moved (see is_movable) are ignored. In pull mode the children are only marked dirty. If given, touched is set to the pids recomputed (or marked dirty), in increasing order. */
+    void edit_constructions(const vector<unsigned int>& pids, double data[], unsigned int stride = 2, vector<unsigned int>* touched = nullptr);
+    /** @brief Takes a pid of a construction and removes it, along with any derived constructions (children) of this construction and the aliases of all of them. */
     void remove_construction(unsigned int pid);
+    /** @brief Takes a label and, if it is the alias of a merged duplicate, removes the alias only and returns true. The construction and the aliases of its children are kept. */
+    bool remove_alias(const string& label);
     /** @brief Updates all the figures representing the constructions on the plot. */
     void display_all_constructions(Ui::MainWindow *ui);
+    /** @brief Sets the evaluation mode, the dirty constructions are evaluated when switching back to push. */
+    void set_evaluation(Evaluation evaluation);
+    Evaluation get_evaluation() const; /**< @brief Returns the evaluation mode. */
+    /** @brief Sets the coordinates of the points and lines, and evaluates every construction again in them. */
+    void set_coordinates(Coordinates coordinates);
+    Coordinates get_coordinates() const; /**< @brief Returns the coordinates of the points and lines. */
+    /** @brief Sets the scalar type in which the points, lines, circles and solvers are computed (see GeoScalar.h), and evaluates every construction again in it. */
+    void set_precision(Precision precision);
+    Precision get_precision() const; /**< @brief Returns the scalar type of the constructions. */
+    /** @brief Takes a pid of a construction and sets data as its access does, evaluating it first if it is dirty. */
+    void access(unsigned int pid, double data[]);
+    /** @brief Evaluates the construction with the given pid along with its dirty ancestors, returns false if it was up to date. */
+    bool evaluate(unsigned int pid);
+    /** @brief Takes a view rectangle and evaluates the dirty constructions whose last values put them in it, returns the number of constructions evaluated. */
+    unsigned int evaluate_view(const double view[4]);
+    unsigned int evaluate_all(); /**< @brief Evaluates every dirty construction, returns the number evaluated. */
+    /** @brief Evaluates dirty constructions in pid order for at most budget_ms milliseconds, resuming where the previous call stopped. Returns the number evaluated. */
+    unsigned int evaluate_for(double budget_ms);
+    bool is_dirty(unsigned int pid) const; /**< @brief Returns whether the construction with the given pid awaits evaluation (pull mode). */
+    unsigned int get_dirty() const; /**< @brief Returns the number of constructions awaiting evaluation. */
+    unsigned long long get_evaluations() const; /**< @brief Returns the number of constructions recomputed so far, by propagation or on demand. */
+    /** @brief Takes a snapshot and copies into it the data and well-definedness of every construction (the last values of dirty ones, marked stale). */
+    void take_snapshot(GeoSnapshot* snapshot) const;
+    /** @brief Updates all the figures from a snapshot, returns false (and does nothing) if it was taken before the last topology change. */
+    bool display_snapshot(Ui::MainWindow *ui, const GeoSnapshot& snapshot);
+    /** @brief Updates the figure of the construction with the given pid from a snapshot (taken at the current topology). */
+    void display_construction(Ui::MainWindow *ui, unsigned int pid, const GeoSnapshot& snapshot);
+    /** @brief Takes a snapshot and a view rectangle {x_min, x_max, y_min, y_max}, and sets order to all pids with the ones in view first. */
+    void visibility_order(const GeoSnapshot& snapshot, const double view[4], vector<unsigned int>* order) const;
     /** @brief Takes a collection of string vectors and sets them to be the collection of labels of current constructions. */
     void update_ui_labels(vector<string> *point_labels, vector<string> *line_labels, vector<string> *circle_labels, vector<string> *triangle_labels, bool undefined = false);
 
@@ -28,12 +96,85 @@ public:
 
     unsigned int get_pid(string label); /**< @brief Takes a label and returns the pid of the construction with the corresponding label, if there is no construction with that label, returns -1. */
     GeoNode* get_construction(unsigned int pid); /**< @brief Takes a pid of a construction and returns a pointer to it, if there is no construction at that index, returns nullptr. */
+    unsigned int size() const; /**< @brief Returns the number of constructions. */
+    bool is_point(unsigned int pid) const; /**< @brief Returns whether the construction with the given pid is drawn as a point. */
+    /** @brief Takes a pid of a construction and sets key to {kind, type, parent pids}, the parents in the order of its definition (unlike GeoNode::structure).
+     *  Returns false if it has free parameters. */
+    bool get_structure(unsigned int pid, vector<unsigned int>* key) const;
+    /** @brief Sets or clears a reason (HIDE_* flag) for hiding the figure of the construction with the given pid, returns whether its visibility changed. */
+    bool set_hidden(unsigned int pid, unsigned char flag, bool hide);
+    /** @brief Takes a snapshot and a view rectangle, hides (HIDE_CULLED) the constructions entirely outside of it and shows the others.
+     *  Adds to changed the pids whose visibility changed and returns the number of constructions culled (solvers, never seen, are not counted). */
+    unsigned int cull(const GeoSnapshot& snapshot, const double view[4], vector<unsigned int>* changed);
+    /** @brief Fixes (or frees) the construction with the given pid, which must have free parameters (a point that can be moved), returns false otherwise.
+     *  Edits of a fixed construction are ignored, and the constructions depending only on fixed ones are frozen. */
+    bool set_fixed(unsigned int pid, bool fixed);
+    bool is_fixed(unsigned int pid) const; /**< @brief Returns whether the construction with the given pid was fixed. */
+    bool is_frozen(unsigned int pid) const; /**< @brief Returns whether the construction with the given pid cannot change under any edit. */
+    /** @brief Returns whether the given pid is that of a point taking coordinates from edits: a free point (independent, on a line or circle) that is not fixed. */
+    bool is_movable(unsigned int pid) const;
+    unsigned int get_frozen() const; /**< @brief Returns the number of frozen constructions. */
+    void set_merging(bool merging); /**< @brief Sets whether constructions identical to existing ones are merged into them when added (on by default). */
+    unsigned int get_merged() const; /**< @brief Returns the number of duplicates merged into the current constructions, which is also the number of figures saved. */
+    unsigned long long get_saved_evaluations() const; /**< @brief Returns the number of evaluations saved so far by the merged duplicates. */
+    unsigned long get_sequence() const; /**< @brief Returns the number of propagation passes (edits) performed so far. */
+    unsigned long get_topology() const; /**< @brief Returns the topology version, which changes whenever constructions are added or removed. */
 
     virtual ~GeoComponents(); /**< @brief Deletes all constructions */
 
 private:
+    void update_box(unsigned int pid); /**< @brief Recomputes the bounding box of the construction with the given pid. */
+    void recompute(unsigned int pid); /**< @brief Updates the construction with the given pid from its (up to date) parents and marks it clean. */
+    void index_labels(); /**< @brief Rebuilds the label index from the constructions and the aliases. */
+    void index_structures(); /**< @brief Rebuilds the structure index from the constructions. */
+    void evaluated(unsigned int pid); /**< @brief Counts an evaluation of the construction with the given pid, and the ones saved by its duplicates. */
+    /** @brief Takes a solver (see SolverNode) and returns the pid of the identical one if any (the solver is then deleted), otherwise adds it. Returns -1 if it is not well-defined. */
+    unsigned int share(GeoNode* solver);
+    /** @brief Takes a pid and returns whether the construction would be frozen, from its fixed flag and its parents. */
+    bool foldable(unsigned int pid);
+    void fold(); /**< @brief Finds again the frozen constructions, evaluating those that were dirty. */
+    void reevaluate_all(); /**< @brief Evaluates every construction again, frozen ones included, in pid order (after a change of coordinates or precision). */
+    /** @brief Updates the figure of the construction with the given pid, or gives it back to the pool if the construction is hidden. */
+    void display_node(Ui::MainWindow *ui, unsigned int pid, const double data[], bool defined);
+
     vector<GeoNode*> geo_components; /**< @brief STL vector containing pointers to all the constructions. */
     unsigned int next_pid {0}; /**< @brief The pid to be assigned to the next construction added to the vector.*/
+    unordered_map<string, unsigned int> label_index; /**< @brief Pid of the first construction with each label. */
+    /** @brief Hash of a structure key (see GeoNode::structure). */
+    struct StructureHash {
+        size_t operator()(const vector<unsigned int>& key) const;
+    };
+    unordered_map<vector<unsigned int>, unsigned int, StructureHash> structure_index; /**< @brief Pid of the construction with each structure, if it has one. */
+    unordered_map<string, GeoNode*> aliases; /**< @brief Labels of the merged duplicates, with the construction each one was merged into. */
+    vector<unsigned int> duplicates; /**< @brief Number of duplicates merged into each construction, indexed by pid. */
+    vector<unsigned int> key; /**< @brief Scratch structure key. */
+    bool merging {true}; /**< @brief Indicates whether duplicates are merged when added. */
+    unsigned int merged {0}; /**< @brief Number of duplicates merged into the current constructions. */
+    unsigned long long saved_evaluations {0}; /**< @brief Number of evaluations saved by the merged duplicates. */
+    vector<unsigned char> hidden; /**< @brief HIDE_* flags of each construction, indexed by pid. */
+    vector<char> released; /**< @brief Indicates whether each construction gave its figure back since it was hidden, indexed by pid. */
+    FigurePool pool; /**< @brief Figures of the constructions, created on first need and recycled when hidden or removed. */
+    vector<double> boxes; /**< @brief Bounding boxes of the constructions, maintained during propagation, 4 per pid. */
+    unsigned long topology {0}; /**< @brief Topology version, increased whenever constructions are added or removed. */
+    unsigned long sequence {0}; /**< @brief Number of propagation passes (edits) performed so far. */
+    Evaluation evaluation {Evaluation::PUSH}; /**< @brief Evaluation mode. */
+    //@{
+    /** @brief Evaluation state of each construction (indexed by pid), a clean construction only has clean ancestors. COLLECTED marks the dirty ones found during an evaluation. */
+    static const char CLEAN = 0;
+    static const char DIRTY = 1;
+    static const char COLLECTED = 2;
+    //@}
+    vector<char> dirty; /**< @brief Evaluation state of each construction, indexed by pid. */
+    unsigned int dirty_count {0}; /**< @brief Number of constructions not CLEAN. */
+    unsigned int first_dirty {0}; /**< @brief No construction with a lower pid is dirty. */
+    unsigned long long evaluations {0}; /**< @brief Number of constructions recomputed so far. */
+    vector<unsigned int> collected; /**< @brief Scratch list of the dirty constructions found by evaluate. */
+    vector<char> free_parameters; /**< @brief Indicates whether each construction has free parameters (see GeoNode::structure), indexed by pid. */
+    vector<char> fixed; /**< @brief Indicates whether each construction was fixed, indexed by pid. */
+    vector<char> frozen; /**< @brief Indicates whether each construction is frozen, indexed by pid. */
+    vector<unsigned int> live; /**< @brief Pids of the constructions not frozen, in increasing order, the only ones swept by propagation. */
+    Coordinates coordinates {Coordinates::CARTESIAN}; /**< @brief Coordinates of the points and lines. */
+    Precision precision {Precision::DOUBLE}; /**< @brief Scalar type of the constructions. */
 
 };
 
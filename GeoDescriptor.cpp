@@ -0,0 +1,135 @@
+/*
+ * GeoDescriptor.cpp
+ *
+ */
+
+#include "GeoDescriptor.h"
+#include "PointNode.h"
+#include "LineNode.h"
+#include "CircleNode.h"
+#include "TriangleNode.h"
+#include "TriangleCentersNode.h"
+#include "SolverNode.h"
+
+GeoDescriptor::GeoDescriptor(GeoKind kind, int type, string label, vector<GeoRef> parents, double x, double y)
+    : kind(kind), type(type), label(label), parents(parents), x(x), y(y) {}
+
+bool GeoDescriptor::accepts(const vector<GeoKind>& parent_kinds) const {
+    auto is = [&parent_kinds](vector<GeoKind> expected) { return parent_kinds == expected; };
+    const GeoKind P = GeoKind::POINT, L = GeoKind::LINE, C = GeoKind::CIRCLE;
+
+    // Solutions select a root of a solver, they are only created by create_selector
+    switch (kind) {
+    case GeoKind::POINT:
+        switch (static_cast<PointType>(type)) {
+        case PointType::INDEPENDENT: return is({});
+        case PointType::ON_LINE: return is({L});
+        case PointType::ON_CIRCLE: return is({C});
+        case PointType::POINT_POINT_MIDPOINT: return is({P, P});
+        case PointType::LINE_LINE_INTERSECTION: return is({L, L});
+        case PointType::LINE_CIRCLE_FIRST_INTERSECTION: case PointType::LINE_CIRCLE_SECOND_INTERSECTION: return is({L, C});
+        case PointType::CIRCLE_CIRCLE_FIRST_INTERSECTION: case PointType::CIRCLE_CIRCLE_SECOND_INTERSECTION: return is({C, C});
+        default: return false;
+        }
+    case GeoKind::LINE:
+        switch (static_cast<LineType>(type)) {
+        case LineType::POINT_POINT_LINE_THROUGH: case LineType::POINT_POINT_PERPENDICULAR_BISECTOR: return is({P, P});
+        case LineType::POINT_LINE_PARALLEL_LINE_THROUGH: return is({P, L});
+        case LineType::POINT_CIRCLE_FIRST_TANGENT: case LineType::POINT_CIRCLE_SECOND_TANGENT: return is({P, C});
+        default: return false;
+        }
+    case GeoKind::CIRCLE:
+        switch (static_cast<CircleType>(type)) {
+        case CircleType::POINT_POINT_CENTER_THROUGH: return is({P, P});
+        case CircleType::POINT_POINT_POINT_THROUGH: case CircleType::POINT_POINT_POINT_CENTER_RADIUS: return is({P, P, P});
+        default: return false;
+        }
+    case GeoKind::TRIANGLE:
+        return type == static_cast<int>(TriangleType::POINT_POINT_POINT_VERTICES) && is({P, P, P});
+    case GeoKind::TRIANGLE_CENTER:
+        return type >= static_cast<int>(TriangleCentersType::CENTROID) && type <= static_cast<int>(TriangleCentersType::LEMOINEPOINT) && is({GeoKind::TRIANGLE});
+    case GeoKind::SOLVER:
+        switch (static_cast<SolverType>(type)) {
+        case SolverType::LINE_CIRCLE_INTERSECTIONS: return is({L, C});
+        case SolverType::CIRCLE_CIRCLE_INTERSECTIONS: return is({C, C});
+        case SolverType::POINT_CIRCLE_TANGENTS: return is({P, C});
+        default: return false;
+        }
+    }
+    return false;
+}
+
+GeoNode* GeoDescriptor::create(GeoNode* parent_nodes[]) const {
+    switch (kind) {
+    case GeoKind::POINT:
+        switch (parents.size()) {
+        case 0: return new PointNode(static_cast<PointType>(type), x, y);
+        case 1: return new PointNode(static_cast<PointType>(type), parent_nodes[0], x, y);
+        case 2: return new PointNode(static_cast<PointType>(type), parent_nodes[0], parent_nodes[1]);
+        default: return nullptr;
+        }
+    case GeoKind::LINE:
+        switch (parents.size()) {
+        case 1: return new LineNode(static_cast<LineType>(type), parent_nodes[0]);
+        case 2: return new LineNode(static_cast<LineType>(type), parent_nodes[0], parent_nodes[1]);
+        default: return nullptr;
+        }
+    case GeoKind::CIRCLE:
+        switch (parents.size()) {
+        case 2: return new CircleNode(static_cast<CircleType>(type), parent_nodes[0], parent_nodes[1]);
+        case 3: return new CircleNode(static_cast<CircleType>(type), parent_nodes[0], parent_nodes[1], parent_nodes[2]);
+        default: return nullptr;
+        }
+    case GeoKind::TRIANGLE:
+        if (parents.size() == 3)
+            return new TriangleNode(static_cast<TriangleType>(type), parent_nodes[0], parent_nodes[1], parent_nodes[2]);
+        return nullptr;
+    case GeoKind::TRIANGLE_CENTER:
+        if (parents.size() == 1)
+            return new TriangleCentersNode(static_cast<TriangleCentersType>(type), parent_nodes[0]);
+        return nullptr;
+    case GeoKind::SOLVER:
+        if (parents.size() == 2)
+            return new SolverNode(static_cast<SolverType>(type), parent_nodes[0], parent_nodes[1]);
+        return nullptr;
+    }
+    return nullptr;
+}
+
+GeoNode* GeoDescriptor::create_solver(GeoNode* parent_nodes[]) const {
+    if (parents.size() != 2)
+        return nullptr;
+
+    if (kind == GeoKind::POINT) {
+        switch (static_cast<PointType>(type)) {
+        case PointType::LINE_CIRCLE_FIRST_INTERSECTION:
+        case PointType::LINE_CIRCLE_SECOND_INTERSECTION:
+            return new SolverNode(SolverType::LINE_CIRCLE_INTERSECTIONS, parent_nodes[0], parent_nodes[1]);
+        case PointType::CIRCLE_CIRCLE_FIRST_INTERSECTION:
+        case PointType::CIRCLE_CIRCLE_SECOND_INTERSECTION:
+            return new SolverNode(SolverType::CIRCLE_CIRCLE_INTERSECTIONS, parent_nodes[0], parent_nodes[1]);
+        default:
+            return nullptr;
+        }
+    }
+    if (kind == GeoKind::LINE) {
+        switch (static_cast<LineType>(type)) {
+        case LineType::POINT_CIRCLE_FIRST_TANGENT:
+        case LineType::POINT_CIRCLE_SECOND_TANGENT:
+            return new SolverNode(SolverType::POINT_CIRCLE_TANGENTS, parent_nodes[0], parent_nodes[1]);
+        default:
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+GeoNode* GeoDescriptor::create_selector(GeoNode* solver) const {
+    if (kind == GeoKind::POINT) {
+        PointType point_type = static_cast<PointType>(type);
+        bool second = (point_type == PointType::LINE_CIRCLE_SECOND_INTERSECTION || point_type == PointType::CIRCLE_CIRCLE_SECOND_INTERSECTION);
+        return new PointNode(second ? PointType::SECOND_SOLUTION : PointType::FIRST_SOLUTION, solver, 0, 0);
+    }
+    bool second = (static_cast<LineType>(type) == LineType::POINT_CIRCLE_SECOND_TANGENT);
+    return new LineNode(second ? LineType::SECOND_SOLUTION : LineType::FIRST_SOLUTION, solver);
+}
@@ -0,0 +1,59 @@
+/***************************************************************************
+This structure, GeoDescriptor, describes a construction to be created in a
+batch (see GeoComponents::add_constructions): its kind, its type within
+that kind, its label, references to its parents and, for points, its
+Cartesian coordinates. Parents are referenced either by label (of an
+existing construction or of an earlier descriptor of the same batch) or by
+handle (the pid of an existing construction).
+****************************************************************************/
+
+#ifndef GEODESCRIPTOR_H_
+#define GEODESCRIPTOR_H_
+
+#include <string>
+#include <vector>
+#include "GeoNode.h"
+
+/** @brief Kinds of constructions, the type of a descriptor is the corresponding PointType, LineType, ... */
+enum class GeoKind {
+    POINT, //!< PointNode, type is a PointType.
+    LINE, //!< LineNode, type is a LineType.
+    CIRCLE, //!< CircleNode, type is a CircleType.
+    TRIANGLE, //!< TriangleNode, type is a TriangleType.
+    TRIANGLE_CENTER, //!< TriangleCentersNode, type is a TriangleCentersType.
+    SOLVER //!< SolverNode, type is a SolverType.
+};
+
+/** @brief Reference to a parent construction. */
+struct GeoRef {
+    static const unsigned int NO_HANDLE = static_cast<unsigned int>(-1); //!< Handle of a reference by label.
+
+    GeoRef(const string& label): label(label) {} //!< Reference by label.
+    GeoRef(const char* label): label(label) {} //!< Reference by label.
+    GeoRef(unsigned int handle): handle(handle) {} //!< Reference by handle (pid of an existing construction).
+
+    string label {""}; //!< Label of the parent, used if handle is NO_HANDLE.
+    unsigned int handle {NO_HANDLE}; //!< Pid of the parent.
+};
+
+struct GeoDescriptor {
+    /** @brief Constructor, takes the kind, the type (PointType, LineType, ... as an int), the label, the parents and the coordinates (points only). */
+    GeoDescriptor(GeoKind kind, int type, string label, vector<GeoRef> parents = vector<GeoRef>(), double x = 0, double y = 0);
+
+    /** @brief Takes the kinds of the parents (triangle centers count as points) and returns whether they fit the kind and type of the construction. */
+    bool accepts(const vector<GeoKind>& parent_kinds) const;
+    /** @brief Takes the resolved parents and returns the new construction, or nullptr if the number of parents does not fit the kind. */
+    GeoNode* create(GeoNode* parent_nodes[]) const;
+    /** @brief Takes the resolved parents and, if the construction is one of the two solutions of a solve (intersections, tangents), returns the solver of both, nullptr otherwise. */
+    GeoNode* create_solver(GeoNode* parent_nodes[]) const;
+    /** @brief Takes the solver returned by create_solver and returns the construction selecting the solution described. */
+    GeoNode* create_selector(GeoNode* solver) const;
+
+    GeoKind kind; //!< Kind of the construction.
+    int type; //!< Type of the construction within its kind.
+    string label; //!< Label of the construction.
+    vector<GeoRef> parents; //!< References to the parents, in the order taken by the constructors.
+    double x {0}, y {0}; //!< Cartesian coordinates (independent points, points on a line or circle).
+};
+
+#endif /* GEODESCRIPTOR_H_ */
@@ -0,0 +1,332 @@
+/*
+ * GeoDiscovery.cpp
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "GeoDiscovery.h"
+
+const double GeoDiscovery::KEY_TOLERANCE = 1e-6;
+
+namespace {
+
+// Pseudo-angle of a direction folded on the upper half-plane, in [0, 2): increases with the angle, without trigonometry
+inline double pseudo_angle(double delta_x, double delta_y) {
+    double fold = (delta_y < 0 || (delta_y == 0 && delta_x < 0)) ? -1 : 1;
+    return 1 - fold * delta_x / (abs(delta_x) + fold * delta_y);
+}
+
+// Whether two points coincide within the tolerance, relative to their magnitude as GeoPredicates::coincident (without counting a predicate)
+inline bool close(double x1, double y1, double x2, double y2, double tolerance) {
+    double delta_x = x2 - x1, delta_y = y2 - y1, size_x = abs(x1) + abs(x2), size_y = abs(y1) + abs(y2);
+    return delta_x * delta_x + delta_y * delta_y <= tolerance * tolerance * (size_x * size_x + size_y * size_y);
+}
+
+}
+
+GeoDiscovery::GeoDiscovery(GeoComponents* geo_components, unsigned int threads, unsigned int samples, double tolerance, unsigned int seed):
+    geo_components(geo_components), threads(max(threads, 1u)), samples(max(samples, 1u)), tolerance(tolerance), seed(seed) {}
+
+bool GeoDiscovery::run() {
+    error.clear();
+    relations.clear();
+    pids.clear();
+    x.clear();
+    y.clear();
+    next.store(0);
+    candidates.store(0);
+    auto start = chrono::steady_clock::now();
+
+    // The points searched are those that are well-defined (and not at infinity) in the current positions
+    double data[GeoNode::DATA_SIZE];
+    for (unsigned int pid = 0; pid < geo_components->size(); ++pid) {
+        if (!geo_components->is_point(pid))
+            continue;
+        geo_components->access(pid, data);
+        if (!geo_components->get_construction(pid)->get_well_defined() || !isfinite(data[0]) || !isfinite(data[1]))
+            continue;
+        pids.push_back(pid);
+        x.push_back(data[0]);
+        y.push_back(data[1]);
+    }
+
+    // Points that coincide with a lower one in the current positions are searched once
+    vector<unsigned int> order(pids.size());
+    for (unsigned int i = 0; i < order.size(); ++i)
+        order[i] = i;
+    sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return make_pair(x[a], y[a]) < make_pair(x[b], y[b]); });
+    vector<bool> duplicate(pids.size(), false);
+    for (unsigned int k = 1; k < order.size(); ++k) {
+        unsigned int a = order[k - 1], b = order[k];
+        if (close(x[a], y[a], x[b], y[b], tolerance))
+            duplicate[max(a, b)] = true;
+    }
+    unsigned int kept = 0;
+    for (unsigned int i = 0; i < pids.size(); ++i) {
+        if (duplicate[i])
+            continue;
+        pids[kept] = pids[i];
+        x[kept] = x[i];
+        y[kept] = y[i];
+        ++kept;
+    }
+    pids.resize(kept);
+    x.resize(kept);
+    y.resize(kept);
+
+    // One batch of placements verifies every group, each worker deciding on its own copy
+    vector<unsigned int> inputs;
+    double box[4];
+    if (!GeoChecker::free_points(geo_components, &inputs, box))
+        return fail("no free point to place");
+    GeoBatch batch(geo_components);
+    if (!batch.compile(inputs))
+        return fail("relations are verified in Cartesian coordinates");
+    vector<double> placements;
+    GeoChecker::place(box, inputs.size(), seed, 0, samples, &placements);
+    batch.evaluate(samples, &placements[0]);
+
+    unsigned int workers = min<unsigned int>(threads, max<unsigned int>(pids.size(), 1));
+    vector<GeoBatch> batches(workers, batch);
+    vector<vector<Relation>> found(workers);
+    vector<thread> pool;
+    for (unsigned int i = 0; i < workers; ++i)
+        pool.push_back(thread(&GeoDiscovery::work, this, &batches[i], &found[i]));
+    for (auto it = begin(pool); it != end(pool); ++it)
+        it->join();
+
+    // Ordered by incidence, then by points, whatever worker found them
+    vector<Relation> all;
+    for (auto it = begin(found); it != end(found); ++it)
+        all.insert(all.end(), it->begin(), it->end());
+    sort(all.begin(), all.end(), [](const Relation& a, const Relation& b) {
+        return (a.incidence != b.incidence) ? (a.incidence < b.incidence) : (a.points < b.points);
+    });
+    for (auto it = begin(all); it != end(all); ++it) {
+        GeoConjecture relation;
+        relation.incidence = it->incidence;
+        for (auto point = begin(it->points); point != end(it->points); ++point)
+            relation.labels.push_back(geo_components->get_construction(pids[*point])->get_label());
+        relations.push_back(relation);
+    }
+
+    elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void GeoDiscovery::work(GeoBatch* batch, vector<Relation>* relations) {
+    const unsigned int n = pids.size(), m = max(n, 1u) - 1;
+    vector<unsigned int> around(m), above, below;
+    vector<double> delta_x(m), delta_y(m), inverted_x(m), inverted_y(m), key(m);
+    vector<vector<unsigned int>> groups;
+    Cells cells;
+
+    for (unsigned int i = next.fetch_add(1); i < n; i = next.fetch_add(1)) {
+        // The other points by position, relative to the anchor
+        for (unsigned int j = 0, q = 0; j < n; ++j) {
+            if (j != i)
+                around[q++] = j;
+        }
+        // A point coinciding with the anchor (the duplicates are only dropped between neighbors in order) has no direction
+        #pragma omp simd
+        for (unsigned int q = 0; q < m; ++q) {
+            delta_x[q] = x[around[q]] - x[i];
+            delta_y[q] = y[around[q]] - y[i];
+            key[q] = (delta_x[q] != 0 || delta_y[q] != 0) ? pseudo_angle(delta_x[q], delta_y[q]) : -1;
+        }
+
+        // Lines through the anchor
+        group(&key[0], m, &cells, &groups);
+        for (auto it = begin(groups); it != end(groups); ++it) {
+            above.clear();
+            below.clear();
+            for (auto position = begin(*it); position != end(*it); ++position)
+                (around[*position] > i ? above : below).push_back(around[*position]);
+            if (above.size() < 2)
+                continue;
+            candidates.fetch_add(1, memory_order_relaxed);
+            split(batch, Incidence::COLLINEAR, {i}, above, below, relations);
+        }
+
+        // Circles through the anchor and a higher point, lines of the inversion centered on the anchor,
+        // the direction of the center being left out (lines through the anchor)
+        #pragma omp simd
+        for (unsigned int q = 0; q < m; ++q) {
+            double inverse = 1 / (delta_x[q] * delta_x[q] + delta_y[q] * delta_y[q]);
+            inverted_x[q] = delta_x[q] * inverse;
+            inverted_y[q] = delta_y[q] * inverse;
+        }
+        for (unsigned int p = i; p < m; ++p) {
+            const unsigned int j = around[p];
+            const double center = pseudo_angle(-inverted_x[p], -inverted_y[p]), from_x = inverted_x[p], from_y = inverted_y[p];
+            #pragma omp simd
+            for (unsigned int q = 0; q < m; ++q) {
+                double angle = pseudo_angle(inverted_x[q] - from_x, inverted_y[q] - from_y), difference = abs(angle - center);
+                key[q] = (min(difference, 2 - difference) > KEY_TOLERANCE) ? angle : -1;
+            }
+            key[p] = -1;
+
+            group(&key[0], m, &cells, &groups);
+            for (auto it = begin(groups); it != end(groups); ++it) {
+                above.clear();
+                below.clear();
+                for (auto position = begin(*it); position != end(*it); ++position)
+                    (around[*position] > j ? above : below).push_back(around[*position]);
+                if (above.size() < 2)
+                    continue;
+                candidates.fetch_add(1, memory_order_relaxed);
+                split(batch, Incidence::CONCYCLIC, {i, j}, above, below, relations);
+            }
+        }
+    }
+}
+
+void GeoDiscovery::group(const double key[], unsigned int count, Cells* cells, vector<vector<unsigned int>>* groups) const {
+    groups->clear();
+
+    // Direct-mapped table of at least 16 slots per position, emptied by a new generation
+    if (cells->slots.size() < 16 * static_cast<size_t>(count)) {
+        size_t size = 32;
+        while (size < 16 * static_cast<size_t>(count))
+            size *= 2;
+        cells->slots.assign(size, Slot());
+    }
+    if (cells->marks.size() < count)
+        cells->marks.resize(count, 0);
+    if (++cells->generation == 0) {
+        fill(cells->slots.begin(), cells->slots.end(), Slot());
+        fill(cells->marks.begin(), cells->marks.end(), 0);
+        cells->generation = 1;
+    }
+    const unsigned int generation = cells->generation;
+    const long long mask = cells->slots.size() - 1, last = static_cast<long long>(2 / KEY_TOLERANCE);
+    Slot* slots = &cells->slots[0];
+    unsigned int* marks = &cells->marks[0];
+
+    // Positions whose cell, or a neighbouring one (the first and last cells being neighbours), is taken are crowded:
+    // those sharing a cell or close to its border, and a few whose cells share a slot
+    for (unsigned int q = 0; q < count; ++q) {
+        if (key[q] < 0)
+            continue;
+        long long cell = min(static_cast<long long>(key[q] / KEY_TOLERANCE), last);
+        long long below = ((cell == 0) ? last : cell - 1) & mask, slot = cell & mask, above = ((cell == last) ? 0 : cell + 1) & mask;
+        if ((slots[below].stamp == generation) | (slots[slot].stamp == generation) | (slots[above].stamp == generation)) {
+            const long long neighbours[3] = {below, slot, above};
+            for (int k = 0; k < 3; ++k) {
+                if (slots[neighbours[k]].stamp == generation)
+                    marks[slots[neighbours[k]].owner] = generation;
+            }
+            marks[q] = generation;
+        }
+        if (slots[slot].stamp != generation) {
+            slots[slot].stamp = generation;
+            slots[slot].owner = q;
+        }
+    }
+    vector<pair<double, unsigned int>>& crowded = cells->crowded;
+    crowded.clear();
+    for (unsigned int q = 0; q < count; ++q) {
+        if (key[q] >= 0 && marks[q] == generation)
+            crowded.push_back(make_pair(key[q], q));
+    }
+    sort(crowded.begin(), crowded.end());
+
+    // Runs of consecutive keys within the tolerance, starting after a wider gap so that no run is cut across 2 (the same direction)
+    const unsigned int size = crowded.size();
+    auto gap = [&](unsigned int k) {
+        double difference = crowded[k % size].first - crowded[(k + size - 1) % size].first;
+        return (difference < 0) ? difference + 2 : difference;
+    };
+    unsigned int start = 0;
+    while (start < size && gap(start) <= KEY_TOLERANCE)
+        ++start;
+    start %= max(size, 1u);
+
+    for (unsigned int k = 0; k < size; ) {
+        unsigned int end = k + 1;
+        while (end < size && gap(start + end) <= KEY_TOLERANCE)
+            ++end;
+        if (end - k >= 2) {
+            groups->push_back(vector<unsigned int>());
+            for (unsigned int r = k; r < end; ++r)
+                groups->back().push_back(crowded[(start + r) % size].second);
+            sort(groups->back().begin(), groups->back().end());
+        }
+        k = end;
+    }
+}
+
+void GeoDiscovery::split(GeoBatch* batch, Incidence incidence, const vector<unsigned int>& anchors, vector<unsigned int> above,
+                         const vector<unsigned int>& below, vector<Relation>* relations) {
+    vector<unsigned int> rest, test;
+    while (above.size() >= 2) {
+        // The anchors and the lowest point fix the line or circle, the points of the group that stay on it in every placement join them
+        Relation relation {incidence, anchors};
+        relation.points.push_back(above[0]);
+        const size_t base = relation.points.size();
+        test = relation.points;
+        test.push_back(0);
+        rest.clear();
+        for (unsigned int m = 1; m < above.size(); ++m) {
+            test.back() = above[m];
+            if (holds(batch, incidence, test))
+                relation.points.push_back(above[m]);
+            else
+                rest.push_back(above[m]);
+        }
+
+        // Reported from its lowest points only
+        bool lowest = (relation.points.size() > base);
+        for (auto it = begin(below); lowest && it != end(below); ++it) {
+            test.back() = *it;
+            lowest = !holds(batch, incidence, test);
+        }
+        if (lowest)
+            relations->push_back(relation);
+        above.swap(rest);
+    }
+}
+
+bool GeoDiscovery::holds(GeoBatch* batch, Incidence incidence, const vector<unsigned int>& points) {
+    vector<unsigned int> tested;
+    for (auto it = begin(points); it != end(points); ++it)
+        tested.push_back(pids[*it]);
+    vector<signed char> sign(samples);
+    vector<unsigned char> verdict(samples);
+    GeoChecker::decide(batch, incidence, tested, tolerance, &sign[0], &verdict[0]);
+
+    bool tested_once = false;
+    for (unsigned int k = 0; k < samples; ++k) {
+        if (verdict[k] == GeoChecker::FAILED)
+            return false;
+        tested_once |= (verdict[k] == 0);
+    }
+    return tested_once;
+}
+
+bool GeoDiscovery::fail(const string& message) {
+    error = message;
+    return false;
+}
+
+const vector<GeoConjecture>& GeoDiscovery::get_relations() const {
+    return relations;
+}
+
+unsigned int GeoDiscovery::get_points() const {
+    return pids.size();
+}
+
+unsigned long long GeoDiscovery::get_candidates() const {
+    return candidates.load();
+}
+
+double GeoDiscovery::get_elapsed() const {
+    return elapsed;
+}
+
+const string& GeoDiscovery::get_error() const {
+    return error;
+}
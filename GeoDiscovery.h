@@ -0,0 +1,100 @@
+/***************************************************************************
+This class, GeoDiscovery, finds the relations among the points of a scene
+that hold whatever the positions of its free points: the collinear sets of
+three points or more, and the concyclic sets of four points or more. The
+points are first grouped in their current positions, without testing every
+triple or quadruple: for each anchor point, the others are keyed by their
+direction from it (a pseudo-angle), and hashing the keys by quantized cells
+brings the points on a same line through the anchor together. Circles
+through the anchor become lines by an inversion centered on it, so that
+the points on a same circle through two anchors are grouped the same way.
+Each group is then verified on random placements of the free points (see
+GeoChecker and GeoBatch), and split into the relations that hold in every
+placement, so that accidental alignments of the current positions are left
+out. Every relation is reported once, from its lowest points, and points
+that coincide are searched once. The anchors are spread over worker threads.
+****************************************************************************/
+
+#ifndef GEODISCOVERY_H_
+#define GEODISCOVERY_H_
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GeoBatch.h"
+#include "GeoChecker.h"
+#include "GeoComponents.h"
+
+class GeoDiscovery {
+
+public:
+    /** @brief Constructor, takes the (not owned) GeoComponents object, the number of worker threads (at least 1), the number of random placements
+     *  on which the relations are verified, the relative tolerance of the incidences and the seed of the placements. */
+    GeoDiscovery(GeoComponents* geo_components, unsigned int threads = thread::hardware_concurrency(), unsigned int samples = 64,
+                 double tolerance = GeoChecker::TOLERANCE, unsigned int seed = 1);
+
+    /** @brief Finds the relations among the points. Returns false (and finds nothing) if the scene has no free point,
+     *  or if it is in homogeneous coordinates (see get_error). */
+    bool run();
+
+    /** @brief Returns the relations found by the last run, as conjectures that hold, ordered by their points. */
+    const vector<GeoConjecture>& get_relations() const;
+    unsigned int get_points() const; /**< @brief Returns the number of points searched by the last run. */
+    unsigned long long get_candidates() const; /**< @brief Returns the number of groups of the current positions that were verified. */
+    double get_elapsed() const; /**< @brief Returns the duration of the last run, in seconds. */
+    const string& get_error() const; /**< @brief Returns the message of the last error. */
+
+    static const double KEY_TOLERANCE; /**< @brief Difference of pseudo-angles under which two directions are grouped. */
+
+private:
+    /** @brief Relation found by a worker, by indices of the points. */
+    struct Relation {
+        Incidence incidence;
+        vector<unsigned int> points;
+    };
+
+    /** @brief Slot of the hash table of the cells. */
+    struct Slot {
+        unsigned int stamp {0}; //!< Generation in which the slot was taken.
+        unsigned int owner {0}; //!< First position found in the slot.
+    };
+    /** @brief Hash table of the cells of the keys (direct-mapped), with the positions found crowded, emptied by incrementing the generation. */
+    struct Cells {
+        vector<Slot> slots; //!< Slots, a cell taking the one of its low bits.
+        vector<unsigned int> marks; //!< Generation in which each position was found crowded.
+        vector<pair<double, unsigned int>> crowded; //!< Keys and positions found crowded.
+        unsigned int generation {0}; //!< Current generation.
+    };
+    /** @brief Takes the keys of count positions (negative for those left out), and sets groups to the sets of at least two positions whose keys
+     *  are within KEY_TOLERANCE, in increasing order. The keys are hashed by cells of that width, and only the positions sharing
+     *  or neighbouring the cell of another are sorted. */
+    void group(const double key[], unsigned int count, Cells* cells, vector<vector<unsigned int>>* groups) const;
+    /** @brief Takes the anchors of a group (one for lines, two for circles), its points above the last anchor and those below, and adds to relations
+     *  the relations through the anchors that hold in every placement and contain none of the points below. */
+    void split(GeoBatch* batch, Incidence incidence, const vector<unsigned int>& anchors, vector<unsigned int> above, const vector<unsigned int>& below,
+               vector<Relation>* relations);
+    /** @brief Takes the indices of points and returns whether their incidence holds in every placement of the batch in which it can be tested (and in one at least). */
+    bool holds(GeoBatch* batch, Incidence incidence, const vector<unsigned int>& points);
+    /** @brief Worker thread: claims anchors and adds the relations of which they are the lowest point. */
+    void work(GeoBatch* batch, vector<Relation>* relations);
+
+    bool fail(const string& message); /**< @brief Sets the error message and returns false. */
+
+    GeoComponents* geo_components {nullptr}; /**< @brief Constructions searched (not owned). */
+    unsigned int threads {1}; /**< @brief Number of worker threads. */
+    unsigned int samples {64}; /**< @brief Number of placements of the verification. */
+    double tolerance {GeoChecker::TOLERANCE}; /**< @brief Relative tolerance of the incidences. */
+    unsigned int seed {1}; /**< @brief Seed of the placements. */
+
+    vector<unsigned int> pids; /**< @brief Pids of the points searched, in increasing order. */
+    vector<double> x, y; /**< @brief Current positions of the points searched. */
+    std::atomic<unsigned int> next {0}; /**< @brief Next anchor to be claimed by a worker. */
+    std::atomic<unsigned long long> candidates {0}; /**< @brief Number of groups verified. */
+
+    vector<GeoConjecture> relations; /**< @brief Relations of the last run. */
+    double elapsed {0}; /**< @brief Duration of the last run, in seconds. */
+    string error {""}; /**< @brief Message of the last error. */
+};
+
+#endif /* GEODISCOVERY_H_ */
@@ -0,0 +1,265 @@
+/*
+ * GeoEngine.cpp
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include "GeoEngine.h"
+
+GeoEngine::GeoEngine(GeoComponents* geo_components, std::function<void()> on_frame)
+    : geo_components(geo_components), edits(256), on_frame(on_frame) {
+    versions.publish(*geo_components);
+    changes.publish(*geo_components);
+    worker = std::thread(&GeoEngine::run, this);
+}
+
+GeoEngine::~GeoEngine() {
+    running = false;
+    wake.notify_one();
+    worker.join();
+}
+
+void GeoEngine::post_edit(unsigned int pid, double data[], int size) {
+    GeoEdit edit;
+    edit.pid = pid;
+    for (int i = 0; i < size && i < 3; ++i)
+        edit.data[i] = data[i];
+
+    // Keep the order of the edits: a pending overflow goes first
+    if (!flush() || !edits.push(edit)) {
+        overflow = edit;
+        has_overflow = true;
+    }
+
+    wake.notify_one();
+}
+
+bool GeoEngine::flush() {
+    if (has_overflow && edits.push(overflow))
+        has_overflow = false;
+    return !has_overflow;
+}
+
+bool GeoEngine::present(Ui::MainWindow* ui) {
+    if (!fetch())
+        return false;
+
+    return geo_components->display_snapshot(ui, frames.read_buffer());
+}
+
+bool GeoEngine::fetch() {
+    frame_signalled = false;
+
+    // Retry an edit that did not fit before
+    if (has_overflow && flush())
+        wake.notify_one();
+
+    return frames.fetch();
+}
+
+const GeoSnapshot& GeoEngine::get_frame() const {
+    return frames.read_buffer();
+}
+
+void GeoEngine::wait_idle() {
+    held = true;
+    while (!flush()) {
+        wake.notify_one();
+        std::this_thread::yield();
+    }
+
+    // The queue is checked first: once it is empty, any popped edit has already raised busy
+    while (!edits.empty() || busy) {
+        wake.notify_one();
+        std::this_thread::yield();
+    }
+}
+
+void GeoEngine::sync() {
+    versions.publish(*geo_components);
+    changes.publish(*geo_components);
+    held = false;
+}
+
+void GeoEngine::set_input(SharedRing<SharedRecord>* input) {
+    this->input = input;
+    wake.notify_one();
+}
+
+void GeoEngine::set_view(const double view[4]) {
+    {
+        std::lock_guard<std::mutex> lock(view_mutex);
+        copy(view, view + 4, this->view);
+        has_view = true;
+    }
+    view_moved = true;
+    wake.notify_one();
+}
+
+void GeoEngine::set_budget(double budget_ms) {
+    budget = budget_ms;
+    wake.notify_one();
+}
+
+unsigned int GeoEngine::evaluate_view() {
+    if (geo_components->get_evaluation() != Evaluation::PULL || geo_components->get_dirty() == 0)
+        return 0;
+
+    double current[4];
+    {
+        std::lock_guard<std::mutex> lock(view_mutex);
+        if (!has_view)
+            return 0;
+        copy(view, view + 4, current);
+    }
+    return geo_components->evaluate_view(current);
+}
+
+GeoInputStats GeoEngine::get_input_stats() {
+    GeoInputStats current;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        current = stats;
+        stats = GeoInputStats();
+    }
+
+    SharedRing<SharedRecord>* ring = input;
+    unsigned long long dropped = (ring != nullptr) ? ring->get_dropped() : reported_dropped;
+    current.dropped = dropped - reported_dropped;
+    reported_dropped = dropped;
+    if (current.received > current.rejected)
+        current.latency_mean /= current.received - current.rejected;
+    return current;
+}
+
+GeoVersions* GeoEngine::get_versions() {
+    return &versions;
+}
+
+ChangeStream* GeoEngine::get_changes() {
+    return &changes;
+}
+
+void GeoEngine::run() {
+    vector<GeoEdit> batch;
+    vector<qint64> stamps;
+    vector<unsigned int> pids, touched;
+    vector<double> data;
+    GeoEdit edit;
+    SharedRecord records[INPUT_BATCH];
+    unsigned long long rejected = 0;
+
+    while (running) {
+        busy = true;
+
+        // Drain the queue, keeping only the latest edit of each construction
+        batch.clear();
+        while (edits.pop(edit))
+            merge(&batch, edit);
+
+        // Then the shared memory input, unless a structural change is under way
+        stamps.clear();
+        rejected = 0;
+        SharedRing<SharedRecord>* ring = input;
+        if (ring != nullptr && !held) {
+            unsigned int count;
+            while ((count = ring->pop(records, INPUT_BATCH)) > 0) {
+                for (unsigned int i = 0; i < count; ++i) {
+                    if (!geo_components->is_movable(records[i].handle)) {
+                        ++rejected;
+                        continue;
+                    }
+                    edit.pid = records[i].handle;
+                    edit.data[0] = records[i].x;
+                    edit.data[1] = records[i].y;
+                    merge(&batch, edit);
+                    stamps.push_back(records[i].stamp);
+                }
+            }
+        }
+
+        // A new view only matters in pull mode, and not during a structural change
+        bool moved = !held && view_moved.exchange(false);
+        // Same for the constructions left dirty by a frame budget, evaluated when there is nothing else to do
+        double frame_budget = budget;
+        bool scheduled = !held && frame_budget > 0 && geo_components->get_evaluation() == Evaluation::PULL;
+        bool catch_up = scheduled && geo_components->get_dirty() != 0;
+
+        if (batch.empty() && !moved && !catch_up) {
+            // A reader registered since the last pass gets an up to date version
+            if (!held && versions.is_outdated())
+                versions.publish(*geo_components);
+            record(stamps, rejected);
+            busy = false;
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            wake.wait_for(lock, std::chrono::milliseconds(ring != nullptr ? 1 : 2));
+            continue;
+        }
+
+        // Evaluate in a single propagation pass (in pull mode, the constructions in view) and publish
+        auto start = std::chrono::steady_clock::now();
+        touched.clear();
+        if (!batch.empty()) {
+            pids.clear();
+            data.clear();
+            for (auto it = begin(batch); it != end(batch); ++it) {
+                pids.push_back(it->pid);
+                data.insert(data.end(), it->data, it->data + 3);
+            }
+            geo_components->edit_constructions(pids, &data[0], 3, &touched);
+        }
+        unsigned int evaluated = evaluate_view();
+
+        // The rest of the frame budget goes to the constructions out of view
+        if (scheduled) {
+            double left = frame_budget - std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (left > 0)
+                evaluated += geo_components->evaluate_for(left);
+        }
+
+        if (evaluated == 0 && batch.empty()) {
+            record(stamps, rejected);
+            busy = false;
+            continue;
+        }
+
+        // Read versions are copied from the frame rather than taken from the constructions again
+        GeoSnapshot& frame = frames.write_buffer();
+        geo_components->take_snapshot(&frame);
+        versions.publish(frame);
+        frames.publish();
+        changes.publish(*geo_components, touched);
+        record(stamps, rejected);
+
+        busy = false;
+
+        if (on_frame && !frame_signalled.exchange(true))
+            on_frame();
+    }
+}
+
+void GeoEngine::merge(vector<GeoEdit>* batch, const GeoEdit& edit) {
+    for (auto it = batch->begin(); it != batch->end(); ++it) {
+        if (it->pid == edit.pid) {
+            *it = edit;
+            return;
+        }
+    }
+    batch->push_back(edit);
+}
+
+void GeoEngine::record(const vector<qint64>& stamps, unsigned long long rejected) {
+    if (stamps.empty() && rejected == 0)
+        return;
+
+    qint64 now = SharedRing<SharedRecord>::now();
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    stats.received += stamps.size() + rejected;
+    stats.rejected += rejected;
+    for (auto it = begin(stamps); it != end(stamps); ++it) {
+        double latency = (now - *it) / 1e6;
+        stats.latency_mean += latency;
+        stats.latency_max = max(stats.latency_max, latency);
+    }
+}
@@ -0,0 +1,131 @@
+/***************************************************************************
+This class, GeoEngine, evaluates the constructions of a GeoComponents object
+on a dedicated worker thread, so that a slow propagation never freezes the
+GUI. Edits go in through a lock-free single-producer/single-consumer queue,
+and results come out as snapshots through a triple buffer that the GUI
+swaps in before replotting. The GUI thread never blocks on the engine while
+dragging; snapshots that are superseded before the GUI takes them are
+dropped.
+
+Structural changes (adding/removing constructions) are not routed through
+the worker: the GUI calls wait_idle before performing them and sync after.
+Independent points can also be driven by another process through a
+SharedRing, drained by the worker along with the queue (held between
+wait_idle and sync). The values changed by each pass are emitted to the
+sinks subscribed to the ChangeStream.
+In pull mode (see GeoComponents), the worker evaluates for each frame only
+the dirty constructions in the view last set by the GUI, and evaluates the
+ones that come into view when it changes. With a frame budget, the rest of
+the budget goes to the dirty constructions out of view, and the worker
+keeps evaluating them in budget-sized slices whenever it is idle, so that
+the frames become consistent again once the edits stop.
+Every evaluated state is also published as a read version (GeoVersions),
+copied from its frame while a reader is registered, so other threads can
+query the constructions through a GeoReader.
+****************************************************************************/
+
+#ifndef GEOENGINE_H_
+#define GEOENGINE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "ChangeStream.h"
+#include "GeoComponents.h"
+#include "GeoVersions.h"
+#include "SharedRing.h"
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+
+/** @brief An edit of a construction posted to the engine. */
+struct GeoEdit {
+    unsigned int pid {0}; //!< Pid of the construction to edit.
+    double data[3] {0, 0, 0}; //!< New data of the construction, as taken by edit_construction.
+};
+
+/** @brief Statistics of the shared memory input since the previous call to get_input_stats. */
+struct GeoInputStats {
+    unsigned long long received {0}; //!< Records taken from the ring.
+    unsigned long long rejected {0}; //!< Records whose handle is not the pid of a free point, or is the pid of a fixed one.
+    unsigned long long dropped {0}; //!< Records dropped by the producer because the ring was full.
+    double latency_mean {0}; //!< Mean time from production to publication of the frame, in milliseconds.
+    double latency_max {0}; //!< Largest time from production to publication of the frame, in milliseconds.
+};
+
+class GeoEngine {
+
+public:
+    /** @brief Constructor, takes the (not owned) GeoComponents object and starts the worker thread.
+     *  on_frame is called from the worker thread when a new snapshot is available, at most once until the next present. */
+    GeoEngine(GeoComponents* geo_components, std::function<void()> on_frame = nullptr);
+
+    /** @brief GUI side: posts an edit of the construction with the given pid, never blocks. */
+    void post_edit(unsigned int pid, double data[], int size = 2);
+    /** @brief GUI side: swaps in the newest snapshot and updates the figures from it, returns false if there was no new (valid) snapshot. */
+    bool present(Ui::MainWindow* ui);
+    /** @brief GUI side: swaps in the newest snapshot without displaying it, returns false if there was no new snapshot. */
+    bool fetch();
+    /** @brief GUI side: returns the snapshot obtained by the last successful fetch (or present). */
+    const GeoSnapshot& get_frame() const;
+    /** @brief GUI side: waits until every posted edit has been evaluated and holds the input until sync. Must be called before structural changes of the GeoComponents object. */
+    void wait_idle();
+    /** @brief GUI side: publishes a read version after structural changes made directly on the GeoComponents object (after wait_idle), and releases the input. */
+    void sync();
+    /** @brief GUI side: sets the ring drained for edits along with the queue, or none. To delete a ring, set nullptr then call wait_idle and sync. */
+    void set_input(SharedRing<SharedRecord>* input);
+    /** @brief GUI side: sets the view rectangle {x_min, x_max, y_min, y_max} of the frames, whose constructions are evaluated in pull mode. */
+    void set_view(const double view[4]);
+    /** @brief Sets the time budget of a frame in milliseconds (0: none). In pull mode, out of view constructions are then evaluated within the budget, and at idle. */
+    void set_budget(double budget_ms);
+    /** @brief GUI side: takes the statistics of the input since the previous call. */
+    GeoInputStats get_input_stats();
+    /** @brief Returns the read versions, to be used with GeoReader from any thread. */
+    GeoVersions* get_versions();
+    /** @brief Returns the stream of changed values, to which sinks can subscribe from any thread. */
+    ChangeStream* get_changes();
+
+    virtual ~GeoEngine(); /**< @brief Stops and joins the worker thread. */
+
+private:
+    void run(); /**< @brief Loop of the worker thread: drains the queue, evaluates and publishes snapshots. */
+    static void merge(vector<GeoEdit>* batch, const GeoEdit& edit); /**< @brief Adds an edit to a batch, replacing the previous edit of the same construction. */
+    /** @brief Worker side: adds to the statistics the production stamps of the records just published and the number rejected. */
+    void record(const vector<qint64>& stamps, unsigned long long rejected);
+    bool flush(); /**< @brief GUI side: retries pushing the edit that did not fit in the queue, returns false if it still does not fit. */
+    unsigned int evaluate_view(); /**< @brief Worker side: in pull mode, evaluates the dirty constructions in the view, returns the number evaluated. */
+
+    GeoComponents* geo_components {nullptr}; /**< @brief Constructions evaluated by the engine (not owned). */
+    SpscQueue<GeoEdit> edits; /**< @brief Edits posted by the GUI thread, consumed by the worker thread. */
+    TripleBuffer<GeoSnapshot> frames; /**< @brief Snapshots published by the worker thread, consumed by the GUI thread. */
+    GeoVersions versions; /**< @brief Read versions for concurrent queries, published by whichever thread evaluated last. */
+    ChangeStream changes; /**< @brief Values changed by each pass, published along with the versions. */
+
+    GeoEdit overflow; /**< @brief Latest edit that did not fit in the queue (GUI thread only). */
+    bool has_overflow {false}; /**< @brief Indicates whether overflow holds an edit (GUI thread only). */
+
+    std::function<void()> on_frame; /**< @brief Called by the worker when a snapshot is published. */
+    std::atomic<bool> frame_signalled {false}; /**< @brief Indicates that on_frame was called and the GUI has not presented yet. */
+    std::atomic<bool> busy {false}; /**< @brief Indicates that the worker is draining or evaluating. */
+    std::atomic<bool> running {true}; /**< @brief Cleared to stop the worker thread. */
+
+    static const unsigned int INPUT_BATCH = 256; /**< @brief Number of records taken from the ring at once. */
+    std::atomic<SharedRing<SharedRecord>*> input {nullptr}; /**< @brief Ring of edits written by another process, if any. */
+    std::atomic<bool> held {false}; /**< @brief Set between wait_idle and sync, the input is not drained meanwhile. */
+    std::mutex stats_mutex; /**< @brief Protects stats. */
+    GeoInputStats stats; /**< @brief Statistics of the input since the last get_input_stats (dropped is the total). */
+    unsigned long long reported_dropped {0}; /**< @brief Total dropped at the last get_input_stats (GUI thread only). */
+
+    std::mutex view_mutex; /**< @brief Protects view and has_view. */
+    double view[4] {0, 0, 0, 0}; /**< @brief View rectangle of the frames. */
+    bool has_view {false}; /**< @brief Indicates whether the GUI set a view. */
+    std::atomic<bool> view_moved {false}; /**< @brief Set when the view changed and the worker has not evaluated it yet. */
+    std::atomic<double> budget {0}; /**< @brief Time budget of a frame in milliseconds, 0 if none. */
+
+    std::mutex wake_mutex; /**< @brief Used only by the worker to sleep while the queue is empty. */
+    std::condition_variable wake; /**< @brief Notified (without locking) by the GUI when an edit is posted. */
+    std::thread worker; /**< @brief The worker thread. */
+};
+
+#endif /* GEOENGINE_H_ */
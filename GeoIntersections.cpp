@@ -0,0 +1,349 @@
+/*
+ * GeoIntersections.cpp
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "GeoIntersections.h"
+#include "GeoPredicates.h"
+#include "SolverNode.h"
+
+const double GeoIntersections::PAD = 1e-3;
+const unsigned int GeoIntersections::MAX_SIDE;
+const unsigned int GeoIntersections::INCREMENTAL_SHARE;
+
+GeoIntersections::GeoIntersections(GeoComponents* geo_components): geo_components(geo_components) {}
+
+GeoIntersections::~GeoIntersections() {
+    if (figure != nullptr)
+        (figure->parentPlot())->removeGraph(figure);
+}
+
+bool GeoIntersections::update(const GeoSnapshot& snapshot, const double view[4]) {
+    if (snapshot.topology != geo_components->get_topology() || snapshot.size() != geo_components->size())
+        return false;
+
+    tests = 0;
+    recomputed = 0;
+    if (!enabled) {
+        bool changed = !intersections.empty();
+        intersections.clear();
+        curves.clear();
+        cells.clear();
+        built = false;
+        return changed;
+    }
+
+    // New topology: the lines and circles are listed again
+    const double* target = fixed_region ? region : view;
+    bool full = !built || snapshot.topology != topology || !equal(target, target + 4, bounds);
+    if (!built || snapshot.topology != topology) {
+        curves.clear();
+        vector<unsigned int> key;
+        for (unsigned int pid = 0; pid < snapshot.size(); ++pid) {
+            if (geo_components->is_point(pid))
+                continue;
+            geo_components->get_structure(pid, &key);
+            GeoKind kind = static_cast<GeoKind>(key[0]);
+            if (kind != GeoKind::LINE && kind != GeoKind::CIRCLE)
+                continue;
+            curves.push_back(Curve());
+            curves.back().pid = pid;
+            curves.back().circle = (kind == GeoKind::CIRCLE);
+        }
+        topology = snapshot.topology;
+        built = true;
+    }
+    copy(target, target + 4, bounds);
+
+    // Curves whose data changed, the line at infinity (homogeneous coordinates) meets nothing in the plane
+    moved.clear();
+    for (unsigned int c = 0; c < curves.size(); ++c) {
+        Curve& curve = curves[c];
+        const double* data = snapshot.access(curve.pid);
+        bool defined = snapshot.get_well_defined(curve.pid) && (curve.circle || data[0] != 0 || data[1] != 0)
+                && !(curve.pid < excluded.size() && excluded[curve.pid]);
+        if (defined == curve.defined && (!defined || equal(data, data + 3, curve.data)))
+            continue;
+        curve.defined = defined;
+        copy(data, data + 3, curve.data);
+        moved.push_back(c);
+    }
+
+    if (full || moved.size() * INCREMENTAL_SHARE > curves.size()) {
+        rebuild();
+        return true;
+    }
+    if (moved.empty())
+        return false;
+
+    // Only the intersections of the curves that moved are found again
+    moved_pids.resize(snapshot.size(), 0);
+    for (auto it = begin(moved); it != end(moved); ++it)
+        moved_pids[curves[*it].pid] = 1;
+    intersections.erase(remove_if(intersections.begin(), intersections.end(), [&](const Intersection& intersection) {
+        return moved_pids[intersection.first] || moved_pids[intersection.second];
+    }), intersections.end());
+
+    for (auto it = begin(moved); it != end(moved); ++it)
+        erase(*it);
+    for (auto it = begin(moved); it != end(moved); ++it) {
+        moved_pids[curves[*it].pid] = 0;
+        if (curves[*it].defined) {
+            insert(*it);
+            ++recomputed;
+        }
+    }
+    return true;
+}
+
+void GeoIntersections::rebuild() {
+    unsigned int defined = 0;
+    for (auto it = begin(curves); it != end(curves); ++it)
+        defined += it->defined;
+
+    // About 2 sqrt(n) cells per side: the cells crossed grow as n sqrt(n), the pairs sharing a cell without meeting in it as n sqrt(n)
+    side = 1;
+    while (side < MAX_SIDE && side * side < 4 * defined)
+        side *= 2;
+    cell_width = (bounds[1] - bounds[0]) / side;
+    cell_height = (bounds[3] - bounds[2]) / side;
+
+    cells.resize(side * side);
+    for (auto it = begin(cells); it != end(cells); ++it)
+        it->clear();
+    intersections.clear();
+    for (unsigned int c = 0; c < curves.size(); ++c) {
+        curves[c].cells.clear();
+        if (curves[c].defined && cell_width > 0 && cell_height > 0) {
+            insert(c);
+            ++recomputed;
+        }
+    }
+}
+
+void GeoIntersections::insert(unsigned int curve) {
+    rasterize(curves[curve], &curves[curve].cells);
+
+    // Each intersection is kept by the cell containing it, both curves being found in that cell
+    double points[4];
+    for (auto it = begin(curves[curve].cells); it != end(curves[curve].cells); ++it) {
+        vector<unsigned int>& cell_curves = cells[*it];
+        for (auto other = begin(cell_curves); other != end(cell_curves); ++other) {
+            unsigned int first = min(curve, *other), second = max(curve, *other);
+            int count = intersect(curves[first], curves[second], points);
+            ++tests;
+            for (int k = 0; k < count; ++k) {
+                if (cell(points[2 * k], points[2 * k + 1]) != static_cast<int>(*it))
+                    continue;
+                Intersection intersection;
+                intersection.x = points[2 * k];
+                intersection.y = points[2 * k + 1];
+                intersection.first = curves[first].pid;
+                intersection.second = curves[second].pid;
+                intersections.push_back(intersection);
+            }
+        }
+        cell_curves.push_back(curve);
+    }
+}
+
+void GeoIntersections::erase(unsigned int curve) {
+    for (auto it = begin(curves[curve].cells); it != end(curves[curve].cells); ++it) {
+        vector<unsigned int>& cell_curves = cells[*it];
+        auto found = find(cell_curves.begin(), cell_curves.end(), curve);
+        *found = cell_curves.back();
+        cell_curves.pop_back();
+    }
+    curves[curve].cells.clear();
+}
+
+void GeoIntersections::rasterize(const Curve& curve, vector<unsigned int>* crossed) const {
+    crossed->clear();
+    const double* data = curve.data;
+
+    if (!curve.circle) {
+        // In grid coordinates, a u + b v + c = 0: swept along the axis on which it is the flattest
+        double a = data[0] * cell_width, b = data[1] * cell_height, c = data[0] * bounds[0] + data[1] * bounds[2] + data[2];
+        bool transposed = (abs(a) > abs(b));
+        double slope = transposed ? -b / a : -a / b, offset = transposed ? -c / a : -c / b;
+        for (unsigned int i = 0; i < side; ++i) {
+            double low = slope * i + offset, high = slope * (i + 1) + offset;
+            cover(i, min(low, high), max(low, high), transposed, crossed);
+        }
+        sort(crossed->begin(), crossed->end());
+        return;
+    }
+
+    // In grid coordinates, an ellipse: in each column, the range of its upper and lower arcs
+    double center_u = (data[0] - bounds[0]) / cell_width, center_v = (data[1] - bounds[2]) / cell_height;
+    double radius_u = data[2] / cell_width, radius_v = data[2] / cell_height;
+    auto half_height = [&](double u) {
+        double t = (radius_u > 0) ? (u - center_u) / radius_u : 0;
+        return radius_v * sqrt(max(0.0, 1 - t * t));
+    };
+    double first = max(floor(center_u - radius_u - PAD), 0.0), last = min(floor(center_u + radius_u + PAD), side - 1.0);
+    for (double i = first; i <= last; ++i) {
+        double u0 = min(max(i, center_u - radius_u), center_u + radius_u), u1 = max(min(i + 1, center_u + radius_u), center_u - radius_u);
+        double h0 = half_height(u0), h1 = half_height(u1);
+        double low = min(h0, h1), high = (u0 <= center_u && center_u <= u1) ? radius_v : max(h0, h1);
+        cover(static_cast<unsigned int>(i), center_v + low, center_v + high, false, crossed);
+        cover(static_cast<unsigned int>(i), center_v - high, center_v - low, false, crossed);
+    }
+    sort(crossed->begin(), crossed->end());
+    crossed->erase(unique(crossed->begin(), crossed->end()), crossed->end());
+}
+
+void GeoIntersections::cover(unsigned int line, double low, double high, bool transposed, vector<unsigned int>* crossed) const {
+    low -= PAD;
+    high += PAD;
+    if (!(low <= high && high >= 0 && low < side))
+        return;
+    unsigned int first = static_cast<unsigned int>(max(floor(low), 0.0)), last = static_cast<unsigned int>(min(floor(high), side - 1.0));
+    for (unsigned int k = first; k <= last; ++k)
+        crossed->push_back(transposed ? line * side + k : k * side + line);
+}
+
+int GeoIntersections::intersect(const Curve& first, const Curve& second, double points[4]) {
+    if (!first.circle && !second.circle) {
+        if (GeoPredicates::crossing(first.data, second.data) == 0)
+            return 0;
+        double a1 = first.data[0], b1 = first.data[1], c1 = first.data[2];
+        double a2 = second.data[0], b2 = second.data[1], c2 = second.data[2];
+        double delta = a1 * b2 - b1 * a2;
+        points[0] = (- c1 * b2 + b1 * c2) / delta;
+        points[1] = (- a1 * c2 + c1 * a2) / delta;
+        return 1;
+    }
+
+    double roots[6];
+    bool defined[2];
+    if (first.circle && second.circle)
+        SolverNode::circle_circle<double>(first.data, second.data, roots, defined);
+    else if (first.circle)
+        SolverNode::line_circle<double>(second.data, first.data, roots, defined);
+    else
+        SolverNode::line_circle<double>(first.data, second.data, roots, defined);
+
+    // Tangent curves meet once
+    int count = 0;
+    for (int k = 0; k < 2; ++k) {
+        if (!defined[k] || (k == 1 && count == 1 && roots[3] == points[0] && roots[4] == points[1]))
+            continue;
+        points[2 * count] = roots[3 * k];
+        points[2 * count + 1] = roots[3 * k + 1];
+        ++count;
+    }
+    return count;
+}
+
+int GeoIntersections::cell(double x, double y) const {
+    double u = (x - bounds[0]) / cell_width, v = (y - bounds[2]) / cell_height;
+    if (!(u >= 0 && u < side && v >= 0 && v < side))
+        return -1;
+    return static_cast<int>(v) * side + static_cast<int>(u);
+}
+
+bool GeoIntersections::nearest_curve(double x, double y, double distance, unsigned int* pid, double projection[2]) const {
+    if (!built || cells.size() != side * side || !(cell_width > 0 && cell_height > 0))
+        return false;
+
+    // Cells overlapping the square around the position, a curve within the distance crosses one of them
+    double low_u = floor((x - distance - bounds[0]) / cell_width), high_u = floor((x + distance - bounds[0]) / cell_width);
+    double low_v = floor((y - distance - bounds[2]) / cell_height), high_v = floor((y + distance - bounds[2]) / cell_height);
+    if (!(high_u >= 0 && low_u < side && high_v >= 0 && low_v < side))
+        return false;
+    unsigned int first_u = static_cast<unsigned int>(max(low_u, 0.0)), last_u = static_cast<unsigned int>(min(high_u, side - 1.0));
+    unsigned int first_v = static_cast<unsigned int>(max(low_v, 0.0)), last_v = static_cast<unsigned int>(min(high_v, side - 1.0));
+
+    double best = distance;
+    bool found = false;
+    for (unsigned int v = first_v; v <= last_v; ++v) {
+        for (unsigned int u = first_u; u <= last_u; ++u) {
+            const vector<unsigned int>& cell_curves = cells[v * side + u];
+            for (auto it = begin(cell_curves); it != end(cell_curves); ++it) {
+                const double* data = curves[*it].data;
+                double gap, foot_x, foot_y;
+                if (!curves[*it].circle) {
+                    // Unit normal: the signed distance is the value of the equation
+                    double t = data[0] * x + data[1] * y + data[2];
+                    gap = abs(t);
+                    foot_x = x - t * data[0];
+                    foot_y = y - t * data[1];
+                } else {
+                    double delta_x = x - data[0], delta_y = y - data[1], radial = sqrt(delta_x * delta_x + delta_y * delta_y);
+                    if (!(radial > 0))
+                        continue;
+                    gap = abs(radial - data[2]);
+                    foot_x = data[0] + delta_x * data[2] / radial;
+                    foot_y = data[1] + delta_y * data[2] / radial;
+                }
+                if (gap > best)
+                    continue;
+                best = gap;
+                found = true;
+                *pid = curves[*it].pid;
+                projection[0] = foot_x;
+                projection[1] = foot_y;
+            }
+        }
+    }
+    return found;
+}
+
+void GeoIntersections::draw(Ui::MainWindow* ui) {
+    if (figure == nullptr) { //Initialization
+        figure = ui->custom_plot->addGraph();
+        figure->setLineStyle(QCPGraph::lsNone);
+        figure->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCross, QColor(255, 200, 0), 7));
+        figure->setLayer("front");
+        figure->setSelectable(QCP::stNone);
+    }
+
+    QVector<double> x, y;
+    x.reserve(intersections.size());
+    y.reserve(intersections.size());
+    for (auto it = begin(intersections); it != end(intersections); ++it) {
+        x.push_back(it->x);
+        y.push_back(it->y);
+    }
+    figure->setData(x, y);
+}
+
+void GeoIntersections::set_enabled(bool enabled) {
+    this->enabled = enabled;
+}
+
+bool GeoIntersections::get_enabled() const {
+    return enabled;
+}
+
+void GeoIntersections::set_region(const double region[4]) {
+    copy(region, region + 4, this->region);
+    fixed_region = true;
+}
+
+void GeoIntersections::clear_region() {
+    fixed_region = false;
+}
+
+void GeoIntersections::set_excluded(const vector<unsigned int>& pids) {
+    excluded.assign(geo_components->size(), 0);
+    for (auto it = begin(pids); it != end(pids); ++it) {
+        if (*it < excluded.size())
+            excluded[*it] = 1;
+    }
+}
+
+const vector<GeoIntersections::Intersection>& GeoIntersections::get_intersections() const {
+    return intersections;
+}
+
+unsigned long long GeoIntersections::get_tests() const {
+    return tests;
+}
+
+unsigned int GeoIntersections::get_recomputed() const {
+    return recomputed;
+}
@@ -0,0 +1,102 @@
+/***************************************************************************
+This class, GeoIntersections, finds every intersection among the lines and
+circles of a scene within a region (the view unless one is set), without
+creating intersection points: the results are kept in a compact array and
+drawn as a single plottable. The region is divided into a grid of cells,
+every curve is rasterized into the cells it crosses, and only the curves
+sharing a cell are intersected, each intersection being kept by the cell
+that contains it. The work thus follows the number of curves crossing the
+region and of intersections in it, rather than the square of the number of
+curves in the scene.
+
+Between updates, only the curves whose data changed are rasterized and
+intersected again (dragging a point moves the few curves depending on it),
+the grid being rebuilt when the region or the topology changes, or when
+many curves moved.
+****************************************************************************/
+
+#ifndef GEOINTERSECTIONS_H_
+#define GEOINTERSECTIONS_H_
+
+#include <vector>
+#include "GeoComponents.h"
+
+class GeoIntersections {
+
+public:
+    /** @brief Intersection of two curves. */
+    struct Intersection {
+        double x, y; //!< Coordinates of the intersection.
+        unsigned int first, second; //!< Pids of the two curves, the lower one first.
+    };
+
+    GeoIntersections(GeoComponents* geo_components); /**< @brief Constructor, takes the (not owned) GeoComponents object. */
+
+    /** @brief Takes a snapshot and the view rectangle {x_min, x_max, y_min, y_max}, and updates the intersections in the region,
+     *  incrementally if only a few curves moved. Returns whether they changed. */
+    bool update(const GeoSnapshot& snapshot, const double view[4]);
+    void draw(Ui::MainWindow* ui); /**< @brief Updates the plottable of the intersections (empty while the engine is disabled). */
+
+    void set_enabled(bool enabled); /**< @brief Enables or disables the engine, it takes effect on the next update. */
+    bool get_enabled() const; /**< @brief Returns whether the engine is enabled. */
+    /** @brief Sets the region {x_min, x_max, y_min, y_max} searched instead of the view, it takes effect on the next update. */
+    void set_region(const double region[4]);
+    void clear_region(); /**< @brief Searches the view again, from the next update. */
+    /** @brief Takes pids of lines and circles that are left out (those moving with a dragged point, see GeoSnapping), it takes effect on the next update. */
+    void set_excluded(const vector<unsigned int>& pids);
+
+    /** @brief Takes a position and a distance, and returns whether a curve of the grid is within that distance.
+     *  Sets pid to the nearest one and projection to the nearest point on it. Only the cells around the position are searched. */
+    bool nearest_curve(double x, double y, double distance, unsigned int* pid, double projection[2]) const;
+
+    const vector<Intersection>& get_intersections() const; /**< @brief Returns the intersections found, in no particular order. */
+    unsigned long long get_tests() const; /**< @brief Returns the number of pairs of curves intersected by the last update. */
+    unsigned int get_recomputed() const; /**< @brief Returns the number of curves rasterized by the last update, all of them when the grid was rebuilt. */
+
+    virtual ~GeoIntersections(); /**< @brief Removes the plottable from the plot. */
+
+private:
+    /** @brief Line or circle of the scene. */
+    struct Curve {
+        unsigned int pid {0}; //!< Pid of the construction.
+        bool circle {false}; //!< Indicates whether it is a circle rather than a line.
+        bool defined {false}; //!< Indicates whether it was well-defined (and a finite line).
+        double data[3] {0, 0, 0}; //!< Data with which it was rasterized (see LineNode and CircleNode).
+        vector<unsigned int> cells; //!< Cells it crosses, in increasing order.
+    };
+    static const unsigned int MAX_SIDE = 256; /**< @brief Maximum number of cells along each side of the grid. */
+    static const unsigned int INCREMENTAL_SHARE = 4; /**< @brief The grid is rebuilt when more than one curve in INCREMENTAL_SHARE moved. */
+    static const double PAD; /**< @brief Margin of the rasterization, in cells, so that the cell of a computed intersection is crossed by both curves. */
+
+    void rebuild(); /**< @brief Sizes the grid for the curves and finds every intersection again. */
+    void insert(unsigned int curve); /**< @brief Rasterizes a curve, intersects it with the curves sharing its cells and adds it to them. */
+    void erase(unsigned int curve); /**< @brief Removes a curve from its cells. */
+    void rasterize(const Curve& curve, vector<unsigned int>* crossed) const; /**< @brief Sets crossed to the cells crossed by a curve, in increasing order. */
+    /** @brief Takes a range of grid coordinates along one axis, and adds to crossed the cells of the given column (or row, if transposed) that it covers. */
+    void cover(unsigned int line, double low, double high, bool transposed, vector<unsigned int>* crossed) const;
+    /** @brief Takes two curves, sets points to their intersections {x, y, x, y}, and returns their number. */
+    static int intersect(const Curve& first, const Curve& second, double points[4]);
+    int cell(double x, double y) const; /**< @brief Returns the cell containing (x, y), -1 if it is outside the grid. */
+
+    GeoComponents* geo_components {nullptr}; /**< @brief Constructions searched (not owned). */
+    bool enabled {false}; /**< @brief Indicates whether the engine is enabled. */
+    bool fixed_region {false}; /**< @brief Indicates whether region is searched rather than the view. */
+    double region[4] {0, 0, 0, 0}; /**< @brief Region set by set_region. */
+    vector<char> excluded; /**< @brief Indicates whether each pid is left out. */
+    bool built {false}; /**< @brief Indicates whether the grid holds the curves of the current topology. */
+    unsigned long topology {0}; /**< @brief Topology of the curves. */
+    double bounds[4] {0, 0, 0, 0}; /**< @brief Rectangle {x_min, x_max, y_min, y_max} covered by the grid. */
+    unsigned int side {1}; /**< @brief Number of cells along each side of the grid. */
+    double cell_width {1}, cell_height {1}; /**< @brief Size of a cell in plot coordinates. */
+
+    vector<Curve> curves; /**< @brief Lines and circles of the scene, in increasing order of pid. */
+    vector<vector<unsigned int>> cells; /**< @brief Curves crossing each cell (row-major), by index in curves. */
+    vector<unsigned int> moved; /**< @brief Scratch list of the curves that moved, by index. */
+    vector<char> moved_pids; /**< @brief Indicates whether each pid moved in the current update. */
+    vector<Intersection> intersections; /**< @brief Intersections found. */
+    unsigned long long tests {0}; /**< @brief Pairs intersected by the last update. */
+    unsigned int recomputed {0}; /**< @brief Curves rasterized by the last update. */
+    QCPGraph* figure {nullptr}; /**< @brief Plottable of the intersections. */
+};
+
+#endif /* GEOINTERSECTIONS_H_ */
@@ -0,0 +1,132 @@
+/*
+ * GeoLoadTest.cpp
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <QJsonArray>
+#include <QJsonObject>
+#include "GeoLoadTest.h"
+#include "GeoServer.h"
+
+namespace {
+
+qint64 now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double percentile(std::vector<double>& values, double p) {
+    if (values.empty())
+        return 0;
+    size_t k = std::min(values.size() - 1, static_cast<size_t>(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+}
+
+GeoLoadTest::GeoLoadTest(const QString& name): name(name) {}
+
+bool GeoLoadTest::run(const std::vector<double>& rates, double seconds, std::ostream& out) {
+    socket.connectToServer(name);
+    if (!socket.waitForConnected(3000))
+        return false;
+
+    // Scene: concentric circles with the tangents from a moving point
+    std::string script = "O = point 0 0\nP = point 10 10\n";
+    for (int k = 1; k <= 50; ++k) {
+        std::string i = std::to_string(k);
+        script += "A" + i + " = point 0 " + std::to_string(k) + "\n";
+        script += "C" + i + " = circle O A" + i + "\n";
+        script += "T" + i + " = tangent P C" + i + "\n";
+        script += "U" + i + " = tangent P C" + i + " 2\n";
+    }
+    QJsonObject build;
+    build.insert("id", 0);
+    build.insert("op", "build");
+    build.insert("scene", "load");
+    build.insert("script", QString::fromStdString(script));
+    socket.write(GeoServer::frame(build));
+
+    QJsonObject response;
+    while (GeoServer::unframe(&buffer, &response) == 0) {
+        if (!socket.waitForReadyRead(3000))
+            return false;
+        buffer.append(socket.readAll());
+    }
+    if (!response.value("ok").toBool())
+        return false;
+
+    out << "rate/s\tsent\tanswered\tp50 ms\tp99 ms" << std::endl;
+    for (auto it = rates.begin(); it != rates.end(); ++it) {
+        std::vector<double> latencies;
+        measure(*it, seconds, &latencies);
+        unsigned int answered = latencies.size();
+        double p50 = percentile(latencies, 0.50), p99 = percentile(latencies, 0.99);
+        out << *it << '\t' << sent.size() << '\t' << answered << '\t' << p50 << '\t' << p99 << std::endl;
+    }
+
+    socket.disconnectFromServer();
+    return true;
+}
+
+void GeoLoadTest::measure(double rate, double seconds, std::vector<double>* latencies) {
+    origin += sent.size() + 1;
+    sent.clear();
+
+    qint64 start = now(), period = static_cast<qint64>(1e9 / rate), end = start + static_cast<qint64>(seconds * 1e9);
+    qint64 next = start;
+
+    // Open loop: requests leave on schedule, responses are read in between
+    while (now() < end) {
+        while (next <= now() && next < end) {
+            qint64 id = origin + sent.size();
+            QJsonObject request;
+            request.insert("id", id);
+            request.insert("scene", "load");
+            if (id % 2 == 0) {
+                double angle = 1e-3 * id;
+                request.insert("op", "edit");
+                QJsonArray edits;
+                edits.append(QJsonArray {"P", 60 * cos(angle), 60 * sin(angle)});
+                request.insert("edits", edits);
+            } else {
+                request.insert("op", "query");
+                request.insert("labels", QJsonArray {"T1", "U1", "T50", "U50"});
+            }
+            socket.write(GeoServer::frame(request));
+            sent.push_back(now());
+            next += period;
+        }
+        socket.flush();
+
+        int wait = static_cast<int>(std::max<qint64>(0, std::min(next, end) - now()) / 1000000);
+        if (socket.waitForReadyRead(wait))
+            receive(latencies);
+    }
+
+    // Remaining responses, for at most a second
+    qint64 deadline = now() + 1000000000;
+    while (latencies->size() < sent.size() && now() < deadline) {
+        if (socket.waitForReadyRead(100))
+            receive(latencies);
+    }
+}
+
+unsigned int GeoLoadTest::receive(std::vector<double>* latencies) {
+    buffer.append(socket.readAll());
+
+    unsigned int count = 0;
+    QJsonObject response;
+    while (GeoServer::unframe(&buffer, &response) == 1) {
+        qint64 k = static_cast<qint64>(response.value("id").toDouble(-1)) - origin;
+        if (k < 0 || k >= static_cast<qint64>(sent.size()))
+            continue;
+        latencies->push_back((now() - sent[k]) / 1e6);
+        ++count;
+    }
+    return count;
+}
@@ -0,0 +1,39 @@
+/***************************************************************************
+This class, GeoLoadTest, is a load-test client for GeoServer. It builds a
+scene, then sends edit and query requests at fixed rates (open loop, the
+requests are sent on schedule whether or not the previous ones have been
+answered) and reports the median and 99th percentile latencies per rate.
+****************************************************************************/
+
+#ifndef GEOLOADTEST_H_
+#define GEOLOADTEST_H_
+
+#include <ostream>
+#include <vector>
+#include <QLocalSocket>
+#include <QString>
+
+class GeoLoadTest {
+
+public:
+    /** @brief Constructor, takes the name of the local socket of the server. */
+    GeoLoadTest(const QString& name);
+
+    /** @brief Takes request rates (per second) and the duration of each rate, runs the test and writes one line per rate to out.
+     *  Returns false if the server cannot be reached. */
+    bool run(const std::vector<double>& rates, double seconds, std::ostream& out);
+
+private:
+    /** @brief Sends the requests of one rate and sets latencies (in milliseconds) to those of the answered ones. */
+    void measure(double rate, double seconds, std::vector<double>* latencies);
+    /** @brief Reads the available responses and adds their latencies, returns the number read. */
+    unsigned int receive(std::vector<double>* latencies);
+
+    QString name; /**< @brief Name of the local socket of the server. */
+    QLocalSocket socket; /**< @brief Connection to the server. */
+    QByteArray buffer; /**< @brief Bytes received and not yet making a complete frame. */
+    std::vector<qint64> sent; /**< @brief Send time (nanoseconds) of each request of the current rate, indexed by id. */
+    qint64 origin {0}; /**< @brief Id of the first request of the current rate. */
+};
+
+#endif /* GEOLOADTEST_H_ */
@@ -3,20 +3,50 @@
  *
  */
 
+#include <algorithm>
 #include "GeoNode.h"
 
-const double GeoNode::EPSILON = 1e-8;
-
 GeoNode::GeoNode(int num_parents): num_parents(num_parents) {}
 
 string GeoNode::get_label() const {
 	return label;
 }
 
+bool GeoNode::is_point() const {
+    return false;
+}
+
+void GeoNode::access_homogeneous(double data[]) const {
+    access(data);
+    data[2] = 1;
+}
+
+bool GeoNode::is_finite() const {
+    return true;
+}
+
+void GeoNode::set_precision(Precision precision) {
+    this->precision = precision;
+}
+
+bool GeoNode::is_solver() const {
+    return false;
+}
+
 bool GeoNode::get_well_defined() const {
     return well_defined;
 }
 
+void GeoNode::make_structure(unsigned int kind, unsigned int type, bool symmetric, vector<unsigned int>* key) const {
+    key->clear();
+    key->push_back(kind);
+    key->push_back(type);
+    for (int i = 0; i < num_parents; ++i)
+        key->push_back(parents[i]->pid);
+    if (symmetric)
+        sort(key->begin() + 2, key->end());
+}
+
 GeoNode::~GeoNode() {
 	if (num_parents != 0)
 		delete [] parents;
@@ -9,8 +9,10 @@ our geometric constructions are derived.
 #include <iostream>
 #include "ui_mainwindow.h"
 #include "qcustomplot.h"
+#include "GeoScalar.h"
 
 using namespace std;
+class FigurePool;
 class GeoNode {
     friend class GeoComponents; /**< @brief GeoComponents is the container class for all of our constructions. */
 
@@ -18,16 +20,33 @@ public:
     GeoNode(int num_parents = 0); /**< @brief Constructor, takes the number of constructions (parents) that define this construction (child). */
 
     virtual void access(double data[]) const = 0; /**< @brief Takes an array and sets it to be the data members of the construction, the size may vary. */
+    /** @brief Sets data as the homogeneous coordinates {x, y, w} of a construction drawn as a point (w = 0 at infinity), by default its access with w = 1. */
+    virtual void access_homogeneous(double data[]) const;
+    virtual bool is_finite() const; /**< @brief Returns whether the construction has Cartesian coordinates, false for points at infinity (homogeneous coordinates only). */
     string get_label() const; /**< @brief Returns the label of the construction. */
+    virtual bool is_point() const; /**< @brief Returns whether the construction is drawn as a point (points and triangle centers). */
+    virtual bool is_solver() const; /**< @brief Returns whether the construction only solves for roots exposed by its children (see SolverNode). */
     bool get_well_defined() const; /**< @brief Returns whether the current configuration gives a well-defined construction. */
 
     virtual ~GeoNode(); /**< @brief Destructor */
 	
 private:
     virtual void print() const = 0; /**< @brief Prints to console the data components of the construction (Debugging purposes only). */
-    virtual void display(Ui::MainWindow* ui) = 0; /**< @brief Updates the figure representing the construction on the plot. */
+    /** @brief Updates the figure representing the construction on the plot from data (as returned by access) and its well-definedness.
+     *  The figure is taken from the pool the first time the construction has to be seen. */
+    virtual void display(Ui::MainWindow* ui, FigurePool* pool, const double data[], bool defined) = 0;
+    virtual void release(FigurePool* pool) = 0; /**< @brief Gives the figure representing the construction back to the pool, if any. */
+    /** @brief Takes data (as returned by access) and a view rectangle {x_min, x_max, y_min, y_max}, returns whether the figure may be seen in it. */
+    virtual bool in_view(const double data[], const double view[4]) const = 0;
+    /** @brief Takes data (as returned by access) and sets box to the bounding box {x_min, x_max, y_min, y_max} of the figure (infinite for lines). */
+    virtual void bounds(const double data[], double box[4]) const = 0;
     virtual void mutate(double data[]) = 0; /**< @brief Edits the data members of the construction. */
     virtual void update() = 0; /**< @brief Updates the constructions by recalculating the data to adjust to changes on the parents. */
+    /** @brief Sets the scalar type in which the construction is computed from then on, kept in double by default (see GeoScalar.h). */
+    virtual void set_precision(Precision precision);
+    /** @brief Sets key to the structure of the construction {kind, type, parent pids}, used to merge duplicates.
+     *  Returns false if the construction has free parameters (it can be moved apart from an identical one, so it is never merged). */
+    virtual bool structure(vector<unsigned int>* key) const = 0;
     /** @brief Takes a collection of string vectors and adds the label of the construction to the corresponding vector. */
     virtual void labels(vector<string>* point_labels, vector<string>* line_labels, vector<string>* circle_labels, vector<string>* triangle_labels) const = 0;
 
@@ -38,7 +57,13 @@ protected:
     const int num_parents {0}; /**< @brief Number of constructions that defines this construction. */
     const GeoNode** parents {nullptr}; /**< @brief Pointer to the array of constructions that define this construction. */
     bool well_defined {true}; /**< @brief Indicates whether the current configuration gives a well-defined construction. */
-    static const double EPSILON; /** @brief Sets the error tolerance used in our calculations. */
+    bool projective {false}; /**< @brief Indicates whether points and lines are computed in homogeneous coordinates (set by GeoComponents, see Coordinates). */
+    Precision precision {Precision::DOUBLE}; /**< @brief Scalar type in which the construction is computed (set by GeoComponents, see set_precision). */
+    /** @brief Sets key to {kind, type, parent pids}, with the parents sorted if their order does not matter (symmetric). */
+    void make_structure(unsigned int kind, unsigned int type, bool symmetric, vector<unsigned int>* key) const;
+
+public:
+    static const int DATA_SIZE = 9; /**< @brief Size of the largest array filled by access (a triangle), used for fixed-stride snapshots. */
 };
 
 #endif /* GEONODE_H_ */
@@ -0,0 +1,253 @@
+/*
+ * GeoPredicates.cpp
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "GeoPredicates.h"
+
+using namespace std;
+
+const double GeoPredicates::TOLERANCE = 1e-10;
+const double GeoPredicates::SINGLE_TOLERANCE = 1e-4;
+
+namespace {
+
+const double UNIT_ROUNDOFF = numeric_limits<double>::epsilon() / 2;
+const int AMBIGUOUS = 2;
+
+atomic<unsigned long long> evaluations(0), escalations(0);
+
+// Floating-point value with the magnitude of its terms (the same expression on the absolute values, with only additions)
+// and the depth of its evaluation: the rounding error is at most about depth * UNIT_ROUNDOFF * magnitude.
+struct Filtered {
+    double value, magnitude;
+    int depth;
+
+    Filtered(double value): value(value), magnitude(abs(value)), depth(0) {}
+    Filtered(double value, double magnitude, int depth): value(value), magnitude(magnitude), depth(depth) {}
+
+    // Twice the first order bound, which covers the higher order terms and the rounding of the magnitude itself
+    double error() const { return 2 * (depth + 1) * UNIT_ROUNDOFF * magnitude; }
+};
+
+Filtered operator+(const Filtered& x, const Filtered& y) {
+    return Filtered(x.value + y.value, x.magnitude + y.magnitude, max(x.depth, y.depth) + 1);
+}
+
+Filtered operator-(const Filtered& x, const Filtered& y) {
+    return Filtered(x.value - y.value, x.magnitude + y.magnitude, max(x.depth, y.depth) + 1);
+}
+
+Filtered operator*(const Filtered& x, const Filtered& y) {
+    return Filtered(x.value * y.value, x.magnitude * y.magnitude, max(x.depth, y.depth) + 1);
+}
+
+// Exact value as a sum of non-overlapping doubles in increasing magnitude, without zeros (Shewchuk's expansions),
+// whose sign is the sign of its largest component. Requires IEEE double arithmetic rounding to nearest.
+struct Expansion {
+    vector<double> components;
+
+    Expansion() {}
+    Expansion(double value) { if (value != 0) components.push_back(value); }
+
+    // Adds a double exactly (grow-expansion)
+    void grow(double b) {
+        vector<double> grown;
+        grown.reserve(components.size() + 1);
+        double q = b;
+        for (auto it = begin(components); it != end(components); ++it) {
+            double sum = q + *it;
+            double b_virtual = sum - q;
+            double a_virtual = sum - b_virtual;
+            double error = (q - a_virtual) + (*it - b_virtual);
+            q = sum;
+            if (error != 0)
+                grown.push_back(error);
+        }
+        if (q != 0)
+            grown.push_back(q);
+        components.swap(grown);
+    }
+
+    int sign() const { return components.empty() ? 0 : (components.back() > 0 ? 1 : -1); }
+};
+
+Expansion operator+(const Expansion& x, const Expansion& y) {
+    Expansion sum(x);
+    for (auto it = begin(y.components); it != end(y.components); ++it)
+        sum.grow(*it);
+    return sum;
+}
+
+Expansion operator-(const Expansion& x, const Expansion& y) {
+    Expansion sum(x);
+    for (auto it = begin(y.components); it != end(y.components); ++it)
+        sum.grow(-*it);
+    return sum;
+}
+
+Expansion operator*(const Expansion& x, const Expansion& y) {
+    // Each product of components is exactly the rounded product plus its error (fused multiply-add)
+    Expansion product;
+    for (auto i = begin(x.components); i != end(x.components); ++i) {
+        for (auto j = begin(y.components); j != end(y.components); ++j) {
+            double rounded = *i * *j;
+            product.grow(fma(*i, *j, -rounded));
+            product.grow(rounded);
+        }
+    }
+    return product;
+}
+
+// Expressions of the predicates, evaluated once with Filtered and, if ambiguous, again with Expansion
+template <class T>
+T orientation_value(const double a[2], const double b[2], const double c[2]) {
+    return (T(b[0]) - T(a[0])) * (T(c[1]) - T(a[1])) - (T(b[1]) - T(a[1])) * (T(c[0]) - T(a[0]));
+}
+
+template <class T>
+T distance_value(const double a[2], const double b[2]) {
+    T delta_x = T(b[0]) - T(a[0]), delta_y = T(b[1]) - T(a[1]);
+    return delta_x * delta_x + delta_y * delta_y;
+}
+
+template <class T>
+T crossing_value(const double line1[3], const double line2[3]) {
+    return T(line1[0]) * T(line2[1]) - T(line1[1]) * T(line2[0]);
+}
+
+template <class T>
+T line_circle_value(const double line[3], const double circle[3]) {
+    T t = T(line[0]) * T(circle[0]) + T(line[1]) * T(circle[1]) + T(line[2]);
+    return T(circle[2]) * T(circle[2]) - t * t;
+}
+
+template <class T>
+T point_circle_value(const double point[2], const double circle[3]) {
+    return distance_value<T>(point, circle) - T(circle[2]) * T(circle[2]);
+}
+
+template <class T>
+T circle_circle_outer_value(const double circle1[3], const double circle2[3]) {
+    T sum = T(circle1[2]) + T(circle2[2]);
+    return sum * sum - distance_value<T>(circle1, circle2);
+}
+
+template <class T>
+T circle_circle_inner_value(const double circle1[3], const double circle2[3]) {
+    T difference = T(circle1[2]) - T(circle2[2]);
+    return distance_value<T>(circle1, circle2) - difference * difference;
+}
+
+template <class T>
+T incircle_value(const double a[2], const double b[2], const double c[2], const double d[2]) {
+    T a_x = T(a[0]) - T(d[0]), a_y = T(a[1]) - T(d[1]);
+    T b_x = T(b[0]) - T(d[0]), b_y = T(b[1]) - T(d[1]);
+    T c_x = T(c[0]) - T(d[0]), c_y = T(c[1]) - T(d[1]);
+    T a_lift = a_x * a_x + a_y * a_y, b_lift = b_x * b_x + b_y * b_y, c_lift = c_x * c_x + c_y * c_y;
+    return a_lift * (b_x * c_y - c_x * b_y) + b_lift * (c_x * a_y - a_x * c_y) + c_lift * (a_x * b_y - b_x * a_y);
+}
+
+template <class T>
+T compare_squares_value(double a, double b) {
+    return T(a) * T(a) - T(b) * T(b);
+}
+
+// Sign of the floating-point value if its error bound does not straddle the tolerance, AMBIGUOUS otherwise
+int filter(const Filtered& value, double threshold) {
+    double error = value.error();
+    if (abs(value.value) > (threshold + error) * (1 + 4 * UNIT_ROUNDOFF))
+        return (value.value > 0) ? 1 : -1;
+    if ((abs(value.value) + error) * (1 + 4 * UNIT_ROUNDOFF) <= threshold)
+        return 0;
+    return AMBIGUOUS;
+}
+
+// Sign of the exact value, 0 if its absolute value does not exceed the threshold
+int decide(const Expansion& value, double threshold) {
+    int sign = value.sign();
+    if (sign == 0)
+        return 0;
+    Expansion excess(value);
+    excess.grow(-sign * threshold);
+    return (excess.sign() == sign) ? sign : 0;
+}
+
+template <class Value, class Exact>
+int predicate(Value floating, Exact exact, double tolerance) {
+    evaluations.fetch_add(1, memory_order_relaxed);
+    Filtered value = floating();
+    double threshold = tolerance * value.magnitude;
+    int sign = filter(value, threshold);
+    if (sign != AMBIGUOUS)
+        return sign;
+
+    escalations.fetch_add(1, memory_order_relaxed);
+    return decide(exact(), threshold);
+}
+
+}
+
+int GeoPredicates::orientation(const double a[2], const double b[2], const double c[2], double tolerance) {
+    return predicate([&]() { return orientation_value<Filtered>(a, b, c); },
+                     [&]() { return orientation_value<Expansion>(a, b, c); }, tolerance);
+}
+
+bool GeoPredicates::coincident(const double a[2], const double b[2], double tolerance) {
+    // The squared distance is compared with the squared tolerance
+    return predicate([&]() { return distance_value<Filtered>(a, b); },
+                     [&]() { return distance_value<Expansion>(a, b); }, tolerance * tolerance) == 0;
+}
+
+int GeoPredicates::crossing(const double line1[3], const double line2[3], double tolerance) {
+    return predicate([&]() { return crossing_value<Filtered>(line1, line2); },
+                     [&]() { return crossing_value<Expansion>(line1, line2); }, tolerance);
+}
+
+int GeoPredicates::line_circle(const double line[3], const double circle[3], double tolerance) {
+    return predicate([&]() { return line_circle_value<Filtered>(line, circle); },
+                     [&]() { return line_circle_value<Expansion>(line, circle); }, tolerance);
+}
+
+int GeoPredicates::point_circle(const double point[2], const double circle[3], double tolerance) {
+    return predicate([&]() { return point_circle_value<Filtered>(point, circle); },
+                     [&]() { return point_circle_value<Expansion>(point, circle); }, tolerance);
+}
+
+int GeoPredicates::circle_circle_outer(const double circle1[3], const double circle2[3], double tolerance) {
+    return predicate([&]() { return circle_circle_outer_value<Filtered>(circle1, circle2); },
+                     [&]() { return circle_circle_outer_value<Expansion>(circle1, circle2); }, tolerance);
+}
+
+int GeoPredicates::circle_circle_inner(const double circle1[3], const double circle2[3], double tolerance) {
+    return predicate([&]() { return circle_circle_inner_value<Filtered>(circle1, circle2); },
+                     [&]() { return circle_circle_inner_value<Expansion>(circle1, circle2); }, tolerance);
+}
+
+int GeoPredicates::incircle(const double a[2], const double b[2], const double c[2], const double d[2], double tolerance) {
+    return predicate([&]() { return incircle_value<Filtered>(a, b, c, d); },
+                     [&]() { return incircle_value<Expansion>(a, b, c, d); }, tolerance);
+}
+
+int GeoPredicates::compare_squares(double a, double b, double tolerance) {
+    return predicate([&]() { return compare_squares_value<Filtered>(a, b); },
+                     [&]() { return compare_squares_value<Expansion>(a, b); }, tolerance);
+}
+
+unsigned long long GeoPredicates::get_evaluations() {
+    return evaluations.load(memory_order_relaxed);
+}
+
+unsigned long long GeoPredicates::get_escalations() {
+    return escalations.load(memory_order_relaxed);
+}
+
+void GeoPredicates::reset_counts() {
+    evaluations.store(0, memory_order_relaxed);
+    escalations.store(0, memory_order_relaxed);
+}
@@ -0,0 +1,54 @@
+/***************************************************************************
+This class, GeoPredicates, decides the signs on which the well-definedness
+of the constructions depends: orientation of three points, coincidence of
+two points, parallelism of two lines, the position of a line or a point
+relative to a circle (tangency), and of a point relative to the circle
+through three others. A value counts as zero when it is within
+a tolerance (TOLERANCE by default) of the magnitude of its terms, so that
+the decisions do not depend on the scale of the scene. Each value is first
+evaluated in floating point with an error bound, which decides almost every
+case; only when the bound straddles the tolerance is the value evaluated
+again in exact arithmetic (escalation). The predicates count their
+evaluations and escalations.
+****************************************************************************/
+
+#ifndef GEOPREDICATES_H_
+#define GEOPREDICATES_H_
+
+class GeoPredicates {
+
+public:
+    /** @brief Returns the sign of the orientation of a, b, c: 1 counterclockwise, -1 clockwise, 0 collinear. */
+    static int orientation(const double a[2], const double b[2], const double c[2], double tolerance = TOLERANCE);
+    /** @brief Returns whether the points a and b coincide. */
+    static bool coincident(const double a[2], const double b[2], double tolerance = TOLERANCE);
+    /** @brief Returns the sign of the cross product of the normals of two lines {a, b, c}, 0 if they are parallel. */
+    static int crossing(const double line1[3], const double line2[3], double tolerance = TOLERANCE);
+    /** @brief Returns the sign of r^2 - t^2, t being the distance from the center of the circle to the line (unit normal):
+     *  1 secant, 0 tangent, -1 apart. */
+    static int line_circle(const double line[3], const double circle[3], double tolerance = TOLERANCE);
+    /** @brief Returns the sign of d^2 - r^2, d being the distance from the point to the center: 1 outside, 0 on the circle, -1 inside. */
+    static int point_circle(const double point[2], const double circle[3], double tolerance = TOLERANCE);
+    /** @brief Returns the sign of (R + r)^2 - d^2, d being the distance between the centers: 1 overlapping, 0 tangent, -1 apart. */
+    static int circle_circle_outer(const double circle1[3], const double circle2[3], double tolerance = TOLERANCE);
+    /** @brief Returns the sign of d^2 - (R - r)^2, d being the distance between the centers: 1 overlapping, 0 tangent, -1 nested. */
+    static int circle_circle_inner(const double circle1[3], const double circle2[3], double tolerance = TOLERANCE);
+    /** @brief Returns the sign of the incircle determinant of a, b, c, d: 1 if d is inside the circle through a, b, c when they are counterclockwise
+     *  (outside if clockwise), -1 on the other side, 0 if the four points are concyclic. */
+    static int incircle(const double a[2], const double b[2], const double c[2], const double d[2], double tolerance = TOLERANCE);
+    /** @brief Returns the sign of a^2 - b^2. */
+    static int compare_squares(double a, double b, double tolerance = TOLERANCE);
+
+    static unsigned long long get_evaluations(); /**< @brief Returns the number of predicates evaluated, by all threads. */
+    static unsigned long long get_escalations(); /**< @brief Returns the number of predicates that needed exact arithmetic, by all threads. */
+    static void reset_counts(); /**< @brief Sets both counts back to 0. */
+
+    static const double TOLERANCE; /**< @brief Relative tolerance under which a value counts as zero. */
+    static const double SINGLE_TOLERANCE; /**< @brief Relative tolerance for values computed in float (see GeoScalar.h). */
+    /** @brief Returns the tolerance suited to values computed in the scalar type T. */
+    template <class T> static double tolerance() { return TOLERANCE; }
+};
+
+template <> inline double GeoPredicates::tolerance<float>() { return SINGLE_TOLERANCE; }
+
+#endif /* GEOPREDICATES_H_ */
@@ -0,0 +1,110 @@
+/***************************************************************************
+This file defines the scalar types in which the construction kernels can be
+evaluated (see GeoComponents::set_precision): float for fast previews,
+double by default, and DoubleDouble for deep zooms and near-degenerate
+configurations. The constructions keep their data in double whatever the
+precision: their inputs are converted to the scalar type and their results
+rounded back to double. DoubleDouble represents a number as the unevaluated
+sum hi + lo of two doubles (about 106 bits of mantissa), with the usual
+error-free transformations; it needs IEEE double arithmetic rounding to
+nearest.
+****************************************************************************/
+
+#ifndef GEOSCALAR_H_
+#define GEOSCALAR_H_
+
+#include <cmath>
+
+/** @brief Scalar types of the construction kernels. */
+enum class Precision {
+    SINGLE, //!< float: half the width of double, about 7 significant digits.
+    DOUBLE, //!< double (default).
+    DOUBLE_DOUBLE //!< DoubleDouble: about 32 significant digits, several times slower.
+};
+
+class DoubleDouble {
+
+public:
+    DoubleDouble(double value = 0): hi(value), lo(0) {} /**< @brief Constructor, exact. */
+    DoubleDouble(double hi, double lo): hi(hi), lo(lo) {} /**< @brief Constructor from the components, |lo| being at most half an ulp of hi. */
+
+    explicit operator double() const { return hi + lo; } /**< @brief Rounds to the nearest double. */
+
+    double hi; /**< @brief Leading component, the value rounded to double. */
+    double lo; /**< @brief Trailing component, the rounding error of hi. */
+
+    /** @brief Returns a + b as hi + lo exactly, hi being the rounded sum. */
+    static DoubleDouble two_sum(double a, double b) {
+        double s = a + b, v = s - a;
+        return DoubleDouble(s, (a - (s - v)) + (b - v));
+    }
+    /** @brief Returns a + b as hi + lo exactly, provided |a| >= |b|. */
+    static DoubleDouble quick_two_sum(double a, double b) {
+        double s = a + b;
+        return DoubleDouble(s, b - (s - a));
+    }
+    /** @brief Returns a * b as hi + lo exactly, hi being the rounded product. */
+    static DoubleDouble two_product(double a, double b) {
+        double p = a * b;
+        return DoubleDouble(p, std::fma(a, b, -p));
+    }
+};
+
+inline DoubleDouble operator-(const DoubleDouble& x) {
+    return DoubleDouble(-x.hi, -x.lo);
+}
+
+inline DoubleDouble operator+(const DoubleDouble& x, const DoubleDouble& y) {
+    DoubleDouble s = DoubleDouble::two_sum(x.hi, y.hi), t = DoubleDouble::two_sum(x.lo, y.lo);
+    s = DoubleDouble::quick_two_sum(s.hi, s.lo + t.hi);
+    return DoubleDouble::quick_two_sum(s.hi, s.lo + t.lo);
+}
+
+inline DoubleDouble operator-(const DoubleDouble& x, const DoubleDouble& y) {
+    return x + (-y);
+}
+
+inline DoubleDouble operator*(const DoubleDouble& x, const DoubleDouble& y) {
+    DoubleDouble p = DoubleDouble::two_product(x.hi, y.hi);
+    return DoubleDouble::quick_two_sum(p.hi, p.lo + (x.hi * y.lo + x.lo * y.hi));
+}
+
+inline DoubleDouble operator/(const DoubleDouble& x, const DoubleDouble& y) {
+    // Long division: each partial quotient corrects the remainder of the previous one
+    double q1 = x.hi / y.hi;
+    DoubleDouble r = x - y * q1;
+    double q2 = r.hi / y.hi;
+    r = r - y * q2;
+    double q3 = r.hi / y.hi;
+    return DoubleDouble::quick_two_sum(q1, q2) + q3;
+}
+
+inline DoubleDouble& operator+=(DoubleDouble& x, const DoubleDouble& y) { return x = x + y; }
+inline DoubleDouble& operator-=(DoubleDouble& x, const DoubleDouble& y) { return x = x - y; }
+inline DoubleDouble& operator*=(DoubleDouble& x, const DoubleDouble& y) { return x = x * y; }
+inline DoubleDouble& operator/=(DoubleDouble& x, const DoubleDouble& y) { return x = x / y; }
+
+inline bool operator<(const DoubleDouble& x, const DoubleDouble& y) { return x.hi < y.hi || (x.hi == y.hi && x.lo < y.lo); }
+inline bool operator>(const DoubleDouble& x, const DoubleDouble& y) { return y < x; }
+inline bool operator<=(const DoubleDouble& x, const DoubleDouble& y) { return !(y < x); }
+inline bool operator>=(const DoubleDouble& x, const DoubleDouble& y) { return !(x < y); }
+inline bool operator==(const DoubleDouble& x, const DoubleDouble& y) { return x.hi == y.hi && x.lo == y.lo; }
+inline bool operator!=(const DoubleDouble& x, const DoubleDouble& y) { return !(x == y); }
+
+inline DoubleDouble abs(const DoubleDouble& x) {
+    return (x.hi < 0) ? -x : x;
+}
+
+inline DoubleDouble copysign(const DoubleDouble& x, const DoubleDouble& y) {
+    return (std::signbit(x.hi) != std::signbit(y.hi)) ? -x : x;
+}
+
+inline DoubleDouble sqrt(const DoubleDouble& x) {
+    // One Newton step from the double square root doubles its precision
+    if (x.hi <= 0)
+        return DoubleDouble(std::sqrt(x.hi));
+    DoubleDouble q = std::sqrt(x.hi);
+    return q + (x - q * q) / (2 * q);
+}
+
+#endif /* GEOSCALAR_H_ */
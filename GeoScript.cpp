@@ -0,0 +1,434 @@
+/*
+ * GeoScript.cpp
+ *
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include "GeoScript.h"
+#include "PointNode.h"
+#include "LineNode.h"
+#include "CircleNode.h"
+#include "TriangleNode.h"
+#include "TriangleCentersNode.h"
+
+GeoScript::GeoScript(GeoComponents* geo_components): geo_components(geo_components) {}
+
+bool GeoScript::run(const string& text) {
+    error.clear();
+    output.clear();
+
+    // The constructions may have changed since the last run
+    index_kinds();
+
+    istringstream input(text);
+    string text_line;
+    vector<string> tokens;
+    line = 0;
+    while (getline(input, text_line)) {
+        ++line;
+        bool valid = tokenize(text_line, &tokens) ? (tokens.empty() || execute(tokens)) : fail("unterminated quote");
+
+        // The commands before the error are still carried out
+        if (!valid) {
+            string message = error;
+            flush();
+            error = message;
+            return false;
+        }
+        commands += !tokens.empty();
+    }
+
+    return flush();
+}
+
+bool GeoScript::run_file(const string& path) {
+    ifstream file(path);
+    if (!file) {
+        line = 0;
+        return fail("cannot read '" + path + "'");
+    }
+
+    stringstream text;
+    text << file.rdbuf();
+    return run(text.str());
+}
+
+bool GeoScript::tokenize(const string& line, vector<string>* tokens) {
+    tokens->clear();
+
+    unsigned int i = 0;
+    while (i < line.size()) {
+        if (isspace(static_cast<unsigned char>(line[i]))) {
+            ++i;
+        } else if (line[i] == '#') {
+            break;
+        } else if (line[i] == '"') {
+            size_t close = line.find('"', i + 1);
+            if (close == string::npos)
+                return false;
+            tokens->push_back(line.substr(i + 1, close - i - 1));
+            i = close + 1;
+        } else {
+            unsigned int start = i;
+            while (i < line.size() && !isspace(static_cast<unsigned char>(line[i])) && line[i] != '#')
+                ++i;
+            tokens->push_back(line.substr(start, i - start));
+        }
+    }
+
+    return true;
+}
+
+bool GeoScript::execute(const vector<string>& tokens) {
+
+    // Creation: label = name arguments
+    if (tokens.size() >= 3 && tokens[1] == "=") {
+        if (!moves.empty() && !flush())
+            return false;
+        return create(tokens[0], tokens[2], vector<string>(tokens.begin() + 3, tokens.end()));
+    }
+
+    const string& name = tokens[0];
+    if (name == "move") {
+        double x, y;
+        if (tokens.size() != 4 || !number(tokens[2], &x) || !number(tokens[3], &y))
+            return fail("usage: move <point> <x> <y>");
+        if (!creations.empty() && !flush())
+            return false;
+
+        unsigned int pid = geo_components->get_pid(tokens[1]);
+        if (pid == static_cast<unsigned int>(-1))
+            return fail("unknown construction '" + tokens[1] + "'");
+        if (kind(tokens[1]) != GeoKind::POINT)
+            return fail("'" + tokens[1] + "' is not a point");
+        if (!geo_components->is_movable(pid))
+            return fail("'" + tokens[1] + "' cannot be moved");
+
+        moves.push_back(pid);
+        coordinates.push_back(x);
+        coordinates.push_back(y);
+        return true;
+    }
+
+    if (name == "remove") {
+        if (tokens.size() != 2)
+            return fail("usage: remove <construction>");
+        if (!flush())
+            return false;
+
+        unsigned int pid = geo_components->get_pid(tokens[1]);
+        if (pid == static_cast<unsigned int>(-1))
+            return fail("unknown construction '" + tokens[1] + "'");
+
+        // Children are removed too, unless it is only the alias of a merged duplicate
+        if (!geo_components->remove_alias(tokens[1]))
+            geo_components->remove_construction(pid);
+        ++passes;
+        index_kinds();
+
+        // Conjectures on a removed point are dropped
+        conjectures.erase(remove_if(conjectures.begin(), conjectures.end(), [&](const GeoConjecture& conjecture) {
+            for (auto it = begin(conjecture.labels); it != end(conjecture.labels); ++it)
+                if (*it == tokens[1] || geo_components->get_pid(*it) == static_cast<unsigned int>(-1))
+                    return true;
+            return false;
+        }), conjectures.end());
+        return true;
+    }
+
+    if (name == "print") {
+        if (tokens.size() != 2)
+            return fail("usage: print <construction>");
+        if (!flush())
+            return false;
+
+        vector<double> values;
+        if (!query(tokens[1], &values))
+            return fail("unknown construction '" + tokens[1] + "'");
+
+        ostringstream text;
+        text << tokens[1];
+        for (auto it = begin(values); it != end(values); ++it)
+            text << ' ' << *it;
+        if (values.empty())
+            text << " undefined";
+        output += text.str() + '\n';
+        return true;
+    }
+
+    if (name == "evaluate") {
+        if (tokens.size() != 2 || (tokens[1] != "push" && tokens[1] != "pull"))
+            return fail("usage: evaluate push|pull");
+        if (!flush())
+            return false;
+
+        geo_components->set_evaluation(tokens[1] == "pull" ? Evaluation::PULL : Evaluation::PUSH);
+        return true;
+    }
+
+    if (name == "coordinates") {
+        if (tokens.size() != 2 || (tokens[1] != "cartesian" && tokens[1] != "homogeneous"))
+            return fail("usage: coordinates cartesian|homogeneous");
+        if (!flush())
+            return false;
+
+        geo_components->set_coordinates(tokens[1] == "homogeneous" ? Coordinates::HOMOGENEOUS : Coordinates::CARTESIAN);
+        return true;
+    }
+
+    if (name == "precision") {
+        if (tokens.size() != 2 || (tokens[1] != "single" && tokens[1] != "double" && tokens[1] != "double-double"))
+            return fail("usage: precision single|double|double-double");
+        if (!flush())
+            return false;
+
+        geo_components->set_precision(tokens[1] == "single" ? Precision::SINGLE
+                                      : (tokens[1] == "double" ? Precision::DOUBLE : Precision::DOUBLE_DOUBLE));
+        return true;
+    }
+
+    if (name == "fix" || name == "unfix") {
+        if (tokens.size() != 2)
+            return fail("usage: " + name + " <point>");
+        if (!flush())
+            return false;
+
+        unsigned int pid = geo_components->get_pid(tokens[1]);
+        if (pid == static_cast<unsigned int>(-1))
+            return fail("unknown construction '" + tokens[1] + "'");
+        if (!geo_components->set_fixed(pid, name == "fix"))
+            return fail("'" + tokens[1] + "' cannot be moved");
+        return true;
+    }
+
+    if (name == "check") {
+        bool collinear = tokens.size() >= 5 && tokens[1] == "collinear", concyclic = tokens.size() >= 6 && tokens[1] == "concyclic";
+        if (!collinear && !concyclic)
+            return fail("usage: check collinear <point> <point> <point> ... | check concyclic <point> <point> <point> <point> ...");
+        if (!flush())
+            return false;
+
+        GeoConjecture conjecture;
+        conjecture.incidence = collinear ? Incidence::COLLINEAR : Incidence::CONCYCLIC;
+        for (unsigned int i = 2; i < tokens.size(); ++i) {
+            if (geo_components->get_pid(tokens[i]) == static_cast<unsigned int>(-1))
+                return fail("unknown construction '" + tokens[i] + "'");
+            if (kind(tokens[i]) != GeoKind::POINT)
+                return fail("'" + tokens[i] + "' is not a point");
+            conjecture.labels.push_back(tokens[i]);
+        }
+        conjectures.push_back(conjecture);
+        return true;
+    }
+
+    return fail("unknown command '" + name + "'");
+}
+
+bool GeoScript::create(const string& label, const string& name, const vector<string>& args) {
+    if (exists(label))
+        return fail("label '" + label + "' already exists");
+
+    // Arguments: parent labels first, numbers last
+    vector<GeoRef> parents;
+    vector<GeoKind> parent_kinds;
+    vector<double> values;
+    for (auto it = begin(args); it != end(args); ++it) {
+        double value;
+        if (number(*it, &value)) {
+            values.push_back(value);
+        } else {
+            if (!values.empty() || !exists(*it))
+                return fail("unknown construction '" + *it + "'");
+            parents.push_back(GeoRef(*it));
+            parent_kinds.push_back(kind(*it));
+        }
+    }
+
+    auto is = [&parent_kinds](vector<GeoKind> expected) { return parent_kinds == expected; };
+    bool second = (values.size() == 1 && values[0] == 2);
+    bool first = values.empty() || (values.size() == 1 && values[0] == 1);
+    GeoKind kind_created = GeoKind::POINT;
+    int type = -1;
+
+    if (name == "point") {
+        if (is({}) && values.size() == 2)
+            type = static_cast<int>(PointType::INDEPENDENT);
+        kind_created = GeoKind::POINT;
+    } else if (name == "on") {
+        if (is({GeoKind::LINE}) && values.size() == 2)
+            type = static_cast<int>(PointType::ON_LINE);
+        else if (is({GeoKind::CIRCLE}) && values.size() == 2)
+            type = static_cast<int>(PointType::ON_CIRCLE);
+        kind_created = GeoKind::POINT;
+    } else if (name == "midpoint") {
+        if (is({GeoKind::POINT, GeoKind::POINT}) && values.empty())
+            type = static_cast<int>(PointType::POINT_POINT_MIDPOINT);
+        kind_created = GeoKind::POINT;
+    } else if (name == "intersect") {
+        // A circle given first is swapped with the line, constructors take the line first
+        if (is({GeoKind::CIRCLE, GeoKind::LINE})) {
+            swap(parents[0], parents[1]);
+            swap(parent_kinds[0], parent_kinds[1]);
+        }
+        if (is({GeoKind::LINE, GeoKind::LINE}) && values.empty())
+            type = static_cast<int>(PointType::LINE_LINE_INTERSECTION);
+        else if (is({GeoKind::LINE, GeoKind::CIRCLE}) && (first || second))
+            type = static_cast<int>(second ? PointType::LINE_CIRCLE_SECOND_INTERSECTION : PointType::LINE_CIRCLE_FIRST_INTERSECTION);
+        else if (is({GeoKind::CIRCLE, GeoKind::CIRCLE}) && (first || second))
+            type = static_cast<int>(second ? PointType::CIRCLE_CIRCLE_SECOND_INTERSECTION : PointType::CIRCLE_CIRCLE_FIRST_INTERSECTION);
+        kind_created = GeoKind::POINT;
+    } else if (name == "line") {
+        if (is({GeoKind::POINT, GeoKind::POINT}) && values.empty())
+            type = static_cast<int>(LineType::POINT_POINT_LINE_THROUGH);
+        kind_created = GeoKind::LINE;
+    } else if (name == "parallel") {
+        if (is({GeoKind::POINT, GeoKind::LINE}) && values.empty())
+            type = static_cast<int>(LineType::POINT_LINE_PARALLEL_LINE_THROUGH);
+        kind_created = GeoKind::LINE;
+    } else if (name == "bisector") {
+        if (is({GeoKind::POINT, GeoKind::POINT}) && values.empty())
+            type = static_cast<int>(LineType::POINT_POINT_PERPENDICULAR_BISECTOR);
+        kind_created = GeoKind::LINE;
+    } else if (name == "tangent") {
+        if (is({GeoKind::POINT, GeoKind::CIRCLE}) && (first || second))
+            type = static_cast<int>(second ? LineType::POINT_CIRCLE_SECOND_TANGENT : LineType::POINT_CIRCLE_FIRST_TANGENT);
+        kind_created = GeoKind::LINE;
+    } else if (name == "circle") {
+        if (is({GeoKind::POINT, GeoKind::POINT}) && values.empty())
+            type = static_cast<int>(CircleType::POINT_POINT_CENTER_THROUGH);
+        else if (is({GeoKind::POINT, GeoKind::POINT, GeoKind::POINT}) && values.empty())
+            type = static_cast<int>(CircleType::POINT_POINT_POINT_THROUGH);
+        kind_created = GeoKind::CIRCLE;
+    } else if (name == "radius") {
+        if (is({GeoKind::POINT, GeoKind::POINT, GeoKind::POINT}) && values.empty())
+            type = static_cast<int>(CircleType::POINT_POINT_POINT_CENTER_RADIUS);
+        kind_created = GeoKind::CIRCLE;
+    } else if (name == "triangle") {
+        if (is({GeoKind::POINT, GeoKind::POINT, GeoKind::POINT}) && values.empty())
+            type = static_cast<int>(TriangleType::POINT_POINT_POINT_VERTICES);
+        kind_created = GeoKind::TRIANGLE;
+    } else {
+        // Triangle centers, in the order of TriangleCentersType
+        static const char* centers[] = {"centroid", "incenter", "circumcenter", "orthocenter", "ninepoint", "lemoine"};
+        int center = 0;
+        while (center < 6 && name != centers[center])
+            ++center;
+        if (center == 6)
+            return fail("unknown command '" + name + "'");
+        if (is({GeoKind::TRIANGLE}) && values.empty())
+            type = center;
+        kind_created = GeoKind::TRIANGLE_CENTER;
+    }
+
+    if (type < 0)
+        return fail("invalid arguments for '" + name + "'");
+
+    double x = (values.size() == 2) ? values[0] : 0, y = (values.size() == 2) ? values[1] : 0;
+    creations.push_back(GeoDescriptor(kind_created, type, label, parents, x, y));
+    kinds[label] = (kind_created == GeoKind::TRIANGLE_CENTER) ? GeoKind::POINT : kind_created;
+    return true;
+}
+
+bool GeoScript::query(const string& label, vector<double>* values) const {
+    values->clear();
+    unsigned int pid = geo_components->get_pid(label);
+    GeoNode* geo = geo_components->get_construction(pid);
+    if (geo == nullptr)
+        return false;
+
+    // Evaluated first in pull mode
+    double data[GeoNode::DATA_SIZE];
+    geo_components->access(pid, data);
+    if (!geo->get_well_defined())
+        return true;
+    int size = 2;
+    switch (kind(label)) {
+    case GeoKind::LINE: case GeoKind::CIRCLE: size = 3; break;
+    case GeoKind::TRIANGLE: size = 6; break;
+    default: break;
+    }
+    values->assign(data, data + size);
+    return true;
+}
+
+bool GeoScript::flush() {
+    if (!creations.empty()) {
+        unsigned int added = geo_components->add_constructions(creations);
+        ++passes;
+        if (added < creations.size()) {
+            string label = creations[added].label;
+            for (unsigned int k = added; k < creations.size(); ++k)
+                kinds.erase(creations[k].label);
+            creations.clear();
+            return fail("'" + label + "' is not well-defined");
+        }
+        creations.clear();
+    }
+
+    if (!moves.empty()) {
+        geo_components->edit_constructions(moves, &coordinates[0]);
+        ++passes;
+        moves.clear();
+        coordinates.clear();
+    }
+
+    return true;
+}
+
+bool GeoScript::fail(const string& message) {
+    error = "line " + to_string(line) + ": " + message;
+    return false;
+}
+
+void GeoScript::index_kinds() {
+    vector<string> point_labels, line_labels, circle_labels, triangle_labels;
+    geo_components->update_ui_labels(&point_labels, &line_labels, &circle_labels, &triangle_labels, true);
+
+    kinds.clear();
+    for (auto it = begin(point_labels); it != end(point_labels); ++it)
+        kinds[*it] = GeoKind::POINT;
+    for (auto it = begin(line_labels); it != end(line_labels); ++it)
+        kinds[*it] = GeoKind::LINE;
+    for (auto it = begin(circle_labels); it != end(circle_labels); ++it)
+        kinds[*it] = GeoKind::CIRCLE;
+    for (auto it = begin(triangle_labels); it != end(triangle_labels); ++it)
+        kinds[*it] = GeoKind::TRIANGLE;
+}
+
+GeoKind GeoScript::kind(const string& label) const {
+    auto it = kinds.find(label);
+    return (it != kinds.end()) ? it->second : GeoKind::POINT;
+}
+
+bool GeoScript::exists(const string& label) const {
+    return kinds.count(label) != 0;
+}
+
+bool GeoScript::number(const string& token, double* value) {
+    char* end = nullptr;
+    *value = strtod(token.c_str(), &end);
+    return !token.empty() && *end == '\0';
+}
+
+const string& GeoScript::get_error() const {
+    return error;
+}
+
+const string& GeoScript::get_output() const {
+    return output;
+}
+
+unsigned int GeoScript::get_commands() const {
+    return commands;
+}
+
+unsigned int GeoScript::get_passes() const {
+    return passes;
+}
+
+const vector<GeoConjecture>& GeoScript::get_conjectures() const {
+    return conjectures;
+}
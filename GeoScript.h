@@ -0,0 +1,87 @@
+/***************************************************************************
+This class, GeoScript, executes construction scripts on a GeoComponents
+object, one command per line ('#' starts a comment, labels with spaces are
+written between double quotes):
+
+    A = point 0 0              B = on L 3 4 (point on line or circle)
+    M = midpoint A B           P = intersect L1 C2 [2] (second intersection)
+    L = line A B               L = parallel A L1
+    L = bisector A B           L = tangent A C [2] (second tangent)
+    C = circle A B [D]         C = radius O A B (center O, radius |AB|)
+    T = triangle A B C         X = centroid T (incenter, circumcenter,
+                                   orthocenter, ninepoint, lemoine)
+    move A 3 4                 remove B                 print A
+    evaluate pull (only what is printed or queried is recomputed, or push)
+    fix A (moves of A are refused, what depends only on fixed points is
+           never recomputed again, until unfix A)
+    coordinates homogeneous (parallel lines meet at infinity, or cartesian)
+    precision single (kernels in float, or double, double-double)
+    check collinear O G H      check concyclic A B C D (conjectures checked
+                                   on random placements, see GeoChecker)
+
+Consecutive creations are added as a single batch and consecutive moves are
+applied in a single propagation pass. It does not depend on the user
+interface, so that scripts can also be run headless.
+****************************************************************************/
+
+#ifndef GEOSCRIPT_H_
+#define GEOSCRIPT_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "GeoChecker.h"
+#include "GeoComponents.h"
+#include "GeoDescriptor.h"
+
+class GeoScript {
+
+public:
+    GeoScript(GeoComponents* geo_components); /**< @brief Constructor, takes the constructions the scripts act on. */
+
+    /** @brief Takes the text of a script and executes it, returns false at the first error (see get_error), the commands before it are kept. */
+    bool run(const string& text);
+    /** @brief Takes the path of a script file and executes it, returns false if it cannot be read or at the first error. */
+    bool run_file(const string& path);
+
+    /** @brief Takes a label and sets values to the data of the construction (empty if it is not well-defined), returns false if there is none.
+     *  Points have 2 values, lines and circles 3 (a, b, c and center, radius) and triangles 6 (vertices), kinds are known as of the last run. */
+    bool query(const string& label, vector<double>* values) const;
+
+    const string& get_error() const; /**< @brief Returns the message of the last error, prefixed by its line number. */
+    const string& get_output() const; /**< @brief Returns the text written by the print commands of the last run. */
+    unsigned int get_commands() const; /**< @brief Returns the number of commands executed so far. */
+    unsigned int get_passes() const; /**< @brief Returns the number of batches (additions or propagation passes) performed so far. */
+    const vector<GeoConjecture>& get_conjectures() const; /**< @brief Returns the conjectures declared by the check commands so far. */
+
+private:
+    /** @brief Takes a line and splits it into tokens, returns false if a quote is not closed. */
+    static bool tokenize(const string& line, vector<string>* tokens);
+    /** @brief Takes the tokens of a command and executes it, or queues it if it can be batched with the previous ones. */
+    bool execute(const vector<string>& tokens);
+    /** @brief Takes the label, the name and the arguments of a creation command and queues its descriptor. */
+    bool create(const string& label, const string& name, const vector<string>& args);
+    bool flush(); /**< @brief Adds the queued creations and applies the queued moves. */
+    bool fail(const string& message); /**< @brief Sets the error message and returns false. */
+
+    void index_kinds(); /**< @brief Finds again the kind of every construction from their labels. */
+    GeoKind kind(const string& label) const; /**< @brief Returns the kind of the construction with the given label (POINT if unknown). */
+    bool exists(const string& label) const; /**< @brief Returns whether the label is taken, by a construction or a queued creation. */
+    static bool number(const string& token, double* value); /**< @brief Takes a token and sets value to the number it holds, returns false if it is not one. */
+
+    GeoComponents* geo_components; /**< @brief Constructions the scripts act on. */
+    unordered_map<string, GeoKind> kinds; /**< @brief Kind of each construction and queued creation, by label. */
+
+    vector<GeoDescriptor> creations; /**< @brief Queued creations. */
+    vector<unsigned int> moves; /**< @brief Pids of the queued moves. */
+    vector<double> coordinates; /**< @brief Coordinates of the queued moves, 2 per pid. */
+    vector<GeoConjecture> conjectures; /**< @brief Conjectures declared. */
+
+    unsigned int line {0}; /**< @brief Line number of the command being executed. */
+    string error {""}; /**< @brief Message of the last error. */
+    string output {""}; /**< @brief Text written by the print commands. */
+    unsigned int commands {0}; /**< @brief Number of commands executed. */
+    unsigned int passes {0}; /**< @brief Number of batches performed. */
+};
+
+#endif /* GEOSCRIPT_H_ */
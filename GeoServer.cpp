@@ -0,0 +1,327 @@
+/*
+ * GeoServer.cpp
+ *
+ */
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QtEndian>
+#include "GeoServer.h"
+
+GeoServer::GeoServer(unsigned int workers, QObject* parent): QObject(parent) {
+    server = new QLocalServer(this);
+    connect(server, SIGNAL(newConnection()), this, SLOT(accept()));
+
+    if (workers == 0)
+        workers = 1;
+    for (unsigned int i = 0; i < workers; ++i) {
+        Worker* worker = new Worker;
+        this->workers.push_back(worker);
+        worker->thread = std::thread(&GeoServer::serve, this, worker);
+    }
+}
+
+GeoServer::~GeoServer() {
+    for (auto it = begin(workers); it != end(workers); ++it) {
+        {
+            std::lock_guard<std::mutex> lock((*it)->mutex);
+            running = false;
+        }
+        (*it)->wake.notify_one();
+    }
+    for (auto it = begin(workers); it != end(workers); ++it) {
+        (*it)->thread.join();
+        for (auto scene = begin((*it)->scenes); scene != end((*it)->scenes); ++scene)
+            delete scene->second;
+        delete (*it);
+    }
+}
+
+bool GeoServer::listen(const QString& name) {
+    QLocalServer::removeServer(name);
+    return server->listen(name);
+}
+
+QString GeoServer::get_error() const {
+    return server->errorString();
+}
+
+QByteArray GeoServer::frame(const QJsonObject& message) {
+    QByteArray json = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    QByteArray data(4, 0);
+    qToBigEndian<quint32>(json.size(), reinterpret_cast<uchar*>(data.data()));
+    return data + json;
+}
+
+int GeoServer::unframe(QByteArray* buffer, QJsonObject* message) {
+    if (buffer->size() < 4)
+        return 0;
+
+    quint32 size = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(buffer->constData()));
+    if (size > static_cast<quint32>(MAX_FRAME))
+        return -1;
+    if (static_cast<quint32>(buffer->size()) < 4 + size)
+        return 0;
+
+    QJsonDocument document = QJsonDocument::fromJson(buffer->mid(4, size));
+    buffer->remove(0, 4 + size);
+    *message = document.object();
+    return document.isObject() ? 1 : -1;
+}
+
+void GeoServer::accept() {
+    while (server->hasPendingConnections()) {
+        QLocalSocket* socket = server->nextPendingConnection();
+        quint64 id = next_connection++;
+        sockets.insert(id, socket);
+        ids.insert(socket, id);
+        buffers.insert(socket, QByteArray());
+        connect(socket, SIGNAL(readyRead()), this, SLOT(read()));
+        connect(socket, SIGNAL(disconnected()), this, SLOT(disconnected()));
+    }
+}
+
+void GeoServer::read() {
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    if (socket == nullptr || !ids.contains(socket))
+        return;
+
+    quint64 id = ids.value(socket);
+    QByteArray& buffer = buffers[socket];
+    buffer.append(socket->readAll());
+
+    // Every complete frame is taken now, and queued to its worker in one go (pipelining)
+    std::unordered_map<Worker*, std::vector<Request>> batches;
+    QJsonObject message;
+    int status;
+    while ((status = unframe(&buffer, &message)) == 1) {
+        QString scene = message.value("scene").toString();
+        if (scene.isEmpty()) {
+            QJsonObject response;
+            response.insert("id", message.value("id"));
+            response.insert("ok", false);
+            response.insert("error", "missing scene");
+            socket->write(frame(response));
+            continue;
+        }
+        batches[owner(scene)].push_back(Request {id, message});
+    }
+
+    for (auto it = begin(batches); it != end(batches); ++it) {
+        {
+            std::lock_guard<std::mutex> lock(it->first->mutex);
+            it->first->requests.insert(it->first->requests.end(), it->second.begin(), it->second.end());
+        }
+        it->first->wake.notify_one();
+    }
+
+    if (status < 0) {
+        QJsonObject response;
+        response.insert("ok", false);
+        response.insert("error", "invalid frame");
+        socket->write(frame(response));
+        socket->disconnectFromServer();
+    }
+}
+
+void GeoServer::disconnected() {
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    if (socket == nullptr || !ids.contains(socket))
+        return;
+
+    // The subscriptions of the connection are dropped by every worker
+    quint64 id = ids.take(socket);
+    sockets.remove(id);
+    buffers.remove(socket);
+    QJsonObject body;
+    body.insert("op", "disconnect");
+    for (auto it = begin(workers); it != end(workers); ++it) {
+        {
+            std::lock_guard<std::mutex> lock((*it)->mutex);
+            (*it)->requests.push_back(Request {id, body});
+        }
+        (*it)->wake.notify_one();
+    }
+    socket->deleteLater();
+}
+
+GeoServer::Worker* GeoServer::owner(const QString& scene) const {
+    return workers[qHash(scene) % workers.size()];
+}
+
+void GeoServer::serve(Worker* worker) {
+    std::vector<Request> batch;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(worker->mutex);
+            worker->wake.wait(lock, [this, worker]() { return !running || !worker->requests.empty(); });
+            if (!running)
+                return;
+            batch.assign(worker->requests.begin(), worker->requests.end());
+            worker->requests.clear();
+        }
+
+        process(worker, batch);
+    }
+}
+
+void GeoServer::process(Worker* worker, std::vector<Request>& batch) {
+    for (unsigned int i = 0; i < batch.size(); ) {
+        const QJsonObject& body = batch[i].body;
+        QString op = body.value("op").toString();
+        std::string name = body.value("scene").toString().toStdString();
+
+        if (op == "disconnect") {
+            for (auto it = begin(worker->scenes); it != end(worker->scenes); ++it) {
+                std::vector<Subscription>& subscriptions = it->second->subscriptions;
+                for (unsigned int k = 0; k < subscriptions.size(); ) {
+                    if (subscriptions[k].connection == batch[i].connection)
+                        subscriptions.erase(subscriptions.begin() + k);
+                    else
+                        ++k;
+                }
+            }
+            ++i;
+            continue;
+        }
+
+        QJsonObject response;
+        response.insert("id", body.value("id"));
+        auto found = worker->scenes.find(name);
+        Scene* scene = (found != worker->scenes.end()) ? found->second : nullptr;
+
+        if (op == "build") {
+            // A new scene replaces the previous one, its subscribers are kept
+            Scene* built = new Scene;
+            bool ok = built->script.run(body.value("script").toString().toStdString());
+            if (scene != nullptr) {
+                built->subscriptions.swap(scene->subscriptions);
+                delete scene;
+            }
+            worker->scenes[name] = built;
+            response.insert("ok", ok);
+            response.insert("size", static_cast<int>(built->geo.size()));
+            if (!ok)
+                response.insert("error", QString::fromStdString(built->script.get_error()));
+            post(batch[i].connection, response);
+            notify(built, name);
+            ++i;
+
+        } else if (scene == nullptr) {
+            response.insert("ok", false);
+            response.insert("error", "unknown scene");
+            post(batch[i].connection, response);
+            ++i;
+
+        } else if (op == "edit") {
+            // Consecutive edits of the scene are evaluated in a single propagation pass
+            std::vector<unsigned int> pids;
+            std::vector<double> coordinates;
+            unsigned int j = i;
+            for (; j < batch.size() && batch[j].body.value("op").toString() == "edit"
+                   && batch[j].body.value("scene").toString().toStdString() == name; ++j) {
+                QJsonObject edit_response;
+                edit_response.insert("id", batch[j].body.value("id"));
+                QJsonArray edits = batch[j].body.value("edits").toArray();
+                unsigned int first = pids.size();
+                bool ok = true;
+                for (auto it = edits.begin(); it != edits.end() && ok; ++it) {
+                    QJsonArray edit = it->toArray();
+                    unsigned int pid = scene->geo.get_pid(edit.at(0).toString().toStdString());
+                    ok = (edit.size() == 3 && scene->geo.is_movable(pid));
+                    pids.push_back(pid);
+                    coordinates.push_back(edit.at(1).toDouble());
+                    coordinates.push_back(edit.at(2).toDouble());
+                }
+                if (!ok) {
+                    pids.resize(first);
+                    coordinates.resize(2 * first);
+                    edit_response.insert("error", "invalid edit");
+                }
+                edit_response.insert("ok", ok);
+                post(batch[j].connection, edit_response);
+            }
+            if (!pids.empty()) {
+                scene->geo.edit_constructions(pids, &coordinates[0]);
+                notify(scene, name);
+            }
+            i = j;
+
+        } else if (op == "query" || op == "subscribe") {
+            QJsonArray labels = body.value("labels").toArray();
+            QJsonObject values;
+            Subscription subscription {batch[i].connection, {}, {}};
+            std::vector<double> data;
+            bool ok = true;
+            for (auto it = labels.begin(); it != labels.end(); ++it) {
+                std::string label = it->toString().toStdString();
+                if (!scene->script.query(label, &data)) {
+                    ok = false;
+                    break;
+                }
+                QJsonArray value;
+                for (auto d = begin(data); d != end(data); ++d)
+                    value.append(*d);
+                values.insert(it->toString(), data.empty() ? QJsonValue() : QJsonValue(value));
+                subscription.labels.push_back(label);
+                subscription.sent.push_back(data);
+            }
+
+            response.insert("ok", ok);
+            if (ok) {
+                response.insert("values", values);
+                if (op == "subscribe")
+                    scene->subscriptions.push_back(subscription);
+            } else {
+                response.insert("error", "unknown construction");
+            }
+            post(batch[i].connection, response);
+            ++i;
+
+        } else {
+            response.insert("ok", false);
+            response.insert("error", "unknown operation");
+            post(batch[i].connection, response);
+            ++i;
+        }
+    }
+}
+
+void GeoServer::notify(Scene* scene, const std::string& name) {
+    std::vector<double> data;
+    for (auto it = begin(scene->subscriptions); it != end(scene->subscriptions); ++it) {
+        QJsonObject values;
+        for (unsigned int k = 0; k < it->labels.size(); ++k) {
+            if (!scene->script.query(it->labels[k], &data) || data == it->sent[k])
+                continue;
+
+            QJsonArray value;
+            for (auto d = begin(data); d != end(data); ++d)
+                value.append(*d);
+            values.insert(QString::fromStdString(it->labels[k]), data.empty() ? QJsonValue() : QJsonValue(value));
+            it->sent[k] = data;
+        }
+
+        if (!values.isEmpty()) {
+            QJsonObject event;
+            event.insert("event", "changed");
+            event.insert("scene", QString::fromStdString(name));
+            event.insert("values", values);
+            post(it->connection, event);
+        }
+    }
+}
+
+void GeoServer::post(quint64 connection, const QJsonObject& message) {
+    QByteArray data = frame(message);
+    QMetaObject::invokeMethod(this, [this, connection, data]() { send(connection, data); }, Qt::QueuedConnection);
+}
+
+void GeoServer::send(quint64 connection, const QByteArray& data) {
+    QLocalSocket* socket = sockets.value(connection, nullptr);
+    if (socket != nullptr)
+        socket->write(data);
+}
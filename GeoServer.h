@@ -0,0 +1,117 @@
+/***************************************************************************
+This class, GeoServer, serves constructions to other processes over a local
+socket (QLocalServer), without any widget. Messages are frames made of a
+4-byte big-endian length followed by a JSON object:
+
+    {"id": 1, "op": "build", "scene": "s", "script": "A = point 0 0\n..."}
+    {"id": 2, "op": "edit", "scene": "s", "edits": [["A", 3, 4], ...]}
+    {"id": 3, "op": "query", "scene": "s", "labels": ["P", "L"]}
+    {"id": 4, "op": "subscribe", "scene": "s", "labels": ["P"]}
+
+Every request gets a response {"id": ..., "ok": true, ...} or {"id": ...,
+"ok": false, "error": "..."}, queries add "values": {"P": [x, y], ...} (null
+when not well-defined). Subscribers receive {"event": "changed", "scene":
+"s", "values": {...}} with the subscribed values that changed after each
+propagation pass. Scene scripts use the GeoScript language.
+
+Scenes are spread over a pool of worker threads, each owning the
+GeoComponents objects of its scenes. Requests are pipelined: all the frames
+received at once are queued together, and consecutive edits of a scene are
+evaluated in a single propagation pass. Responses come in request order
+within a scene.
+****************************************************************************/
+
+#ifndef GEOSERVER_H_
+#define GEOSERVER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include "GeoComponents.h"
+#include "GeoScript.h"
+
+class QLocalServer;
+class QLocalSocket;
+
+class GeoServer : public QObject {
+    Q_OBJECT
+
+public:
+    static const int MAX_FRAME = 16 << 20; /**< @brief Largest accepted frame, larger ones close the connection. */
+
+    /** @brief Constructor, takes the number of worker threads (at least 1). */
+    GeoServer(unsigned int workers = std::thread::hardware_concurrency(), QObject* parent = nullptr);
+    /** @brief Starts listening on the local socket with the given name, returns false if it cannot (see get_error). */
+    bool listen(const QString& name);
+    QString get_error() const; /**< @brief Returns the description of the last listening error. */
+
+    /** @brief Takes a JSON object and returns it as a frame. */
+    static QByteArray frame(const QJsonObject& message);
+    /** @brief Takes a buffer of received bytes, removes the first complete frame from it and sets message to its object.
+     *  Returns 1 if a frame was taken, 0 if it is still incomplete, -1 if the data is not a valid frame. */
+    static int unframe(QByteArray* buffer, QJsonObject* message);
+
+    virtual ~GeoServer(); /**< @brief Stops and joins the workers, deletes the scenes. */
+
+private slots:
+    void accept(); /**< @brief Takes the pending connections. */
+    void read(); /**< @brief Queues the requests of the complete frames received on a connection. */
+    void disconnected(); /**< @brief Forgets a closed connection and its subscriptions. */
+
+private:
+    /** @brief A request, along with the connection it came from. */
+    struct Request {
+        quint64 connection;
+        QJsonObject body;
+    };
+    /** @brief Labels subscribed to by a connection, with the values last sent. */
+    struct Subscription {
+        quint64 connection;
+        std::vector<std::string> labels;
+        std::vector<std::vector<double>> sent;
+    };
+    /** @brief Constructions of a scene, only accessed by the worker owning it. */
+    struct Scene {
+        Scene(): script(&geo) {}
+        GeoComponents geo;
+        GeoScript script;
+        std::vector<Subscription> subscriptions;
+    };
+    /** @brief A worker thread, its queue of requests and its scenes. */
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<Request> requests;
+        std::unordered_map<std::string, Scene*> scenes;
+    };
+
+    void serve(Worker* worker); /**< @brief Loop of a worker thread: takes the queued requests and processes them in batches. */
+    /** @brief Takes the batch of requests taken by a worker and processes them, merging consecutive edits of a scene. */
+    void process(Worker* worker, std::vector<Request>& batch);
+    /** @brief Takes a scene and sends to its subscribers the subscribed values that changed. */
+    void notify(Scene* scene, const std::string& name);
+    /** @brief Worker side: posts a message to be sent on the given connection from the thread of the server. */
+    void post(quint64 connection, const QJsonObject& message);
+    void send(quint64 connection, const QByteArray& data); /**< @brief Writes data on the given connection, if it is still open. */
+    Worker* owner(const QString& scene) const; /**< @brief Returns the worker owning the scene with the given name. */
+
+    QLocalServer* server {nullptr}; /**< @brief The listening socket. */
+    std::vector<Worker*> workers; /**< @brief The worker pool. */
+    std::atomic<bool> running {true}; /**< @brief Cleared (under the worker mutexes) to stop the workers. */
+
+    QHash<quint64, QLocalSocket*> sockets; /**< @brief Open connections, by id. */
+    QHash<QLocalSocket*, quint64> ids; /**< @brief Ids of the open connections. */
+    QHash<QLocalSocket*, QByteArray> buffers; /**< @brief Bytes received and not yet making a complete frame, by connection. */
+    quint64 next_connection {1}; /**< @brief The id to be given to the next connection. */
+};
+
+#endif /* GEOSERVER_H_ */
@@ -0,0 +1,170 @@
+/*
+ * GeoSnapping.cpp
+ *
+ */
+
+#include <cmath>
+#include <climits>
+#include "GeoSnapping.h"
+
+GeoSnapping::GeoSnapping(GeoComponents* geo_components): geo_components(geo_components), curves(geo_components) {}
+
+GeoSnapping::~GeoSnapping() {
+    if (figure != nullptr)
+        (figure->parentPlot())->removeGraph(figure);
+}
+
+void GeoSnapping::start(const GeoSnapshot& snapshot, const double view[4], double pixel_size, unsigned int dragged) {
+    stop();
+    if (!enabled || !(pixel_size > 0) || snapshot.topology != geo_components->get_topology() || snapshot.size() != geo_components->size())
+        return;
+    tolerance = tolerance_pixels * pixel_size;
+
+    // Constructions moving with the dragged point: the point and its descendants, which come after it
+    vector<char> moving(snapshot.size(), 0);
+    vector<unsigned int> key;
+    dependents.clear();
+    for (unsigned int pid = dragged; pid < snapshot.size(); ++pid) {
+        if (pid != dragged) {
+            geo_components->get_structure(pid, &key);
+            for (unsigned int j = 2; j < key.size() && !moving[pid]; ++j)
+                moving[pid] = moving[key[j]];
+        } else {
+            moving[pid] = 1;
+        }
+        if (moving[pid])
+            dependents.push_back(pid);
+    }
+
+    // Points within the tolerance of the view
+    double region[4] = {view[0] - tolerance, view[1] + tolerance, view[2] - tolerance, view[3] + tolerance};
+    for (unsigned int pid = 0; pid < snapshot.size(); ++pid) {
+        if (moving[pid] || !geo_components->is_point(pid) || !snapshot.get_well_defined(pid))
+            continue;
+        const double* point = snapshot.access(pid);
+        if (point[0] >= region[0] && point[0] <= region[1] && point[1] >= region[2] && point[1] <= region[3])
+            add(point[0], point[1], pid, pid, false);
+    }
+
+    // Lines and circles, and their intersections
+    curves.set_enabled(true);
+    curves.set_region(region);
+    curves.set_excluded(dependents);
+    curves.update(snapshot, view);
+    const vector<GeoIntersections::Intersection>& intersections = curves.get_intersections();
+    for (auto it = begin(intersections); it != end(intersections); ++it)
+        add(it->x, it->y, it->first, it->second, true);
+
+    active = true;
+}
+
+bool GeoSnapping::query(double x, double y, GeoSnap* snap) const {
+    if (!active)
+        return false;
+
+    // Nearest point and nearest intersection in the nine cells around the position
+    double best[2] = {tolerance, tolerance};
+    int found[2] = {-1, -1};
+    for (int i = -1; i <= 1; ++i) {
+        for (int j = -1; j <= 1; ++j) {
+            auto cell = cells.find(key(x + i * tolerance, y + j * tolerance));
+            if (cell == cells.end())
+                continue;
+            for (auto it = begin(cell->second); it != end(cell->second); ++it) {
+                const Target& target = targets[*it];
+                double distance = hypot(target.x - x, target.y - y);
+                int kind = target.intersection ? 1 : 0;
+                if (distance <= best[kind]) {
+                    best[kind] = distance;
+                    found[kind] = static_cast<int>(*it);
+                }
+            }
+        }
+    }
+
+    for (int kind = 0; kind < 2; ++kind) {
+        if (found[kind] < 0)
+            continue;
+        const Target& target = targets[found[kind]];
+        snap->target = (kind == 0) ? SnapTarget::POINT : SnapTarget::INTERSECTION;
+        snap->x = target.x;
+        snap->y = target.y;
+        snap->pids[0] = target.pids[0];
+        snap->pids[1] = target.pids[1];
+        return true;
+    }
+
+    double projection[2];
+    unsigned int pid;
+    if (!curves.nearest_curve(x, y, tolerance, &pid, projection))
+        return false;
+    snap->target = SnapTarget::CURVE;
+    snap->x = projection[0];
+    snap->y = projection[1];
+    snap->pids[0] = snap->pids[1] = pid;
+    return true;
+}
+
+void GeoSnapping::stop() {
+    targets.clear();
+    cells.clear();
+    active = false;
+}
+
+void GeoSnapping::highlight(Ui::MainWindow* ui, const GeoSnap* snap) {
+    bool show = (snap != nullptr);
+    if (show == highlighted && (!show || (snap->x == highlight_x && snap->y == highlight_y)))
+        return;
+
+    if (figure == nullptr) { //Initialization, on a buffered layer of its own
+        ui->custom_plot->addLayer("snap", ui->custom_plot->layer("front"), QCustomPlot::limAbove);
+        ui->custom_plot->layer("snap")->setMode(QCPLayer::lmBuffered);
+        figure = ui->custom_plot->addGraph();
+        figure->setLineStyle(QCPGraph::lsNone);
+        figure->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, QColor(255, 200, 0), 16));
+        figure->setLayer("snap");
+        figure->setSelectable(QCP::stNone);
+    }
+
+    QVector<double> x, y;
+    if (show) {
+        x.push_back(snap->x);
+        y.push_back(snap->y);
+        highlight_x = snap->x;
+        highlight_y = snap->y;
+    }
+    figure->setData(x, y);
+    highlighted = show;
+    ui->custom_plot->layer("snap")->replot();
+}
+
+long long GeoSnapping::key(double x, double y) const {
+    double cell_x = floor(x / tolerance), cell_y = floor(y / tolerance);
+    cell_x = max(static_cast<double>(INT_MIN), min(cell_x, static_cast<double>(INT_MAX)));
+    cell_y = max(static_cast<double>(INT_MIN), min(cell_y, static_cast<double>(INT_MAX)));
+    unsigned long long high = static_cast<unsigned long long>(static_cast<long long>(cell_x)), low = static_cast<unsigned long long>(static_cast<long long>(cell_y));
+    return static_cast<long long>((high << 32) | (low & 0xffffffffULL));
+}
+
+void GeoSnapping::add(double x, double y, unsigned int first, unsigned int second, bool intersection) {
+    Target target;
+    target.x = x;
+    target.y = y;
+    target.pids[0] = first;
+    target.pids[1] = second;
+    target.intersection = intersection;
+    cells[key(x, y)].push_back(targets.size());
+    targets.push_back(target);
+}
+
+void GeoSnapping::set_enabled(bool enabled) {
+    this->enabled = enabled;
+}
+
+void GeoSnapping::set_tolerance_pixels(double tolerance_pixels) {
+    this->tolerance_pixels = tolerance_pixels;
+}
+
+unsigned int GeoSnapping::get_targets() const {
+    return targets.size();
+}
@@ -0,0 +1,85 @@
+/***************************************************************************
+This class, GeoSnapping, provides magnetic snapping while a point is
+dragged: the position under the mouse is pulled onto the nearest point,
+intersection of lines and circles, or line or circle within a tolerance
+given in pixels. When the drag starts, the constructions in view that do
+not move with the dragged point are indexed once: points and intersections
+are hashed into square cells of the tolerance, so that a query only looks
+at the nine cells around the mouse, and lines and circles are rasterized
+into the grid of a GeoIntersections object, which also finds their
+intersections. Queries at mouse rate thus do not depend on the size of the
+scene. Points take precedence over intersections, and intersections over
+curves. The target is highlighted on a layer of its own, which is redrawn
+without replotting the constructions.
+****************************************************************************/
+
+#ifndef GEOSNAPPING_H_
+#define GEOSNAPPING_H_
+
+#include <unordered_map>
+#include <vector>
+#include "GeoComponents.h"
+#include "GeoIntersections.h"
+
+/** @brief Kinds of snap targets, by precedence. */
+enum class SnapTarget {
+    POINT, //!< A point of the scene.
+    INTERSECTION, //!< An intersection of two lines or circles.
+    CURVE //!< The nearest point on a line or a circle.
+};
+
+/** @brief Position snapped to. */
+struct GeoSnap {
+    SnapTarget target; //!< Kind of the target.
+    double x, y; //!< Position snapped to.
+    unsigned int pids[2]; //!< Pid of the point or curve, and of the second curve of an intersection.
+};
+
+class GeoSnapping {
+
+public:
+    GeoSnapping(GeoComponents* geo_components); /**< @brief Constructor, takes the (not owned) GeoComponents object. */
+
+    /** @brief Takes a snapshot, the view rectangle {x_min, x_max, y_min, y_max}, the size of a pixel in plot coordinates and the pid of the dragged point,
+     *  and indexes the targets in view that do not depend on it. Does nothing if the snapping is disabled. */
+    void start(const GeoSnapshot& snapshot, const double view[4], double pixel_size, unsigned int dragged);
+    /** @brief Takes a position and returns whether a target is within the tolerance, setting snap to the nearest one of the first kind found. */
+    bool query(double x, double y, GeoSnap* snap) const;
+    void stop(); /**< @brief Drops the index at the end of the drag. */
+    /** @brief Highlights the target of snap (nothing if nullptr) and redraws its layer only, if the target changed. */
+    void highlight(Ui::MainWindow* ui, const GeoSnap* snap);
+
+    void set_enabled(bool enabled); /**< @brief Enables or disables the snapping, it takes effect on the next drag. */
+    void set_tolerance_pixels(double tolerance_pixels); /**< @brief Sets the distance on screen within which targets attract the mouse. */
+    unsigned int get_targets() const; /**< @brief Returns the number of points and intersections indexed by the last start. */
+
+    virtual ~GeoSnapping(); /**< @brief Removes the highlight from the plot. */
+
+private:
+    /** @brief Point or intersection indexed. */
+    struct Target {
+        double x, y; //!< Position of the target.
+        unsigned int pids[2]; //!< Pid of the point (twice), or of the two curves of the intersection.
+        bool intersection; //!< Indicates whether it is an intersection.
+    };
+
+    long long key(double x, double y) const; /**< @brief Returns the key of the cell containing (x, y). */
+    void add(double x, double y, unsigned int first, unsigned int second, bool intersection); /**< @brief Indexes a target. */
+
+    GeoComponents* geo_components {nullptr}; /**< @brief Constructions snapped to (not owned). */
+    bool enabled {true}; /**< @brief Indicates whether the snapping is enabled. */
+    bool active {false}; /**< @brief Indicates whether a drag is indexed. */
+    double tolerance_pixels {8}; /**< @brief Distance on screen within which targets attract the mouse. */
+    double tolerance {0}; /**< @brief Tolerance of the current drag, in plot coordinates (also the side of the cells). */
+
+    vector<Target> targets; /**< @brief Points and intersections indexed. */
+    unordered_map<long long, vector<unsigned int>> cells; /**< @brief Targets in each non-empty cell, by index. */
+    GeoIntersections curves; /**< @brief Lines and circles in view that do not move with the dragged point, and their intersections. */
+    vector<unsigned int> dependents; /**< @brief Scratch list of the pids moving with the dragged point. */
+
+    bool highlighted {false}; /**< @brief Indicates whether a target is highlighted. */
+    double highlight_x {0}, highlight_y {0}; /**< @brief Position of the highlighted target. */
+    QCPGraph* figure {nullptr}; /**< @brief Marker of the highlighted target. */
+};
+
+#endif /* GEOSNAPPING_H_ */
@@ -0,0 +1,33 @@
+/***************************************************************************
+This structure, GeoSnapshot, is a copy of the data and well-definedness of
+every construction of a GeoComponents object at one point in time. Data is
+stored with a fixed stride of GeoNode::DATA_SIZE, indexed by pid.
+****************************************************************************/
+
+#ifndef GEOSNAPSHOT_H_
+#define GEOSNAPSHOT_H_
+
+#include <vector>
+#include "GeoNode.h"
+
+struct GeoSnapshot {
+    unsigned long sequence {0}; /**< @brief Number of the propagation pass that produced the snapshot. */
+    unsigned long topology {0}; /**< @brief Topology version of the GeoComponents object when the snapshot was taken. */
+    vector<double> data; /**< @brief Data of the constructions, the one with pid i starts at i*GeoNode::DATA_SIZE. */
+    vector<char> well_defined; /**< @brief Well-definedness of the constructions, indexed by pid. */
+    vector<char> stale; /**< @brief Indicates whether each construction was awaiting evaluation (pull mode), its data is then the last evaluated. */
+    vector<double> boxes; /**< @brief Bounding boxes {x_min, x_max, y_min, y_max} of the constructions, the one with pid i starts at 4*i. */
+
+    /** @brief Returns the number of constructions stored. */
+    unsigned int size() const { return static_cast<unsigned int>(well_defined.size()); }
+    /** @brief Returns a pointer to the data of the construction with the given pid. */
+    const double* access(unsigned int pid) const { return &data[pid * GeoNode::DATA_SIZE]; }
+    /** @brief Returns a pointer to the bounding box of the construction with the given pid. */
+    const double* box(unsigned int pid) const { return &boxes[4 * pid]; }
+    /** @brief Returns whether the construction with the given pid was well-defined. */
+    bool get_well_defined(unsigned int pid) const { return well_defined[pid] != 0; }
+    /** @brief Returns whether the data of the construction with the given pid was stale. */
+    bool is_stale(unsigned int pid) const { return stale[pid] != 0; }
+};
+
+#endif /* GEOSNAPSHOT_H_ */
@@ -0,0 +1,126 @@
+/*
+ * GeoVersions.cpp
+ *
+ */
+
+#include "GeoVersions.h"
+#include "GeoComponents.h"
+
+GeoVersions::GeoVersions() {}
+
+GeoVersions::~GeoVersions() {
+    delete current.load();
+    for (auto it = begin(retired); it != end(retired); ++it)
+        delete it->second;
+    for (auto it = begin(spare); it != end(spare); ++it)
+        delete *it;
+}
+
+void GeoVersions::publish(const GeoComponents& geo_components) {
+    if (readers.load() == 0) {
+        skipped = true;
+        return;
+    }
+    GeoSnapshot* next = next_version();
+    geo_components.take_snapshot(next);
+    swap_in(next);
+}
+
+void GeoVersions::publish(const GeoSnapshot& frame) {
+    if (readers.load() == 0) {
+        skipped = true;
+        return;
+    }
+    GeoSnapshot* next = next_version();
+    *next = frame;
+    swap_in(next);
+}
+
+bool GeoVersions::is_outdated() const {
+    return skipped && readers.load() != 0;
+}
+
+GeoSnapshot* GeoVersions::next_version() {
+    // Reuse a reclaimed version if possible
+    if (spare.empty())
+        return new GeoSnapshot;
+    GeoSnapshot* next = spare.back();
+    spare.pop_back();
+    return next;
+}
+
+void GeoVersions::swap_in(GeoSnapshot* next) {
+    // Swap first, then advance: a reader that sees the new epoch also sees the new version
+    GeoSnapshot* old = current.exchange(next);
+    unsigned long retire_epoch = epoch.fetch_add(1);
+    if (old != nullptr)
+        retired.push_back(make_pair(retire_epoch, old));
+    skipped = false;
+
+    reclaim();
+}
+
+void GeoVersions::reclaim() {
+    unsigned long oldest = IDLE;
+    for (int i = 0; i < MAX_READERS; ++i) {
+        unsigned long pinned = slots[i].epoch.load();
+        if (pinned < oldest)
+            oldest = pinned;
+    }
+
+    // Retired versions are ordered by epoch
+    unsigned int count = 0;
+    while (count < retired.size() && retired[count].first < oldest) {
+        if (spare.size() < SPARE_VERSIONS)
+            spare.push_back(retired[count].second);
+        else
+            delete retired[count].second;
+        ++count;
+    }
+    retired.erase(begin(retired), begin(retired) + count);
+    reclaimed += count;
+}
+
+unsigned long GeoVersions::get_epoch() const {
+    return epoch.load();
+}
+
+unsigned long GeoVersions::get_reclaimed() const {
+    return reclaimed.load();
+}
+
+GeoReader::GeoReader(GeoVersions* versions): versions(versions) {
+    for (int i = 0; i < GeoVersions::MAX_READERS; ++i) {
+        bool expected = false;
+        if (versions->slots[i].in_use.compare_exchange_strong(expected, true)) {
+            slot = i;
+            ++versions->readers;
+            break;
+        }
+    }
+}
+
+GeoReader::~GeoReader() {
+    if (slot != -1) {
+        unpin();
+        versions->slots[slot].in_use = false;
+        --versions->readers;
+    }
+}
+
+bool GeoReader::is_registered() const {
+    return slot != -1;
+}
+
+const GeoSnapshot* GeoReader::pin() {
+    if (slot == -1)
+        return nullptr;
+
+    // Sequentially consistent store then load: the writer either sees the pin or we see its newer version
+    versions->slots[slot].epoch.store(versions->epoch.load());
+    return versions->current.load();
+}
+
+void GeoReader::unpin() {
+    versions->slots[slot].epoch.store(GeoVersions::IDLE);
+}
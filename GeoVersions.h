@@ -0,0 +1,90 @@
+/***************************************************************************
+This class, GeoVersions, keeps versioned read snapshots (GeoSnapshot) of a
+GeoComponents object, so that analysis threads can query coordinates and
+well-definedness while the constructions are being edited (MVCC).
+
+A single writer publishes a new immutable version after each propagation.
+Readers (GeoReader) pin the current epoch and get a consistent version that
+stays valid until they unpin, regardless of how far the writer advances.
+Replaced versions are reclaimed with epoch-based reclamation: a version
+retired at epoch e is recycled once every pinned reader has an epoch > e.
+Readers only ever write to their own slot, so reads scale with cores and
+never slow the writer down. Versions are copied from the frames the writer
+produces anyway, and only while a reader is registered: without readers,
+publishing costs nothing and the version is brought up to date on demand
+(see is_outdated).
+****************************************************************************/
+
+#ifndef GEOVERSIONS_H_
+#define GEOVERSIONS_H_
+
+#include <atomic>
+#include <utility>
+#include <vector>
+#include "GeoSnapshot.h"
+
+class GeoComponents;
+
+class GeoVersions {
+    friend class GeoReader; /**< @brief GeoReader pins versions through the reader slots. */
+
+public:
+    static const int MAX_READERS = 64; /**< @brief Maximum number of readers registered at the same time. */
+
+    GeoVersions(); /**< @brief Constructor */
+
+    /** @brief Writer side: takes a snapshot of the constructions and makes it the current version, unless no reader is registered. */
+    void publish(const GeoComponents& geo_components);
+    /** @brief Writer side: copies a snapshot just taken and makes it the current version, unless no reader is registered. */
+    void publish(const GeoSnapshot& frame);
+    /** @brief Writer side: returns whether a reader is registered while publishes were skipped, the current version is then to be published again. */
+    bool is_outdated() const;
+
+    unsigned long get_epoch() const; /**< @brief Returns the current epoch (number of versions published plus one). */
+    unsigned long get_reclaimed() const; /**< @brief Returns the number of versions reclaimed so far. */
+
+    virtual ~GeoVersions(); /**< @brief Deletes all versions, no reader may be registered. */
+
+private:
+    /** @brief Per-reader state, one cache line each so that readers do not contend. */
+    struct alignas(64) ReaderSlot {
+        std::atomic<unsigned long> epoch {IDLE}; //!< Epoch pinned by the reader, IDLE if not pinned.
+        std::atomic<bool> in_use {false}; //!< Indicates whether a reader owns the slot.
+    };
+    static const unsigned long IDLE = static_cast<unsigned long>(-1); /**< @brief Epoch of a slot that is not pinned. */
+    static const unsigned int SPARE_VERSIONS = 4; /**< @brief Number of reclaimed versions kept for reuse by the writer. */
+
+    GeoSnapshot* next_version(); /**< @brief Writer side: returns a version to be filled, reclaimed if possible. */
+    void swap_in(GeoSnapshot* next); /**< @brief Writer side: makes a filled version the current one and retires the old one. */
+    void reclaim(); /**< @brief Writer side: recycles retired versions that no pinned reader can see anymore. */
+
+    std::atomic<GeoSnapshot*> current {nullptr}; /**< @brief The newest version. */
+    std::atomic<unsigned long> epoch {1}; /**< @brief Global epoch, increased on every publish. */
+    std::atomic<unsigned long> reclaimed {0}; /**< @brief Number of versions reclaimed so far. */
+    std::atomic<int> readers {0}; /**< @brief Number of registered readers. */
+    bool skipped {true}; /**< @brief Indicates whether a publish was skipped since the current version (writer only). */
+    ReaderSlot slots[MAX_READERS]; /**< @brief Slots of the registered readers. */
+
+    vector<pair<unsigned long, GeoSnapshot*>> retired; /**< @brief Replaced versions with the epoch they were retired at (writer only). */
+    vector<GeoSnapshot*> spare; /**< @brief Reclaimed versions ready to be reused (writer only). */
+};
+
+class GeoReader {
+
+public:
+    GeoReader(GeoVersions* versions); /**< @brief Constructor, registers the reader (see is_registered). */
+
+    bool is_registered() const; /**< @brief Returns whether a slot was available, pin returns nullptr otherwise. */
+    /** @brief Pins the current epoch and returns the current version, which remains valid and unchanged until unpin.
+     *  Right after registration, the version may be outdated (or nullptr) until the writer publishes again. */
+    const GeoSnapshot* pin();
+    void unpin(); /**< @brief Releases the version obtained by pin. */
+
+    virtual ~GeoReader(); /**< @brief Unpins and unregisters the reader. */
+
+private:
+    GeoVersions* versions {nullptr}; /**< @brief Versions read by this reader. */
+    int slot {-1}; /**< @brief Index of the slot owned by this reader, -1 if none. */
+};
+
+#endif /* GEOVERSIONS_H_ */
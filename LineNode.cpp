@@ -5,16 +5,38 @@
 
 #include <cmath>
 #include "LineNode.h"
+#include "GeoDescriptor.h"
+#include "FigurePool.h"
+#include "SolverNode.h"
+#include "GeoPredicates.h"
+
+LineNode::LineNode(LineType type, GeoNode* geo1) : GeoNode(1) {
+    this->type = type;
+
+    // Identification of definition from LineType
+    switch(type) {
+    case LineType::FIRST_SOLUTION:
+    case LineType::SECOND_SOLUTION: identify<double>(); break;
+    default: well_defined = false; return;
+    }
+
+    // Initialization of Data Members
+    parents = new const GeoNode*[num_parents];
+    parents[0] = geo1;
+
+    update();
+}
 
 LineNode::LineNode(LineType type, GeoNode* geo1, GeoNode* geo2) : GeoNode(2) {
+    this->type = type;
 
     // Identification of definition from LineType
     switch(type) {
-    case LineType::POINT_POINT_LINE_THROUGH: definition = &LineNode::point_point_line_through; break;
-    case LineType::POINT_LINE_PARALLEL_LINE_THROUGH: definition = &LineNode::point_line_parallel_line_through; break;
-    case LineType::POINT_POINT_PERPENDICULAR_BISECTOR: definition = &LineNode::point_point_perpendicular_bisector; break;
-    case LineType::POINT_CIRCLE_FIRST_TANGENT: definition = &LineNode::point_circle_first_tangent; break;
-    case LineType::POINT_CIRCLE_SECOND_TANGENT: definition = &LineNode::point_circle_second_tangent; break;
+    case LineType::POINT_POINT_LINE_THROUGH:
+    case LineType::POINT_LINE_PARALLEL_LINE_THROUGH:
+    case LineType::POINT_POINT_PERPENDICULAR_BISECTOR:
+    case LineType::POINT_CIRCLE_FIRST_TANGENT:
+    case LineType::POINT_CIRCLE_SECOND_TANGENT: identify<double>(); break;
     default: well_defined = false; return;
     }
 
@@ -26,6 +48,30 @@ LineNode::LineNode(LineType type, GeoNode* geo1, GeoNode* geo2) : GeoNode(2) {
     update();
 }
 
+template <class T>
+void LineNode::identify() {
+    switch(type) {
+    case LineType::POINT_POINT_LINE_THROUGH: definition = &LineNode::point_point_line_through<T>; break;
+    case LineType::POINT_LINE_PARALLEL_LINE_THROUGH: definition = &LineNode::point_line_parallel_line_through<T>; break;
+    case LineType::POINT_POINT_PERPENDICULAR_BISECTOR: definition = &LineNode::point_point_perpendicular_bisector<T>; break;
+    case LineType::POINT_CIRCLE_FIRST_TANGENT: definition = &LineNode::point_circle_first_tangent<T>; break;
+    case LineType::POINT_CIRCLE_SECOND_TANGENT: definition = &LineNode::point_circle_second_tangent<T>; break;
+    case LineType::FIRST_SOLUTION: definition = &LineNode::first_solution; break;
+    case LineType::SECOND_SOLUTION: definition = &LineNode::second_solution; break;
+    }
+}
+
+void LineNode::set_precision(Precision precision) {
+    this->precision = precision;
+    if(definition == nullptr)
+        return;
+    switch(precision) {
+    case Precision::SINGLE: identify<float>(); break;
+    case Precision::DOUBLE: identify<double>(); break;
+    case Precision::DOUBLE_DOUBLE: identify<DoubleDouble>(); break;
+    }
+}
+
 LineNode::~LineNode() {
     if(line != nullptr)
         (line->parentPlot())->removeItem(line);
@@ -41,16 +87,47 @@ void LineNode::print() const {
     cout << endl;
 }
 
-void LineNode::display(Ui::MainWindow *ui) {
-    if(line == nullptr){ //Initialization
-        line = new QCPItemStraightLine(ui->custom_plot);
-        line->setPen(QPen(QColor(120, 120, 120), 2));
+void LineNode::display(Ui::MainWindow *ui, FigurePool* pool, const double data[], bool defined) {
+    if(line == nullptr){ //Initialization, only once there is something to be seen
+        if(!defined)
+            return;
+        line = pool->acquire_line(ui->custom_plot);
         line->setObjectName(QString::fromStdString(this->get_label()));
     }
 
-    line->setVisible(well_defined);
-    (abs(y_coeff) > EPSILON) ? line->point1->setCoords(0, - c_coeff/y_coeff): line->point1->setCoords(-c_coeff/x_coeff, 1);
-    (abs(x_coeff) > EPSILON) ? line->point2->setCoords(- c_coeff/x_coeff, 0): line->point2->setCoords(1, - c_coeff/y_coeff);
+    // Foot of the perpendicular from the origin, and a step along the direction (-b, a) of the line
+    line->setVisible(defined);
+    line->point1->setCoords(-data[0]*data[2], -data[1]*data[2]);
+    line->point2->setCoords(-data[0]*data[2] - data[1], -data[1]*data[2] + data[0]);
+}
+
+void LineNode::release(FigurePool* pool) {
+    if(line != nullptr){
+        pool->release(line);
+        line = nullptr;
+    }
+}
+
+bool LineNode::in_view(const double data[], const double view[4]) const {
+
+    // The line misses the rectangle iff all four corners lie strictly on the same side
+    double corner[4];
+    corner[0] = data[0] * view[0] + data[1] * view[2] + data[2];
+    corner[1] = data[0] * view[1] + data[1] * view[2] + data[2];
+    corner[2] = data[0] * view[0] + data[1] * view[3] + data[2];
+    corner[3] = data[0] * view[1] + data[1] * view[3] + data[2];
+
+    bool positive = false, negative = false;
+    for (int i = 0; i < 4; ++i) {
+        positive |= (corner[i] >= 0);
+        negative |= (corner[i] <= 0);
+    }
+    return positive && negative;
+}
+
+void LineNode::bounds(const double*, double box[4]) const {
+    box[0] = box[2] = -HUGE_VAL;
+    box[1] = box[3] = HUGE_VAL;
 }
 
 void LineNode::access(double data[]) const {
@@ -67,164 +144,197 @@ void LineNode::mutate(double data[]) {
 }
 
 void LineNode::update() {
+    // Only the tangents need Cartesian coordinates, the other lines are joins taking points at infinity (homogeneous coordinates)
+    bool cartesian = (type == LineType::POINT_CIRCLE_FIRST_TANGENT || type == LineType::POINT_CIRCLE_SECOND_TANGENT);
     well_defined = true;
     for (int i = 0; i < num_parents; ++i)
-        well_defined &= parents[i]->get_well_defined();
+        well_defined &= parents[i]->get_well_defined() && (!cartesian || parents[i]->is_finite());
     if (well_defined)
         (this->*definition)();
+    if (well_defined)
+        normalize();
 }
 
+void LineNode::normalize() {
+    // The line at infinity has a normal negligible against its offset (points beyond 1 / TOLERANCE count as infinite)
+    double norm = x_coeff * x_coeff + y_coeff * y_coeff;
+    double tolerance = GeoPredicates::TOLERANCE;
+    if(norm == 0 || norm <= tolerance * tolerance * c_coeff * c_coeff) {
+        well_defined = false;
+        return;
+    }
+
+    double inverse = 1 / sqrt(norm);
+    x_coeff *= inverse;
+    y_coeff *= inverse;
+    c_coeff *= inverse;
+}
+
+template <class T>
 void LineNode::point_point_line_through() {
 
+    if(coincident(GeoPredicates::tolerance<T>())) {
+        well_defined = false;
+        return;
+    }
+
+    if(projective) {
+        // Data Access
+        double h1[3], h2[3];
+        parents[0]->access_homogeneous(h1);
+        parents[1]->access_homogeneous(h2);
+        T p1[3] = {T(h1[0]), T(h1[1]), T(h1[2])}, p2[3] = {T(h2[0]), T(h2[1]), T(h2[2])};
+
+        // Mathematical Formula: join p1 x p2, scaled by w1 * w2 >= 0 so that the orientation is the Cartesian one
+        x_coeff = static_cast<double>(p1[1] * p2[2] - p1[2] * p2[1]);
+        y_coeff = static_cast<double>(p1[2] * p2[0] - p1[0] * p2[2]);
+        c_coeff = static_cast<double>(p1[0] * p2[1] - p1[1] * p2[0]);
+        return;
+    }
+
     // Data Access
     double p1[2], p2[2];
     parents[0]->access(p1);
     parents[1]->access(p2);
+    T x1 = p1[0], y1 = p1[1], x2 = p2[0], y2 = p2[1];
 
     // Mathematical Formula
-    x_coeff = p1[1] - p2[1];
-    y_coeff = p2[0] - p1[0];
-
-    if(x_coeff < EPSILON && x_coeff > -EPSILON) {
-        if(y_coeff < EPSILON && y_coeff > -EPSILON)
-            well_defined = false;
-    } else {
-        c_coeff = (-y_coeff)*p1[1] + (-x_coeff)*p1[0];
-
-        well_defined = true;
-    }
+    T a = y1 - y2, b = x2 - x1;
+    x_coeff = static_cast<double>(a);
+    y_coeff = static_cast<double>(b);
+    c_coeff = static_cast<double>((-b)*y1 + (-a)*x1);
 }
 
+template <class T>
 void LineNode::point_line_parallel_line_through() {
 
     // Data Access
-    double point[2], line[3];
-    parents[0]->access(point);
+    double point[3], line[3];
+    parents[0]->access_homogeneous(point);
     parents[1]->access(line);
+    T x = point[0], y = point[1], w = point[2], a = line[0], b = line[1];
 
-    // Mathematical Formula
-    x_coeff = line[0];
-    y_coeff = line[1];
-    c_coeff = (-y_coeff)*point[1] + (-x_coeff)*point[0];
+    // Mathematical Formula, scaled by w (1 in Cartesian coordinates): through a point at infinity, the line at infinity (see normalize)
+    x_coeff = static_cast<double>(a * w);
+    y_coeff = static_cast<double>(b * w);
+    c_coeff = static_cast<double>((-b)*y + (-a)*x);
 }
 
+template <class T>
 void LineNode::point_point_perpendicular_bisector() {
 
+    if(coincident(GeoPredicates::tolerance<T>())) {
+        well_defined = false;
+        return;
+    }
+
+    if(projective) {
+        // Data Access
+        double h1[3], h2[3];
+        parents[0]->access_homogeneous(h1);
+        parents[1]->access_homogeneous(h2);
+        T p1[3] = {T(h1[0]), T(h1[1]), T(h1[2])}, p2[3] = {T(h2[0]), T(h2[1]), T(h2[2])};
+
+        // Mathematical Formula, scaled by 2 * w1 * w2 >= 0: no division by the weights
+        T normal_x = p2[0] * p1[2] - p1[0] * p2[2], normal_y = p2[1] * p1[2] - p1[1] * p2[2];
+        x_coeff = static_cast<double>(2 * p1[2] * p2[2] * normal_x);
+        y_coeff = static_cast<double>(2 * p1[2] * p2[2] * normal_y);
+        c_coeff = static_cast<double>((-normal_x)*(p1[0] * p2[2] + p2[0] * p1[2]) + (-normal_y)*(p1[1] * p2[2] + p2[1] * p1[2]));
+        return;
+    }
+
     // Data Access
     double p1[2], p2[2];
     parents[0]->access(p1);
     parents[1]->access(p2);
+    T x1 = p1[0], y1 = p1[1], x2 = p2[0], y2 = p2[1];
 
     // Mathematical Formula
-    x_coeff = p2[0] - p1[0];
-    y_coeff = p2[1] - p1[1];
-    c_coeff = (-x_coeff)*(p1[0] + p2[0])/2 + (-y_coeff)*(p1[1] + p2[1])/2;
-    well_defined = (abs(x_coeff) + abs(y_coeff) > EPSILON);
+    T a = x2 - x1, b = y2 - y1;
+    x_coeff = static_cast<double>(a);
+    y_coeff = static_cast<double>(b);
+    c_coeff = static_cast<double>((-a)*(x1 + x2)/2 + (-b)*(y1 + y2)/2);
+}
+
+bool LineNode::coincident(double tolerance) const {
+    // Points at infinity are left to normalize (their join is the line at infinity)
+    if(!parents[0]->is_finite() || !parents[1]->is_finite())
+        return false;
+
+    // Data Access
+    double p1[2], p2[2];
+    parents[0]->access(p1);
+    parents[1]->access(p2);
+
+    return GeoPredicates::coincident(p1, p2, tolerance);
 }
 
+template <class T>
 void LineNode::point_circle_first_tangent() {
 
     // Data Access
-    double point[2], circle[3];
+    double point[2], circle[3], roots[6];
+    bool defined[2];
     parents[0]->access(point);
     parents[1]->access(circle);
 
     // Mathematical Formula
-    double distance = sqrt((point[0] - circle[0]) * (point[0] - circle[0]) + (point[1] - circle[1]) * (point[1] - circle[1]));
-
-    if(distance - circle[2] < EPSILON && distance - circle[2] > -EPSILON) {
-        x_coeff = point[0] - circle[0];
-        y_coeff = point[1] - circle[1];
-        c_coeff = (-x_coeff)*point[0] + (-y_coeff)*point[1];
-
-        well_defined = true;
-
-    } else if(distance < circle[2]) {
-        well_defined = false;
-
-    } else {
-        //Let the line be: (y-point_y)=k(x-point_x)
-        double sk_coeff, k_coeff, c, k;
-
-        //Define variables for simplicity
-        double delta_x, delta_y, radius;
-        delta_x = circle[0] - point[0];
-        delta_y = point[1] - circle[1];
-        radius = circle[2];
-
-        //Compute the coefficients of the quadratic
-        sk_coeff = delta_x*delta_x - radius*radius;
-        k_coeff = 2*delta_x*delta_y;
-        c = delta_y*delta_y - radius*radius;
-
-        //Solve for the slope
-        if(abs(sk_coeff) < EPSILON) {
-            x_coeff = 1;
-            y_coeff = 0;
-            c_coeff = -point[0];
-
-        } else {
-            k = (-k_coeff + sqrt(k_coeff*k_coeff - 4*sk_coeff*c))/(2*sk_coeff);
-            x_coeff = k;
-            y_coeff = -1;
-            c_coeff = -k*point[0] + point[1];
-        }
-
-        well_defined = true;
-    }
+    SolverNode::point_circle_tangents<T>(point, circle, roots, defined);
+    solution(roots, defined, 0);
 }
 
+template <class T>
 void LineNode::point_circle_second_tangent() {
 
     // Data Access
-    double point[2], circle[3];
+    double point[2], circle[3], roots[6];
+    bool defined[2];
     parents[0]->access(point);
     parents[1]->access(circle);
 
     // Mathematical Formula
-    double distance = sqrt((point[0] - circle[0]) * (point[0] - circle[0]) + (point[1] - circle[1]) * (point[1] - circle[1]));
+    SolverNode::point_circle_tangents<T>(point, circle, roots, defined);
+    solution(roots, defined, 1);
+}
 
-    if(distance - circle[2] < EPSILON && distance - circle[2] > -EPSILON) {
-        well_defined = false;
+void LineNode::first_solution() {
 
-    } else if(distance < circle[2]) {
-        well_defined = false;
+    // Data Access: both roots were solved once by the parent
+    double data[DATA_SIZE];
+    parents[0]->access(data);
+
+    bool defined[2] = {data[SolverNode::DEFINED] != 0, data[SolverNode::DEFINED + 1] != 0};
+    solution(data, defined, 0);
+}
+
+void LineNode::second_solution() {
+
+    // Data Access: both roots were solved once by the parent
+    double data[DATA_SIZE];
+    parents[0]->access(data);
 
-    } else {
-        //Let the line be: (y-point_y)=k(x-point_x)
-        double sk_coeff, k_coeff, c, k;
-
-        //Define variables for simplicity
-        double delta_x, delta_y, radius;
-        delta_x = circle[0] - point[0];
-        delta_y = point[1] - circle[1];
-        radius = circle[2];
-
-        //Compute the coefficients of the quadratic
-        sk_coeff = delta_x*delta_x - radius*radius;
-        k_coeff = 2*delta_x*delta_y;
-        c = delta_y*delta_y - radius*radius;
-
-        if(abs(sk_coeff) < EPSILON) {
-            // Linear case
-            k = -c/k_coeff;
-            x_coeff = k;
-            y_coeff = -1;
-            c_coeff = -k*point[0] + point[1];
-
-        } else {
-            //Solve for the slope
-            k = (-k_coeff - sqrt(k_coeff*k_coeff - 4*sk_coeff*c))/(2*sk_coeff);
-            x_coeff = k;
-            y_coeff = -1;
-            c_coeff = -k*point[0] + point[1];
-        }
+    bool defined[2] = {data[SolverNode::DEFINED] != 0, data[SolverNode::DEFINED + 1] != 0};
+    solution(data, defined, 1);
+}
+
+void LineNode::solution(const double roots[], const bool defined[2], int root) {
+    if(defined[root]) {
+        x_coeff = roots[3 * root];
+        y_coeff = roots[3 * root + 1];
+        c_coeff = roots[3 * root + 2];
 
         well_defined = true;
 
-    }
+    } else { well_defined = false; }
 }
 
 void LineNode::labels(vector<string>*, vector<string>* line_labels, vector<string>*, vector<string>*) const {
     line_labels->push_back(this->get_label());
 }
+
+bool LineNode::structure(vector<unsigned int>* key) const {
+    // The orientation of the line follows the order of the parents
+    bool symmetric = false;
+    make_structure(static_cast<unsigned int>(GeoKind::LINE), static_cast<unsigned int>(type), symmetric, key);
+    return true;
+}
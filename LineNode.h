@@ -1,5 +1,10 @@
 /***************************************************************************
 This class, LineNode, defines a Line. It is derived from GeoNode.
+Lines are kept in Hesse normal form (unit normal): the distance of a point
+to the line is the value of its equation, so that the constructions built
+on lines need neither square roots nor divisions by the norm. In homogeneous
+coordinates, the lines through points are computed as joins (cross products)
+without dividing by the weights; the line at infinity is not well-defined.
 ****************************************************************************/
 
 #ifndef LINENODE_H_
@@ -12,40 +17,61 @@ enum class LineType {
     POINT_LINE_PARALLEL_LINE_THROUGH, //!< Line passing through a given point that is parallel to the given Line.
     POINT_POINT_PERPENDICULAR_BISECTOR, //!< Perpedicular bisector of the segment defined by two given points.
     POINT_CIRCLE_FIRST_TANGENT, //!< First tangent from the given point to the given circle.
-    POINT_CIRCLE_SECOND_TANGENT //!< Second tangent from the given point to the given circle.
+    POINT_CIRCLE_SECOND_TANGENT, //!< Second tangent from the given point to the given circle.
+    FIRST_SOLUTION, //!< First root of a given solver (tangents, see SolverNode).
+    SECOND_SOLUTION //!< Second root of a given solver (tangents, see SolverNode).
 };
 
 class LineNode: public GeoNode {
 
 public:
+    LineNode(LineType type, GeoNode* geo1); /**< @brief Constructor of a line defined by a single parent. */
     LineNode(LineType type, GeoNode* geo1, GeoNode* geo2); /**< @brief Constructor of a line defined by two parents. */
 
     virtual ~LineNode() override; /**< @brief Destructor. */
 
 private:
     //@{
-    /** @brief Data components: The line equation is given by (x_coeff)*x + (y_coeff)*y + (c_coeff) = 0. */
+    /** @brief Data components: The line equation is given by (x_coeff)*x + (y_coeff)*y + (c_coeff) = 0, with x_coeff^2 + y_coeff^2 = 1. */
     double x_coeff{0}, y_coeff{0}, c_coeff{0};
     //@}
     QCPItemStraightLine *line {nullptr}; //!< Corresponding figure that represents the line on the plot.
     /** @brief Function pointer indicating the definition of the line. */
     void (LineNode::*definition)() {nullptr};
+    LineType type; //!< Type of the line, identifies its definition.
 
     virtual void print() const override; /**< @brief Prints all data components of the line (Debugging purposes only). */
-    virtual void display(Ui::MainWindow* ui) override; /**< @brief Updates the corresponding figure on the plot (*line). */
+    virtual void display(Ui::MainWindow* ui, FigurePool* pool, const double data[], bool defined) override; /**< @brief Updates the corresponding figure on the plot (*line) from the given data, taking it from the pool on first need. */
+    virtual void release(FigurePool* pool) override; /**< @brief Gives the corresponding figure (*line) back to the pool. */
+    virtual bool in_view(const double data[], const double view[4]) const override; /**< @brief Returns whether the line crosses the view rectangle. */
+    virtual void bounds(const double data[], double box[4]) const override; /**< @brief Sets box to the whole plane. */
     /** @brief Takes a collection of string vectors and adds the label of the line to the line_labels vector. */
     virtual void labels(vector<string>*, vector<string>* line_labels, vector<string>*, vector<string>*) const override;
+    virtual bool structure(vector<unsigned int>* key) const override; /**< @brief Sets key to {kind, type, parent pids}. */
 
-    virtual void access(double data[]) const override; /**< @brief Sets the array data as {x_coeff, y_coeff, c_coeff}. */
+    virtual void access(double data[]) const override; /**< @brief Sets the array data as {x_coeff, y_coeff, c_coeff}, (x_coeff, y_coeff) being a unit vector. */
     virtual void mutate(double data[]) override; /**< @brief Edits the line based on data = {new x_coeff, new y_coeff, new c_coeff}. */
 
-    virtual void update() override; /**< @brief Updates the construction to adjust for changes of the parents. */
+    virtual void update() override; /**< @brief Updates the construction to adjust for changes of the parents, then normalizes it. */
+    void normalize(); /**< @brief Scales the coefficients to a unit normal, the line is not well-defined if the normal vanishes (line at infinity). */
+    bool coincident(double tolerance) const; /**< @brief Returns whether both (finite) parent points coincide within the tolerance, see GeoPredicates::coincident. */
 
-    void point_point_line_through(); /**< @brief Defines a line passing through two given points. */
-    void point_line_parallel_line_through(); /**< @brief Defines a line passing through a given point that is parallel to a given line. */
-    void point_point_perpendicular_bisector(); /**< @brief Defines a line that is the perpedicular bisector of the segment defined by two given points. */
-    void point_circle_first_tangent(); /**< @brief Defines a line that is the first tangent from the given point to the given circle. */
-    void point_circle_second_tangent(); /**< @brief Defines a line that is the second tangent from the given point to the given circle. */
+    /** @brief Sets the definition of the type, computed in the scalar type T. */
+    template <class T> void identify();
+    virtual void set_precision(Precision precision) override; /**< @brief Sets the definition of the type again, computed in the given precision. */
+
+    //@{
+    /** @brief Definitions computed in the scalar type T (see GeoScalar.h), the data being kept in double and normalized in double. */
+    template <class T> void point_point_line_through(); /**< @brief Defines a line passing through two given points. */
+    template <class T> void point_line_parallel_line_through(); /**< @brief Defines a line passing through a given point that is parallel to a given line. */
+    template <class T> void point_point_perpendicular_bisector(); /**< @brief Defines a line that is the perpedicular bisector of the segment defined by two given points. */
+    template <class T> void point_circle_first_tangent(); /**< @brief Defines a line that is the first tangent from the given point to the given circle. */
+    template <class T> void point_circle_second_tangent(); /**< @brief Defines a line that is the second tangent from the given point to the given circle. */
+    //@}
+    void first_solution(); /**< @brief Defines a line as the first root of a solver. */
+    void second_solution(); /**< @brief Defines a line as the second root of a solver. */
+    /** @brief Takes the roots of a solve (see SolverNode) and sets the line to the one with the given index, if it exists. */
+    void solution(const double roots[], const bool defined[2], int root);
 
 };
 
@@ -0,0 +1,173 @@
+/*
+ * PointClusters.cpp
+ *
+ */
+
+#include <cmath>
+#include <climits>
+#include "PointClusters.h"
+
+const long long PointClusters::NO_CELL = LLONG_MIN;
+
+PointClusters::PointClusters(GeoComponents* geo_components): geo_components(geo_components) {}
+
+PointClusters::~PointClusters() {
+    for (int i = 0; i < GLYPH_LEVELS; ++i) {
+        if (glyphs[i] != nullptr)
+            (glyphs[i]->parentPlot())->removeGraph(glyphs[i]);
+    }
+}
+
+void PointClusters::update(Ui::MainWindow* ui, const GeoSnapshot& snapshot, const double view[4], double pixel_size, vector<unsigned int>* changed) {
+    if (snapshot.topology != geo_components->get_topology() || snapshot.size() != geo_components->size())
+        return;
+
+    // New topology: the points must be binned again
+    bool regroup = (snapshot.topology != topology);
+    topology = snapshot.topology;
+
+    unsigned int points = 0;
+    for (unsigned int i = 0; i < snapshot.size(); ++i)
+        points += geo_components->is_point(i);
+
+    if (!enabled || points < threshold || !(pixel_size > 0)) {
+        if (active) {
+            for (unsigned int i = 0; i < snapshot.size(); ++i) {
+                if (geo_components->set_hidden(i, GeoComponents::HIDE_CLUSTERED, false))
+                    changed->push_back(i);
+            }
+            clear();
+            active = false;
+        }
+        draw(ui, view);
+        return;
+    }
+
+    // Cells of a power-of-two side close to cell_pixels on screen
+    int new_level = static_cast<int>(ceil(log2(cell_pixels * pixel_size)));
+    if (!active || regroup || new_level != level) {
+        clear();
+        level = new_level;
+        keys.assign(snapshot.size(), NO_CELL);
+        xs.assign(snapshot.size(), 0);
+        ys.assign(snapshot.size(), 0);
+        active = true;
+    }
+
+    // Move the points whose coordinates changed
+    for (unsigned int i = 0; i < snapshot.size(); ++i) {
+        if (!geo_components->is_point(i))
+            continue;
+
+        // Points at infinity (homogeneous coordinates) are not binned, their sums would never come back finite
+        const double* point = snapshot.access(i);
+        if (!snapshot.well_defined[i] || !isfinite(point[0]) || !isfinite(point[1])) {
+            if (keys[i] != NO_CELL)
+                unbin(i);
+            continue;
+        }
+        if (keys[i] != NO_CELL && xs[i] == point[0] && ys[i] == point[1])
+            continue;
+
+        if (keys[i] != NO_CELL)
+            unbin(i);
+        bin(i, key(point[0], point[1]), point[0], point[1]);
+    }
+
+    // Hide the points sharing a cell
+    for (unsigned int i = 0; i < snapshot.size(); ++i) {
+        if (!geo_components->is_point(i))
+            continue;
+
+        bool clustered = (keys[i] != NO_CELL && cells[keys[i]].count >= 2);
+        if (geo_components->set_hidden(i, GeoComponents::HIDE_CLUSTERED, clustered))
+            changed->push_back(i);
+    }
+
+    draw(ui, view);
+}
+
+long long PointClusters::key(double x, double y) const {
+    double cell_x = floor(ldexp(x, -level)), cell_y = floor(ldexp(y, -level));
+    cell_x = max(static_cast<double>(INT_MIN), min(cell_x, static_cast<double>(INT_MAX)));
+    cell_y = max(static_cast<double>(INT_MIN), min(cell_y, static_cast<double>(INT_MAX)));
+    unsigned long long high = static_cast<unsigned long long>(static_cast<long long>(cell_x)), low = static_cast<unsigned long long>(static_cast<long long>(cell_y));
+    return static_cast<long long>((high << 32) | (low & 0xffffffffULL));
+}
+
+void PointClusters::bin(unsigned int pid, long long cell, double x, double y) {
+    Cell& target = cells[cell];
+    ++target.count;
+    target.sum_x += x;
+    target.sum_y += y;
+
+    keys[pid] = cell;
+    xs[pid] = x;
+    ys[pid] = y;
+}
+
+void PointClusters::unbin(unsigned int pid) {
+    auto it = cells.find(keys[pid]);
+    if (--(it->second.count) == 0) {
+        cells.erase(it);
+    } else {
+        it->second.sum_x -= xs[pid];
+        it->second.sum_y -= ys[pid];
+    }
+    keys[pid] = NO_CELL;
+}
+
+void PointClusters::clear() {
+    cells.clear();
+    keys.assign(keys.size(), NO_CELL);
+}
+
+void PointClusters::draw(Ui::MainWindow* ui, const double view[4]) {
+    if (glyphs[0] == nullptr) { //Initialization
+        for (int i = 0; i < GLYPH_LEVELS; ++i) {
+            glyphs[i] = ui->custom_plot->addGraph();
+            glyphs[i]->setLineStyle(QCPGraph::lsNone);
+            glyphs[i]->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssDisc, QColor(255, 255, 255, 90 + 50 * i), QColor(255, 255, 255, 90 + 50 * i), 8 + 5 * i));
+            glyphs[i]->setLayer("front");
+            glyphs[i]->setSelectable(QCP::stNone);
+        }
+    }
+
+    // Glyph size by powers of four: 2-3 points, 4-15, 16-63, 64 and more
+    QVector<double> glyph_x[GLYPH_LEVELS], glyph_y[GLYPH_LEVELS];
+    clusters = 0;
+    for (auto it = begin(cells); it != end(cells); ++it) {
+        if (it->second.count < 2)
+            continue;
+
+        double x = it->second.sum_x / it->second.count, y = it->second.sum_y / it->second.count;
+        if (x < view[0] || x > view[1] || y < view[2] || y > view[3])
+            continue;
+
+        int size = 0;
+        for (unsigned int count = it->second.count; count >= 4 && size < GLYPH_LEVELS - 1; count /= 4)
+            ++size;
+        glyph_x[size].push_back(x);
+        glyph_y[size].push_back(y);
+        ++clusters;
+    }
+
+    for (int i = 0; i < GLYPH_LEVELS; ++i)
+        glyphs[i]->setData(glyph_x[i], glyph_y[i]);
+}
+
+void PointClusters::set_enabled(bool enabled) {
+    this->enabled = enabled;
+}
+
+void PointClusters::set_threshold(unsigned int threshold) {
+    this->threshold = threshold;
+}
+
+void PointClusters::set_cell_pixels(int cell_pixels) {
+    this->cell_pixels = cell_pixels;
+}
+
+unsigned int PointClusters::get_clusters() const {
+    return clusters;
+}
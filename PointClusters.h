@@ -0,0 +1,68 @@
+/***************************************************************************
+This class, PointClusters, provides the level-of-detail mode for dense
+point clusters. Points (and triangle centers) are binned into square cells
+of about cell_pixels on screen; every cell holding two or more points is
+drawn as a single glyph at the mean position of its points, whose size and
+opacity grow with the number of points, while their own figures are hidden.
+Zooming in shrinks the cells until every point is alone again.
+
+Cells are anchored in plot coordinates with a power-of-two side, so panning
+never moves a point to another cell and zooming only regroups points when
+the side changes by a factor of two. Between regroupings, only the points
+whose coordinates changed are moved between cells.
+****************************************************************************/
+
+#ifndef POINTCLUSTERS_H_
+#define POINTCLUSTERS_H_
+
+#include <unordered_map>
+#include <vector>
+#include "GeoComponents.h"
+
+class PointClusters {
+
+public:
+    PointClusters(GeoComponents* geo_components); /**< @brief Constructor, takes the (not owned) GeoComponents object. */
+
+    /** @brief Takes a snapshot, the view rectangle {x_min, x_max, y_min, y_max} and the size of a pixel in plot coordinates.
+     *  Updates the cells and glyphs, and adds to changed the pids whose figures must be displayed again. */
+    void update(Ui::MainWindow* ui, const GeoSnapshot& snapshot, const double view[4], double pixel_size, vector<unsigned int>* changed);
+
+    void set_enabled(bool enabled); /**< @brief Enables or disables the mode, it takes effect on the next update. */
+    void set_threshold(unsigned int threshold); /**< @brief Sets the number of points below which the mode stays inactive. */
+    void set_cell_pixels(int cell_pixels); /**< @brief Sets the approximate side of a cell on screen. */
+    unsigned int get_clusters() const; /**< @brief Returns the number of glyphs drawn by the last update. */
+
+    virtual ~PointClusters(); /**< @brief Removes the glyphs from the plot. */
+
+private:
+    /** @brief Points binned in one cell. */
+    struct Cell {
+        unsigned int count {0}; //!< Number of points in the cell.
+        double sum_x {0}, sum_y {0}; //!< Sums of the coordinates, for the mean position.
+    };
+    static const long long NO_CELL; /**< @brief Key of a pid that is not binned (not a point, not well-defined or at infinity). */
+    static const int GLYPH_LEVELS = 4; /**< @brief Number of glyph sizes, by powers of four of the number of points. */
+
+    long long key(double x, double y) const; /**< @brief Returns the key of the cell containing (x, y) at the current level. */
+    void bin(unsigned int pid, long long cell, double x, double y); /**< @brief Adds the point with the given pid to a cell. */
+    void unbin(unsigned int pid); /**< @brief Removes the point with the given pid from its cell. */
+    void clear(); /**< @brief Removes every point from the cells. */
+    void draw(Ui::MainWindow* ui, const double view[4]); /**< @brief Updates the glyphs of the cells holding several points. */
+
+    GeoComponents* geo_components {nullptr}; /**< @brief Constructions binned (not owned). */
+    bool enabled {true}; /**< @brief Indicates whether the mode is enabled. */
+    bool active {false}; /**< @brief Indicates whether points are currently binned. */
+    unsigned int threshold {1000}; /**< @brief Number of points below which the mode stays inactive. */
+    int cell_pixels {8}; /**< @brief Approximate side of a cell on screen. */
+    int level {0}; /**< @brief Cells have a side of 2^level in plot coordinates. */
+    unsigned long topology {0}; /**< @brief Topology of the constructions binned. */
+    unsigned int clusters {0}; /**< @brief Number of glyphs drawn by the last update. */
+
+    vector<long long> keys; /**< @brief Cell of each pid, NO_CELL if not binned. */
+    vector<double> xs, ys; /**< @brief Coordinates with which each pid was binned. */
+    unordered_map<long long, Cell> cells; /**< @brief Non-empty cells by key. */
+    QCPGraph* glyphs[GLYPH_LEVELS] {nullptr, nullptr, nullptr, nullptr}; /**< @brief Figures of the glyphs, one per size. */
+};
+
+#endif /* POINTCLUSTERS_H_ */
@@ -5,12 +5,17 @@
 
 #include <cmath>
 #include "PointNode.h"
+#include "GeoDescriptor.h"
+#include "FigurePool.h"
+#include "SolverNode.h"
+#include "GeoPredicates.h"
 
 PointNode::PointNode(PointType type, double x, double y) {
+    this->type = type;
 
     // Identification of definition from PointType
     switch(type) {
-    case PointType::INDEPENDENT: definition = &PointNode::independent; break;
+    case PointType::INDEPENDENT: identify<double>(); break;
     default: well_defined = false; return;
     }
 
@@ -20,11 +25,14 @@ PointNode::PointNode(PointType type, double x, double y) {
 }
 
 PointNode::PointNode(PointType type, GeoNode* geo1, double x, double y) : GeoNode(1) {
+    this->type = type;
 
     // Identification of definition from PointType
     switch(type) {
-    case PointType::ON_LINE: definition = &PointNode::on_line; break;
-    case PointType::ON_CIRCLE:	definition = &PointNode::on_circle; break;
+    case PointType::ON_LINE:
+    case PointType::ON_CIRCLE:
+    case PointType::FIRST_SOLUTION:
+    case PointType::SECOND_SOLUTION: identify<double>(); break;
     default: well_defined = false; return;
     }
 
@@ -38,15 +46,16 @@ PointNode::PointNode(PointType type, GeoNode* geo1, double x, double y) : GeoNod
 }
 
 PointNode::PointNode(PointType type, GeoNode* geo1, GeoNode* geo2) : GeoNode(2) {
+    this->type = type;
 
     // Identification of definition from PointType
     switch(type) {
-    case PointType::POINT_POINT_MIDPOINT: definition = &PointNode::point_point_midpoint; break;
-    case PointType::LINE_LINE_INTERSECTION: definition = &PointNode::line_line_intersection; break;
-    case PointType::LINE_CIRCLE_FIRST_INTERSECTION: definition = &PointNode::line_circle_first_intersection; break;
-    case PointType::LINE_CIRCLE_SECOND_INTERSECTION: definition = &PointNode::line_circle_second_intersection; break;
-    case PointType::CIRCLE_CIRCLE_FIRST_INTERSECTION: definition = &PointNode::circle_circle_first_intersection; break;
-    case PointType::CIRCLE_CIRCLE_SECOND_INTERSECTION: definition = &PointNode::circle_circle_second_intersection; break;
+    case PointType::POINT_POINT_MIDPOINT:
+    case PointType::LINE_LINE_INTERSECTION:
+    case PointType::LINE_CIRCLE_FIRST_INTERSECTION:
+    case PointType::LINE_CIRCLE_SECOND_INTERSECTION:
+    case PointType::CIRCLE_CIRCLE_FIRST_INTERSECTION:
+    case PointType::CIRCLE_CIRCLE_SECOND_INTERSECTION: identify<double>(); break;
     default: well_defined = false; return;
     }
 
@@ -58,11 +67,43 @@ PointNode::PointNode(PointType type, GeoNode* geo1, GeoNode* geo2) : GeoNode(2)
     update();
 }
 
+template <class T>
+void PointNode::identify() {
+    switch(type) {
+    case PointType::INDEPENDENT: definition = &PointNode::independent; break;
+    case PointType::ON_LINE: definition = &PointNode::on_line<T>; break;
+    case PointType::ON_CIRCLE: definition = &PointNode::on_circle<T>; break;
+    case PointType::POINT_POINT_MIDPOINT: definition = &PointNode::point_point_midpoint<T>; break;
+    case PointType::LINE_LINE_INTERSECTION: definition = &PointNode::line_line_intersection<T>; break;
+    case PointType::LINE_CIRCLE_FIRST_INTERSECTION: definition = &PointNode::line_circle_first_intersection<T>; break;
+    case PointType::LINE_CIRCLE_SECOND_INTERSECTION: definition = &PointNode::line_circle_second_intersection<T>; break;
+    case PointType::CIRCLE_CIRCLE_FIRST_INTERSECTION: definition = &PointNode::circle_circle_first_intersection<T>; break;
+    case PointType::CIRCLE_CIRCLE_SECOND_INTERSECTION: definition = &PointNode::circle_circle_second_intersection<T>; break;
+    case PointType::FIRST_SOLUTION: definition = &PointNode::first_solution; break;
+    case PointType::SECOND_SOLUTION: definition = &PointNode::second_solution; break;
+    }
+}
+
+void PointNode::set_precision(Precision precision) {
+    this->precision = precision;
+    if(definition == nullptr)
+        return;
+    switch(precision) {
+    case Precision::SINGLE: identify<float>(); break;
+    case Precision::DOUBLE: identify<double>(); break;
+    case Precision::DOUBLE_DOUBLE: identify<DoubleDouble>(); break;
+    }
+}
+
 PointNode::~PointNode() {
     if(point != nullptr)
         (point->parentPlot())->removeGraph(point);
 }
 
+bool PointNode::is_point() const {
+    return true;
+}
+
 void PointNode::print() const {
     cout << "----------------------------------------\n";
     cout << "Identifier: " << this->get_label() << endl;
@@ -73,32 +114,68 @@ void PointNode::print() const {
     cout << endl;
 }
 
-void PointNode::display(Ui::MainWindow *ui) {
-    if(point == nullptr){ //Initialization
-        point = ui->custom_plot->addGraph();
-        point->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, QPen(Qt::black, 1.5), QBrush(Qt::white), 9));
-        point->setPen(QPen(QColor(120, 120, 120), 2));
-        point->setLayer("front");
+void PointNode::display(Ui::MainWindow *ui, FigurePool* pool, const double data[], bool defined) {
+    // Points at infinity are well-defined but cannot be drawn
+    defined &= std::isfinite(data[0]) && std::isfinite(data[1]);
+    if(point == nullptr){ //Initialization, only once there is something to be seen
+        if(!defined)
+            return;
+        point = pool->acquire_point(ui->custom_plot);
         point->setName(QString::fromStdString(this->get_label()));
     }
 
-    point->setVisible(well_defined);
+    point->setVisible(defined);
     point->data()->clear();
-    point->addData(x, y);
+    point->addData(data[0], data[1]);
+}
+
+void PointNode::release(FigurePool* pool) {
+    if(point != nullptr){
+        pool->release(point);
+        point = nullptr;
+    }
+}
+
+bool PointNode::in_view(const double data[], const double view[4]) const {
+    return data[0] >= view[0] && data[0] <= view[1] && data[1] >= view[2] && data[1] <= view[3];
+}
+
+void PointNode::bounds(const double data[], double box[4]) const {
+    box[0] = box[1] = data[0];
+    box[2] = box[3] = data[1];
 }
 
 void PointNode::access(double data[]) const {
+    // Division at query time, the only one in homogeneous coordinates
+    if(is_finite()) {
+        data[0] = x / w;
+        data[1] = y / w;
+    } else {
+        data[0] = (x != 0) ? copysign(HUGE_VAL, x) : 0;
+        data[1] = (y != 0) ? copysign(HUGE_VAL, y) : 0;
+    }
+}
+
+void PointNode::access_homogeneous(double data[]) const {
     data[0] = x;
     data[1] = y;
+    data[2] = w;
+}
+
+bool PointNode::is_finite() const {
+    return !projective || abs(w) > GeoPredicates::TOLERANCE * (abs(x) + abs(y));
 }
 
 void PointNode::mutate(double data[]) {
     x = data[0];
     y = data[1];
+    w = 1;
     update();
 }
 
 void PointNode::update() {
+    // Definitions in Cartesian coordinates leave the weight at 1
+    w = 1;
     well_defined = true;
     for (int i = 0; i < num_parents; ++i)
         well_defined &= parents[i]->get_well_defined();
@@ -108,18 +185,21 @@ void PointNode::update() {
 
 void PointNode::independent() {}
 
+template <class T>
 void PointNode::on_line() {
 
     // Data Access
     double line[3];
     parents[0]->access(line);
+    T a = line[0], b = line[1], c = line[2], point_x = x, point_y = y;
 
-    // Mathematical Formula
-    double t = (line[0] * x + line[1] * y + line[2])/(line[0] * line[0] + line[1] * line[1]);
-    x -= line[0] * t;
-    y -= line[1] * t;
+    // Mathematical Formula (unit normal: t is the signed distance to the line)
+    T t = a * point_x + b * point_y + c;
+    x = static_cast<double>(point_x - a * t);
+    y = static_cast<double>(point_y - b * t);
 }
 
+template <class T>
 void PointNode::on_circle() {
 
     // Data Access
@@ -127,204 +207,184 @@ void PointNode::on_circle() {
     parents[0]->access(circle);
 
     // Mathematical Formula
-    double current_radius = sqrt((x - circle[0]) * (x - circle[0]) + (y - circle[1]) * (y - circle[1]));
+    double point[2] = {x, y};
 
-    if(current_radius < EPSILON) {
+    if(GeoPredicates::coincident(point, circle, GeoPredicates::tolerance<T>())) {
         well_defined = false;
 
     } else {
-        x = circle[0] + (x - circle[0]) * circle[2] / current_radius;
-        y = circle[1] + (y - circle[1]) * circle[2] / current_radius;
+        T center_x = circle[0], center_y = circle[1], radius = circle[2];
+        T delta_x = T(x) - center_x, delta_y = T(y) - center_y;
+        T current_radius = sqrt(delta_x * delta_x + delta_y * delta_y);
+        x = static_cast<double>(center_x + delta_x * radius / current_radius);
+        y = static_cast<double>(center_y + delta_y * radius / current_radius);
 
         well_defined = true;
 
     }
 }
 
+template <class T>
 void PointNode::point_point_midpoint() {
 
+    if(projective) {
+        // Data Access
+        double h1[3], h2[3];
+        parents[0]->access_homogeneous(h1);
+        parents[1]->access_homogeneous(h2);
+        T p1[3] = {T(h1[0]), T(h1[1]), T(h1[2])}, p2[3] = {T(h2[0]), T(h2[1]), T(h2[2])};
+
+        // Mathematical Formula: the midpoint with a point at infinity is that point, two points at infinity have none
+        x = static_cast<double>(p1[0] * p2[2] + p2[0] * p1[2]);
+        y = static_cast<double>(p1[1] * p2[2] + p2[1] * p1[2]);
+        w = static_cast<double>(2 * p1[2] * p2[2]);
+        well_defined = (abs(x) + abs(y) + w > 0);
+        return;
+    }
+
     // Data Access
     double p1[2], p2[2];
     parents[0]->access(p1);
     parents[1]->access(p2);
 
     // Mathematical Formula
-    x = (p1[0]+p2[0])/2;
-    y = (p1[1]+p2[1])/2;
+    x = static_cast<double>((T(p1[0]) + T(p2[0])) / 2);
+    y = static_cast<double>((T(p1[1]) + T(p2[1])) / 2);
 }
 
+template <class T>
 void PointNode::line_line_intersection() {
 
     // Data Access
-    double delta, delta_x, delta_y;
     double line1[3], line2[3];
     parents[0]->access(line1);
     parents[1]->access(line2);
+    T a1 = line1[0], b1 = line1[1], c1 = line1[2];
+    T a2 = line2[0], b2 = line2[1], c2 = line2[2];
+
+    if(projective) {
+        // Mathematical Formula: meet line1 x line2, with w >= 0, parallel lines meet at infinity and only equal lines do not meet
+        T meet_x = b1 * c2 - c1 * b2;
+        T meet_y = c1 * a2 - a1 * c2;
+        T meet_w = a1 * b2 - b1 * a2;
+        T sign = copysign(T(1), meet_w);
+        x = static_cast<double>(meet_x * sign);
+        y = static_cast<double>(meet_y * sign);
+        w = static_cast<double>(meet_w * sign);
+        well_defined = (abs(x) + abs(y) + w > GeoPredicates::tolerance<T>() * (1 + abs(line1[2]) + abs(line2[2])));
+        return;
+    }
 
     // Mathematical Formula
-    delta = line1[0] * line2[1] - line1[1] * line2[0];
-
-    if(delta < EPSILON && delta > -EPSILON) {
+    if(GeoPredicates::crossing(line1, line2, GeoPredicates::tolerance<T>()) == 0) {
         well_defined = false;
 
     } else {
-        delta_x = - line1[2] * line2[1] + line1[1] * line2[2];
-        delta_y = - line1[0] * line2[2] + line1[2] * line2[0];
-        x = delta_x / delta;
-        y = delta_y / delta;
+        T delta = a1 * b2 - b1 * a2;
+        T delta_x = - c1 * b2 + b1 * c2;
+        T delta_y = - a1 * c2 + c1 * a2;
+        x = static_cast<double>(delta_x / delta);
+        y = static_cast<double>(delta_y / delta);
 
         well_defined = true;
 
     }
 }
 
+template <class T>
 void PointNode::line_circle_first_intersection() {
 
     // Data Access
-    double line[3], circle[3];
+    double line[3], circle[3], roots[6];
+    bool defined[2];
     parents[0]->access(line);
     parents[1]->access(circle);
 
     // Mathematical Formula
-    double project_x = circle[0], project_y = circle[1];
-    double t = (line[0] * project_x + line[1] * project_y + line[2])/(line[0] * line[0] + line[1] * line[1]);
-
-    project_x -= line[0] * t;
-    project_y -= line[1] * t;
-
-    double dist = sqrt((project_x - circle[0]) * (project_x - circle[0]) + (project_y - circle[1]) * (project_y - circle[1]));
-
-    if(dist <= circle[2] + EPSILON) {
-        double to_shift = circle[2] * circle[2] - dist * dist;
-        if(to_shift < 0.0) {to_shift = 0;}
-        to_shift = sqrt(to_shift);
-
-        double normalize_factor = sqrt(line[0] * line[0] + line[1] * line[1]);
-        x = project_x + to_shift * line[0] / normalize_factor;
-        y = project_y + to_shift * line[1] / normalize_factor;
-
-        well_defined = true;
-
-    } else { well_defined = false; }
+    SolverNode::line_circle<T>(line, circle, roots, defined);
+    solution(roots, defined, 0);
 }
 
+template <class T>
 void PointNode::line_circle_second_intersection() {
 
     // Data Access
-    double line[3], circle[3];
+    double line[3], circle[3], roots[6];
+    bool defined[2];
     parents[0]->access(line);
     parents[1]->access(circle);
 
     // Mathematical Formula
-    double project_x = circle[0], project_y = circle[1];
-    double t = (line[0] * project_x + line[1] * project_y + line[2])/(line[0] * line[0] + line[1] * line[1]);
-
-    project_x -= line[0] * t;
-    project_y -= line[1] * t;
-
-    double dist = sqrt((project_x - circle[0]) * (project_x - circle[0]) + (project_y - circle[1]) * (project_y - circle[1]));
-
-    if(dist <= circle[2] + EPSILON){
-        double to_shift = circle[2] * circle[2] - dist * dist;
-        if(to_shift < 0.0) { to_shift = 0; }
-        to_shift = sqrt(to_shift);
-
-        if(to_shift < EPSILON){
-            well_defined = false;
-            return;
-        }
-
-        double normalize_factor = sqrt(line[0] * line[0] + line[1] * line[1]);
-        x = project_x - to_shift * line[0] / normalize_factor;
-        y = project_y - to_shift * line[1] / normalize_factor;
-
-        well_defined = true;
-
-    } else { well_defined = false; }
+    SolverNode::line_circle<T>(line, circle, roots, defined);
+    solution(roots, defined, 1);
 }
 
-
+template <class T>
 void PointNode::circle_circle_first_intersection() {
 
     // Data Access
-    double circle1[3], circle2[3];
+    double circle1[3], circle2[3], roots[6];
+    bool defined[2];
     parents[0]->access(circle1);
     parents[1]->access(circle2);
 
     // Mathematical Formula
-    double dist = sqrt((circle1[0] - circle2[0]) * (circle1[0] - circle2[0]) + (circle1[1] - circle2[1]) * (circle1[1] - circle2[1]));
-
-    if(dist < abs(circle1[2] - circle2[2]) - EPSILON || dist > abs(circle1[2] - circle2[2]) + EPSILON) {
-        well_defined = false;
-
-    } else {
-
-        if(circle1[2] < circle2[2]) {
-            for(int i = 0; i < 3; i++)
-                std::swap(circle1[i], circle2[i]);
-        }
-
-        double result_x = circle1[0], result_y = circle1[0];
-        double R = circle1[2], r = circle2[2];
-        double normalize_factor = dist;
-
-        double shift_horizontal = (R * R - r * r) / dist;
-        shift_horizontal = (dist + shift_horizontal) / 2;
-        result_x = result_x + (circle2[0] - circle1[0]) * shift_horizontal / normalize_factor;
-        result_y = result_y + (circle2[1] - circle1[1]) * shift_horizontal / normalize_factor;
-
-        double shift_vertical = sqrt(R * R - shift_horizontal * shift_horizontal);
-        result_x = result_x + (circle2[1] - circle1[1]) * shift_vertical / normalize_factor;
-        result_y = result_y - (circle2[0] - circle1[0]) * shift_vertical / normalize_factor;
-
-        x = result_x;
-        y = result_y;
-
-        well_defined = true;
-    }
+    SolverNode::circle_circle<T>(circle1, circle2, roots, defined);
+    solution(roots, defined, 0);
 }
 
+template <class T>
 void PointNode::circle_circle_second_intersection() {
 
     // Data Access
-    double circle1[3], circle2[3];
+    double circle1[3], circle2[3], roots[6];
+    bool defined[2];
     parents[0]->access(circle1);
     parents[1]->access(circle2);
 
     // Mathematical Formula
-    double dist = sqrt((circle1[0] - circle2[0]) * (circle1[0] - circle2[0]) + (circle1[1] - circle2[1]) * (circle1[1] - circle2[1]));
+    SolverNode::circle_circle<T>(circle1, circle2, roots, defined);
+    solution(roots, defined, 1);
+}
 
-    if(dist < abs(circle1[2] - circle2[2]) - EPSILON || dist > abs(circle1[2] - circle2[2]) + EPSILON) {
-        well_defined = false;
+void PointNode::first_solution() {
 
-    } else {
+    // Data Access: both roots were solved once by the parent
+    double data[DATA_SIZE];
+    parents[0]->access(data);
 
-        if(circle1[2] < circle2[2]) {
-            for(int i = 0; i < 3; i++)
-                std::swap(circle1[i], circle2[i]);
-        }
+    bool defined[2] = {data[SolverNode::DEFINED] != 0, data[SolverNode::DEFINED + 1] != 0};
+    solution(data, defined, 0);
+}
 
-        double result_x = circle1[0], result_y = circle1[0];
-        double R = circle1[2], r = circle2[2];
-        double normalize_factor = dist;
+void PointNode::second_solution() {
 
-        double shift_horizontal = (R * R - r * r) / dist;
-        shift_horizontal = (dist + shift_horizontal) / 2;
-        result_x = result_x + (circle2[0] - circle1[0]) * shift_horizontal / normalize_factor;
-        result_y = result_y + (circle2[1] - circle1[1]) * shift_horizontal / normalize_factor;
+    // Data Access: both roots were solved once by the parent
+    double data[DATA_SIZE];
+    parents[0]->access(data);
 
-        double shift_vertical = -sqrt(R * R - shift_horizontal * shift_horizontal);
-        result_x = result_x + (circle2[1] - circle1[1]) * shift_vertical / normalize_factor;
-        result_y = result_y - (circle2[0] - circle1[0]) * shift_vertical / normalize_factor;
+    bool defined[2] = {data[SolverNode::DEFINED] != 0, data[SolverNode::DEFINED + 1] != 0};
+    solution(data, defined, 1);
+}
 
-        x = result_x;
-        y = result_y;
+void PointNode::solution(const double roots[], const bool defined[2], int root) {
+    if(defined[root]) {
+        x = roots[3 * root];
+        y = roots[3 * root + 1];
 
         well_defined = true;
 
-    }
+    } else { well_defined = false; }
 }
 
 void PointNode::labels(vector<string>* point_labels, vector<string>*, vector<string>*, vector<string>*) const {
     point_labels->push_back(this->get_label());
 }
+
+bool PointNode::structure(vector<unsigned int>* key) const {
+    bool symmetric = (type == PointType::POINT_POINT_MIDPOINT || type == PointType::LINE_LINE_INTERSECTION);
+    make_structure(static_cast<unsigned int>(GeoKind::POINT), static_cast<unsigned int>(type), symmetric, key);
+
+    // Independent points and points on a line or circle are free, they can be moved apart
+    return !(type == PointType::INDEPENDENT || type == PointType::ON_LINE || type == PointType::ON_CIRCLE);
+}
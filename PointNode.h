@@ -1,5 +1,8 @@
 /***************************************************************************
 This class, PointNode, defines a Point. It is derived from GeoNode.
+In homogeneous coordinates, the point is kept as (x, y, w) with w >= 0 and
+divided only on access: the intersection of parallel lines is a point at
+infinity (w = 0), from which lines can still be drawn.
 ****************************************************************************/
 
 #ifndef POINTNODE_H_
@@ -16,46 +19,68 @@ enum class PointType {
     LINE_CIRCLE_FIRST_INTERSECTION, //!< First intersection of a given line with a given circle.
     LINE_CIRCLE_SECOND_INTERSECTION, //!< Second intersection of a given line with a given circle.
     CIRCLE_CIRCLE_FIRST_INTERSECTION, //!< First intersection of the two given circles.
-    CIRCLE_CIRCLE_SECOND_INTERSECTION //!< Second intersection of the two given circles.
+    CIRCLE_CIRCLE_SECOND_INTERSECTION, //!< Second intersection of the two given circles.
+    FIRST_SOLUTION, //!< First root of a given solver (intersections, see SolverNode).
+    SECOND_SOLUTION //!< Second root of a given solver (intersections, see SolverNode).
 };
 
 class PointNode: public GeoNode {
 
 public:
     PointNode(PointType type, double x, double y); /**< @brief Constructor of an independent point. */
-    PointNode(PointType type, GeoNode* geo1, double x, double y); /**< @brief Constructor of a point with a single parent. */
+    PointNode(PointType type, GeoNode* geo1, double x, double y); /**< @brief Constructor of a point with a single parent (the coordinates are ignored by solutions). */
     PointNode(PointType type, GeoNode* geo1, GeoNode* geo2); /**< @brief Constructor of a point with two parents. */
 
+    virtual bool is_point() const override; /**< @brief Returns true. */
+    virtual void access_homogeneous(double data[]) const override; /**< @brief Sets the array data as {x, y, w}. */
+    virtual bool is_finite() const override; /**< @brief Returns whether the point is not at infinity, w not being negligible next to x and y. */
     virtual ~PointNode() override; /**< @brief Removes the associated figure (*point). */
 
 private:
     //@{
-    /** @brief Data members: x coordinate, y coordinate. */
-    double x{0}, y{0};
+    /** @brief Data members: x coordinate, y coordinate, weight (always 1 in Cartesian coordinates). */
+    double x{0}, y{0}, w{1};
     //@}
     QCPGraph *point {nullptr}; //!< Corresponding figure that represents the point on the plot.
     /** @brief Function pointer indicating the definition of the point. */
     void (PointNode::*definition)() {nullptr};
+    PointType type; //!< Type of the point, identifies its definition.
 
     virtual void print() const override; /**< @brief Prints all data components of the point (Debugging purposes only). */
-    virtual void display(Ui::MainWindow* ui) override; /**< @brief Updates the corresponding figure on the plot (*point). */
+    virtual void display(Ui::MainWindow* ui, FigurePool* pool, const double data[], bool defined) override; /**< @brief Updates the corresponding figure on the plot (*point) from the given data, taking it from the pool on first need. */
+    virtual void release(FigurePool* pool) override; /**< @brief Gives the corresponding figure (*point) back to the pool. */
+    virtual bool in_view(const double data[], const double view[4]) const override; /**< @brief Returns whether the point lies in the view rectangle. */
+    virtual void bounds(const double data[], double box[4]) const override; /**< @brief Sets box to the point itself. */
     /** @brief Takes a collection of string vectors and adds the label of the point to the point_labels vector. */
     virtual void labels(vector<string>* point_labels, vector<string>*, vector<string>*, vector<string>*) const override;
+    virtual bool structure(vector<unsigned int>* key) const override; /**< @brief Sets key to {kind, type, parent pids}, returns false if the point is free. */
 
-    virtual void access(double data[]) const override; /**< @brief Sets the array data as {x coordinate, y coordinate}. */
+    /** @brief Sets the array data as {x coordinate, y coordinate}, dividing by the weight. Points at infinity give infinite coordinates along their direction. */
+    virtual void access(double data[]) const override;
     virtual void mutate(double data[]) override; /**< @brief Edits the point based on data = {new x coordinate, new y coordinate}. */
 
     virtual void update() override; /**< @brief Updates the construction to adjust for changes of the parents. */
 
+    /** @brief Sets the definition of the type, computed in the scalar type T. */
+    template <class T> void identify();
+    virtual void set_precision(Precision precision) override; /**< @brief Sets the definition of the type again, computed in the given precision. */
+
+    //@{
+    /** @brief Definitions computed in the scalar type T (see GeoScalar.h), the data being kept in double. */
     void independent(); /**< @brief Defines a point given by Cartesian coordinates. */
-    void on_line(); /**< @brief Defines a point on a given line, taking the projection of the given Cartesian coordinates. */
-    void on_circle(); /**< @brief Defines a point on a given circle, taking the projection of the given Cartesian coordinates. */
-    void point_point_midpoint(); /**< @brief Defines a point as the midpoint of two given points. */
-    void line_line_intersection(); /**< @brief Defines a point given by the intersection of two lines. */
-    void line_circle_first_intersection(); /**< @brief Defines a point given by the first intersection of a lines and a circle. */
-    void line_circle_second_intersection(); /**< @brief Defines a point given by the second intersection of a lines and a circle. */
-    void circle_circle_first_intersection(); /**< @brief Defines a point given by the first intersection of two circles. */
-    void circle_circle_second_intersection(); /**< @brief Defines a point given by the seconds intersection of two circles. */
+    template <class T> void on_line(); /**< @brief Defines a point on a given line, taking the projection of the given Cartesian coordinates. */
+    template <class T> void on_circle(); /**< @brief Defines a point on a given circle, taking the projection of the given Cartesian coordinates. */
+    template <class T> void point_point_midpoint(); /**< @brief Defines a point as the midpoint of two given points. */
+    template <class T> void line_line_intersection(); /**< @brief Defines a point given by the intersection of two lines. */
+    template <class T> void line_circle_first_intersection(); /**< @brief Defines a point given by the first intersection of a lines and a circle. */
+    template <class T> void line_circle_second_intersection(); /**< @brief Defines a point given by the second intersection of a lines and a circle. */
+    template <class T> void circle_circle_first_intersection(); /**< @brief Defines a point given by the first intersection of two circles. */
+    template <class T> void circle_circle_second_intersection(); /**< @brief Defines a point given by the seconds intersection of two circles. */
+    //@}
+    void first_solution(); /**< @brief Defines a point as the first root of a solver. */
+    void second_solution(); /**< @brief Defines a point as the second root of a solver. */
+    /** @brief Takes the roots of a solve (see SolverNode) and sets the point to the one with the given index, if it exists. */
+    void solution(const double roots[], const bool defined[2], int root);
 
 };
 
@@ -0,0 +1,58 @@
+/*
+ * ProgressiveDisplay.cpp
+ *
+ */
+
+#include <QElapsedTimer>
+#include "ProgressiveDisplay.h"
+
+ProgressiveDisplay::ProgressiveDisplay(GeoComponents* geo_components): geo_components(geo_components) {}
+
+void ProgressiveDisplay::start(const GeoSnapshot& snapshot, const double view[4]) {
+    this->snapshot = snapshot;
+    geo_components->visibility_order(this->snapshot, view, &order);
+    cursor = 0;
+    active = true;
+}
+
+bool ProgressiveDisplay::step(Ui::MainWindow* ui, int budget_ms) {
+    if (!active)
+        return true;
+
+    // The figures belong to the current constructions, a snapshot of another topology is useless
+    if (snapshot.topology != geo_components->get_topology()) {
+        cancel();
+        return true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Check the clock every few constructions only
+    const unsigned int CHUNK = 64;
+    while (cursor < order.size()) {
+        unsigned int end = min(cursor + CHUNK, static_cast<unsigned int>(order.size()));
+        for (; cursor < end; ++cursor)
+            geo_components->display_construction(ui, order[cursor], snapshot);
+
+        if (timer.elapsed() >= budget_ms)
+            break;
+    }
+
+    active = (cursor < order.size());
+    return !active;
+}
+
+void ProgressiveDisplay::cancel() {
+    active = false;
+    order.clear();
+    cursor = 0;
+}
+
+bool ProgressiveDisplay::is_active() const {
+    return active;
+}
+
+unsigned int ProgressiveDisplay::get_remaining() const {
+    return active ? order.size() - cursor : 0;
+}
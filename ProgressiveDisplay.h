@@ -0,0 +1,38 @@
+/***************************************************************************
+This class, ProgressiveDisplay, creates and updates the figures of a large
+scene in bounded time slices, so that the event loop keeps running between
+slices. It works like a resumable iterator over a snapshot: start fixes the
+data and the order (constructions in view first), and every step displays
+as many constructions as fit in the given time budget. Starting again or
+cancelling abandons the pass in progress.
+****************************************************************************/
+
+#ifndef PROGRESSIVEDISPLAY_H_
+#define PROGRESSIVEDISPLAY_H_
+
+#include <vector>
+#include "GeoComponents.h"
+
+class ProgressiveDisplay {
+
+public:
+    ProgressiveDisplay(GeoComponents* geo_components); /**< @brief Constructor, takes the (not owned) GeoComponents object to display. */
+
+    /** @brief Takes a snapshot and a view rectangle {x_min, x_max, y_min, y_max}, and starts a new pass (cancelling the current one). */
+    void start(const GeoSnapshot& snapshot, const double view[4]);
+    /** @brief Displays constructions for at most budget_ms milliseconds, returns true if the pass is complete (or was invalidated). */
+    bool step(Ui::MainWindow* ui, int budget_ms);
+    void cancel(); /**< @brief Abandons the pass in progress. */
+
+    bool is_active() const; /**< @brief Returns whether a pass is in progress. */
+    unsigned int get_remaining() const; /**< @brief Returns the number of constructions not displayed yet in the current pass. */
+
+private:
+    GeoComponents* geo_components {nullptr}; /**< @brief Constructions displayed (not owned). */
+    GeoSnapshot snapshot; /**< @brief Data displayed by the current pass. */
+    vector<unsigned int> order; /**< @brief Pids in display order, those in view first. */
+    unsigned int cursor {0}; /**< @brief Position in order of the next construction to display. */
+    bool active {false}; /**< @brief Indicates whether a pass is in progress. */
+};
+
+#endif /* PROGRESSIVEDISPLAY_H_ */
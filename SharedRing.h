@@ -0,0 +1,208 @@
+/***************************************************************************
+This class, SharedRing, is a lock-free single-producer/single-consumer ring
+buffer of fixed-size records living in shared memory (QSharedMemory), so
+that another process can exchange data with the engine without going
+through GUI events. One side creates the ring, the other attaches to it by
+key. Like SpscQueue, neither side ever waits: push fails when the ring is
+full, in which case the producer either drops the record (counted) or
+drops the oldest record still in the ring to make room.
+
+It carries SharedRecord (new coordinates of a point, the input of the
+engine) and GeoDelta (recomputed values, the output of the ChangeStream).
+Records carry the time they were produced (steady clock, nanoseconds), so
+that the consumer can measure the end-to-end latency.
+****************************************************************************/
+
+#ifndef SHAREDRING_H_
+#define SHAREDRING_H_
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <QSharedMemory>
+#include <QString>
+
+/** @brief A record of the input ring: the new coordinates of the construction with the given handle (pid). */
+struct SharedRecord {
+    quint32 handle {0}; //!< Pid of the construction.
+    quint32 reserved {0}; //!< Padding, keeps the layout identical across compilers.
+    double x {0}, y {0}; //!< New coordinates.
+    qint64 stamp {0}; //!< Time the record was produced (steady clock, nanoseconds).
+};
+
+template <typename T>
+class SharedRing {
+
+public:
+    static const quint32 MAGIC = 0x47454F52; /**< @brief Marks an initialized ring ("GEOR"). */
+
+    SharedRing(const QString& key); /**< @brief Constructor, takes the key of the shared memory segment. */
+
+    /** @brief Creates the segment with room for capacity records (rounded up to a power of two), returns false if it cannot. */
+    bool create(unsigned int capacity = 4096);
+    /** @brief Attaches to the segment created by the other side, returns false if there is none (yet). */
+    bool attach();
+
+    /** @brief Producer side: appends a record, returns false (and counts it as dropped) if the ring is full. */
+    bool push(const T& record);
+    /** @brief Producer side: appends a record, dropping (and counting) the oldest one if the ring is full. */
+    void push_over(const T& record);
+    bool full() const; /**< @brief Producer side: returns whether the next push would fail. */
+    /** @brief Consumer side: moves up to max of the oldest records into records, returns the number taken. */
+    unsigned int pop(T records[], unsigned int max);
+
+    quint64 get_pushed() const; /**< @brief Returns the number of records pushed so far. */
+    quint64 get_dropped() const; /**< @brief Returns the number of records dropped so far because the ring was full. */
+    QString get_error() const; /**< @brief Returns the description of the last shared memory error. */
+
+    static qint64 now(); /**< @brief Returns the current time of the clock used for the stamps. */
+
+private:
+    /** @brief Layout of the beginning of the segment, followed by the records. */
+    struct Header {
+        quint32 magic;
+        quint32 capacity;
+        quint32 record_size; //!< Size of a record, checked on attach.
+        alignas(64) std::atomic<quint64> head; //!< Number of records popped or dropped by push_over so far.
+        alignas(64) std::atomic<quint64> tail; //!< Number of records pushed so far (written by the producer only).
+        alignas(64) std::atomic<quint64> dropped; //!< Number of records dropped (written by the producer only).
+    };
+
+    void count_drop(); /**< @brief Producer side: counts a dropped record. */
+
+    QSharedMemory memory; /**< @brief The shared memory segment. */
+    Header* header {nullptr}; /**< @brief Header of the segment, nullptr until created or attached. */
+    T* records {nullptr}; /**< @brief Storage of the ring, right after the header. */
+    quint64 mask {0}; /**< @brief Capacity minus one, used to wrap the counters into the ring. */
+};
+
+template <typename T>
+SharedRing<T>::SharedRing(const QString& key): memory(key) {}
+
+template <typename T>
+bool SharedRing<T>::create(unsigned int capacity) {
+    quint32 size = 2;
+    while (size < capacity)
+        size <<= 1;
+
+    // A segment left over by a crashed process is reused
+    if (!memory.create(sizeof(Header) + size * sizeof(T))) {
+        if (memory.error() != QSharedMemory::AlreadyExists || !memory.attach())
+            return false;
+        if (static_cast<unsigned int>(memory.size()) < sizeof(Header) + size * sizeof(T))
+            return false;
+    }
+
+    header = new (memory.data()) Header;
+    header->magic = 0;
+    header->capacity = size;
+    header->record_size = sizeof(T);
+    header->head.store(0);
+    header->tail.store(0);
+    header->dropped.store(0);
+    records = reinterpret_cast<T*>(header + 1);
+    mask = size - 1;
+
+    // Published last, the other side checks it before using the ring
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = MAGIC;
+    return true;
+}
+
+template <typename T>
+bool SharedRing<T>::attach() {
+    if (header != nullptr)
+        return true;
+    if (!memory.isAttached() && !memory.attach())
+        return false;
+
+    Header* attached = static_cast<Header*>(memory.data());
+    if (attached->magic != MAGIC || attached->record_size != sizeof(T)) {
+        memory.detach();
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    header = attached;
+    records = reinterpret_cast<T*>(header + 1);
+    mask = header->capacity - 1;
+    return true;
+}
+
+template <typename T>
+bool SharedRing<T>::push(const T& record) {
+    quint64 tail = header->tail.load(std::memory_order_relaxed);
+    if (tail - header->head.load(std::memory_order_acquire) > mask) {
+        count_drop();
+        return false;
+    }
+
+    records[tail & mask] = record;
+    header->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+void SharedRing<T>::push_over(const T& record) {
+    quint64 tail = header->tail.load(std::memory_order_relaxed);
+    quint64 head = header->head.load(std::memory_order_acquire);
+
+    // Full: the oldest record is taken away from the consumer, unless it just made room itself
+    while (tail - head > mask) {
+        if (header->head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel)) {
+            count_drop();
+            break;
+        }
+    }
+
+    records[tail & mask] = record;
+    header->tail.store(tail + 1, std::memory_order_release);
+}
+
+template <typename T>
+unsigned int SharedRing<T>::pop(T records[], unsigned int max) {
+    quint64 head = header->head.load(std::memory_order_acquire);
+
+    // The records are copied first, then claimed: if push_over moved the head meanwhile, they may be overwritten and are read again
+    while (true) {
+        quint64 available = header->tail.load(std::memory_order_acquire) - head;
+        unsigned int count = (available < max) ? static_cast<unsigned int>(available) : max;
+        for (unsigned int i = 0; i < count; ++i)
+            records[i] = this->records[(head + i) & mask];
+
+        if (count == 0 || header->head.compare_exchange_strong(head, head + count, std::memory_order_acq_rel))
+            return count;
+    }
+}
+
+template <typename T>
+bool SharedRing<T>::full() const {
+    return header->tail.load(std::memory_order_relaxed) - header->head.load(std::memory_order_acquire) > mask;
+}
+
+template <typename T>
+void SharedRing<T>::count_drop() {
+    header->dropped.store(header->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+template <typename T>
+quint64 SharedRing<T>::get_pushed() const {
+    return (header != nullptr) ? header->tail.load() : 0;
+}
+
+template <typename T>
+quint64 SharedRing<T>::get_dropped() const {
+    return (header != nullptr) ? header->dropped.load() : 0;
+}
+
+template <typename T>
+QString SharedRing<T>::get_error() const {
+    return memory.errorString();
+}
+
+template <typename T>
+qint64 SharedRing<T>::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif /* SHAREDRING_H_ */
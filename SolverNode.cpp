@@ -0,0 +1,237 @@
+/*
+ * SolverNode.cpp
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "SolverNode.h"
+#include "GeoDescriptor.h"
+#include "GeoPredicates.h"
+
+SolverNode::SolverNode(SolverType type, GeoNode* geo1, GeoNode* geo2) : GeoNode(2) {
+    this->type = type;
+
+    // Initialization of Data Members
+    parents = new const GeoNode*[num_parents];
+    parents[0] = geo1;
+    parents[1] = geo2;
+
+    update();
+}
+
+SolverNode::~SolverNode() {}
+
+bool SolverNode::is_solver() const {
+    return true;
+}
+
+void SolverNode::print() const {
+    cout << "----------------------------------------\n";
+    cout << "Solver of:";
+    for(int i = 0; i < num_parents;++i)
+        cout << " " << parents[i]->get_label();
+    cout << endl;
+    for(int k = 0; k < 2; ++k)
+        cout << "Root " << k << ": " << roots[3*k] << '\t' << roots[3*k+1] << '\t' << roots[3*k+2] << (defined[k] ? "" : " (undefined)") << endl;
+}
+
+void SolverNode::display(Ui::MainWindow*, FigurePool*, const double[], bool) {}
+
+void SolverNode::release(FigurePool*) {}
+
+bool SolverNode::in_view(const double[], const double[4]) const {
+    return false;
+}
+
+void SolverNode::bounds(const double[], double box[4]) const {
+    box[0] = box[2] = HUGE_VAL;
+    box[1] = box[3] = -HUGE_VAL;
+}
+
+void SolverNode::labels(vector<string>*, vector<string>*, vector<string>*, vector<string>*) const {}
+
+bool SolverNode::structure(vector<unsigned int>* key) const {
+    bool symmetric = false;
+    make_structure(static_cast<unsigned int>(GeoKind::SOLVER), static_cast<unsigned int>(type), symmetric, key);
+    return true;
+}
+
+void SolverNode::access(double data[]) const {
+    for (int i = 0; i < 6; ++i)
+        data[i] = roots[i];
+    data[DEFINED] = defined[0];
+    data[DEFINED + 1] = defined[1];
+}
+
+void SolverNode::mutate(double[]) {
+    update();
+}
+
+void SolverNode::update() {
+    // Points at infinity (homogeneous coordinates) have no Cartesian coordinates to build on
+    well_defined = true;
+    for (int i = 0; i < num_parents; ++i)
+        well_defined &= parents[i]->get_well_defined() && parents[i]->is_finite();
+    if (!well_defined) {
+        defined[0] = defined[1] = false;
+        return;
+    }
+
+    // Data Access
+    double data1[DATA_SIZE], data2[DATA_SIZE];
+    parents[0]->access(data1);
+    parents[1]->access(data2);
+
+    switch(precision) {
+    case Precision::SINGLE: solve<float>(data1, data2); break;
+    case Precision::DOUBLE: solve<double>(data1, data2); break;
+    case Precision::DOUBLE_DOUBLE: solve<DoubleDouble>(data1, data2); break;
+    }
+    well_defined = defined[0] || defined[1];
+}
+
+template <class T>
+void SolverNode::solve(const double data1[], const double data2[]) {
+    switch(type) {
+    case SolverType::LINE_CIRCLE_INTERSECTIONS: line_circle<T>(data1, data2, roots, defined); break;
+    case SolverType::CIRCLE_CIRCLE_INTERSECTIONS: circle_circle<T>(data1, data2, roots, defined); break;
+    case SolverType::POINT_CIRCLE_TANGENTS: point_circle_tangents<T>(data1, data2, roots, defined); break;
+    }
+}
+
+template <class T>
+void SolverNode::line_circle(const double line[3], const double circle[3], double roots[6], bool defined[2]) {
+
+    // Data Access
+    T a = line[0], b = line[1], c = line[2];
+    T center_x = circle[0], center_y = circle[1], radius = circle[2];
+
+    // Mathematical Formula (unit normal: t is the signed distance from the center to the line)
+    T t = a * center_x + b * center_y + c;
+    T project_x = center_x - a * t;
+    T project_y = center_y - b * t;
+
+    int position = GeoPredicates::line_circle(line, circle, GeoPredicates::tolerance<T>());
+    if(position < 0) {
+        defined[0] = defined[1] = false;
+        return;
+    }
+
+    // Shift along the direction (-b, a) of the line, the second root is dropped at tangency
+    T to_shift = (position > 0) ? sqrt(max(T(0), radius * radius - t * t)) : T(0);
+
+    roots[0] = static_cast<double>(project_x - to_shift * b);
+    roots[1] = static_cast<double>(project_y + to_shift * a);
+    roots[3] = static_cast<double>(project_x + to_shift * b);
+    roots[4] = static_cast<double>(project_y - to_shift * a);
+    roots[2] = roots[5] = 0;
+
+    defined[0] = true;
+    defined[1] = (position > 0);
+}
+
+template <class T>
+void SolverNode::circle_circle(const double circle1[3], const double circle2[3], double roots[6], bool defined[2]) {
+
+    double tolerance = GeoPredicates::tolerance<T>();
+    if(GeoPredicates::coincident(circle1, circle2, tolerance) || GeoPredicates::circle_circle_outer(circle1, circle2, tolerance) < 0
+            || GeoPredicates::circle_circle_inner(circle1, circle2, tolerance) < 0) {
+        defined[0] = defined[1] = false;
+        return;
+    }
+
+    // Data Access
+    T center_x = circle1[0], center_y = circle1[1], R = circle1[2], r = circle2[2];
+
+    // Mathematical Formula
+    T delta_x = T(circle2[0]) - center_x, delta_y = T(circle2[1]) - center_y;
+    T dist = sqrt(delta_x * delta_x + delta_y * delta_y);
+
+    // Foot of the common chord on the line of centers, then half of the chord on both sides
+    T shift_horizontal = (dist * dist + R * R - r * r) / (2 * dist);
+    T shift_vertical = sqrt(max(T(0), R * R - shift_horizontal * shift_horizontal));
+
+    T foot_x = center_x + delta_x * shift_horizontal / dist;
+    T foot_y = center_y + delta_y * shift_horizontal / dist;
+
+    roots[0] = static_cast<double>(foot_x + delta_y * shift_vertical / dist);
+    roots[1] = static_cast<double>(foot_y - delta_x * shift_vertical / dist);
+    roots[3] = static_cast<double>(foot_x - delta_y * shift_vertical / dist);
+    roots[4] = static_cast<double>(foot_y + delta_x * shift_vertical / dist);
+    roots[2] = roots[5] = 0;
+
+    defined[0] = defined[1] = true;
+}
+
+template <class T>
+void SolverNode::point_circle_tangents(const double point[2], const double circle[3], double roots[6], bool defined[2]) {
+
+    // Data Access
+    T point_x = point[0], point_y = point[1];
+
+    // Mathematical Formula
+    int position = GeoPredicates::point_circle(point, circle, GeoPredicates::tolerance<T>());
+    if(position == 0) {
+        // Point on the circle: a single tangent, perpendicular to the radius
+        T normal_x = point_x - T(circle[0]), normal_y = point_y - T(circle[1]);
+        roots[0] = static_cast<double>(normal_x);
+        roots[1] = static_cast<double>(normal_y);
+        roots[2] = static_cast<double>((-normal_x)*point_x + (-normal_y)*point_y);
+
+        defined[0] = true;
+        defined[1] = false;
+
+    } else if(position < 0) {
+        defined[0] = defined[1] = false;
+
+    } else {
+        //Let the lines be: (y-point_y)=k(x-point_x)
+        T sk_coeff, k_coeff, c;
+
+        //Define variables for simplicity
+        T delta_x, delta_y, radius;
+        delta_x = T(circle[0]) - point_x;
+        delta_y = point_y - T(circle[1]);
+        radius = circle[2];
+
+        //Compute the coefficients of the quadratic
+        sk_coeff = delta_x*delta_x - radius*radius;
+        k_coeff = 2*delta_x*delta_y;
+        c = delta_y*delta_y - radius*radius;
+
+        //Solve for both slopes at once
+        T k1, k2;
+        if(GeoPredicates::compare_squares(circle[0] - point[0], circle[2], GeoPredicates::tolerance<T>()) == 0) {
+            // Linear case: the first tangent is vertical
+            roots[0] = 1;
+            roots[1] = 0;
+            roots[2] = -point[0];
+            k2 = -c/k_coeff;
+
+        } else {
+            T root = sqrt(k_coeff*k_coeff - 4*sk_coeff*c);
+            k1 = (-k_coeff + root)/(2*sk_coeff);
+            k2 = (-k_coeff - root)/(2*sk_coeff);
+            roots[0] = static_cast<double>(k1);
+            roots[1] = -1;
+            roots[2] = static_cast<double>(-k1*point_x + point_y);
+        }
+        roots[3] = static_cast<double>(k2);
+        roots[4] = -1;
+        roots[5] = static_cast<double>(-k2*point_x + point_y);
+
+        defined[0] = defined[1] = true;
+    }
+}
+
+// Kernels in every precision, they are also called by the single-root types of PointNode and LineNode
+template void SolverNode::line_circle<float>(const double[3], const double[3], double[6], bool[2]);
+template void SolverNode::line_circle<double>(const double[3], const double[3], double[6], bool[2]);
+template void SolverNode::line_circle<DoubleDouble>(const double[3], const double[3], double[6], bool[2]);
+template void SolverNode::circle_circle<float>(const double[3], const double[3], double[6], bool[2]);
+template void SolverNode::circle_circle<double>(const double[3], const double[3], double[6], bool[2]);
+template void SolverNode::circle_circle<DoubleDouble>(const double[3], const double[3], double[6], bool[2]);
+template void SolverNode::point_circle_tangents<float>(const double[2], const double[3], double[6], bool[2]);
+template void SolverNode::point_circle_tangents<double>(const double[2], const double[3], double[6], bool[2]);
+template void SolverNode::point_circle_tangents<DoubleDouble>(const double[2], const double[3], double[6], bool[2]);
@@ -0,0 +1,65 @@
+/***************************************************************************
+This class, SolverNode, solves once for both roots of a construction that
+has two solutions (the intersections of a line and a circle or of two
+circles, the tangents from a point to a circle). It is derived from GeoNode
+and has no figure: the roots are exposed to the plot by selector nodes,
+PointNode or LineNode of type FIRST_SOLUTION and SECOND_SOLUTION, which
+take the solver as their only parent. The solving kernels are also used by
+the single-root types (e.g. PointType::LINE_CIRCLE_FIRST_INTERSECTION).
+****************************************************************************/
+
+#ifndef SOLVERNODE_H_
+#define SOLVERNODE_H_
+
+#include "GeoNode.h"
+/** @brief Types of Solvers */
+enum class SolverType {
+    LINE_CIRCLE_INTERSECTIONS, //!< Both intersections of a given line with a given circle.
+    CIRCLE_CIRCLE_INTERSECTIONS, //!< Both intersections of the two given circles.
+    POINT_CIRCLE_TANGENTS //!< Both tangents from the given point to the given circle.
+};
+
+class SolverNode: public GeoNode {
+
+public:
+    SolverNode(SolverType type, GeoNode* geo1, GeoNode* geo2); /**< @brief Constructor of a solver with two parents. */
+
+    virtual bool is_solver() const override; /**< @brief Returns true. */
+    virtual ~SolverNode() override; /**< @brief Destructor. */
+
+    //@{
+    /** @brief Kernels: take the data of the parents and set roots to the two solutions, 3 values each (x, y, unused for points, the coefficients for lines), and defined to whether each one exists.
+     *  Lines are taken in Hesse normal form (see LineNode), tangents are given unnormalized. The roots are computed in the scalar type T
+     *  (float, double or DoubleDouble, see GeoScalar.h), which of them exist is decided by GeoPredicates on the data itself. */
+    template <class T> static void line_circle(const double line[3], const double circle[3], double roots[6], bool defined[2]);
+    template <class T> static void circle_circle(const double circle1[3], const double circle2[3], double roots[6], bool defined[2]);
+    template <class T> static void point_circle_tangents(const double point[2], const double circle[3], double roots[6], bool defined[2]);
+    //@}
+
+    static const int DEFINED = 6; /**< @brief Index in the data (as returned by access) of the definedness of the first root, the second one follows. */
+
+private:
+    /** @brief Data members: the two roots and whether each one exists. */
+    double roots[6] {0, 0, 0, 0, 0, 0};
+    bool defined[2] {false, false};
+    SolverType type; //!< Type of the solver, identifies its kernel.
+
+    virtual void print() const override; /**< @brief Prints the roots (Debugging purposes only). */
+    virtual void display(Ui::MainWindow*, FigurePool*, const double[], bool) override; /**< @brief Does nothing, the roots are displayed by the selectors. */
+    virtual void release(FigurePool*) override; /**< @brief Does nothing. */
+    virtual bool in_view(const double[], const double[4]) const override; /**< @brief Returns false, the solver is never seen. */
+    virtual void bounds(const double[], double box[4]) const override; /**< @brief Sets box to the empty box. */
+    /** @brief Adds no label, the solver is not a construction of the user. */
+    virtual void labels(vector<string>*, vector<string>*, vector<string>*, vector<string>*) const override;
+    virtual bool structure(vector<unsigned int>* key) const override; /**< @brief Sets key to {kind, type, parent pids}. */
+
+    virtual void access(double data[]) const override; /**< @brief Sets the array data as {first root (3 values), second root (3 values), first defined, second defined}. */
+    virtual void mutate(double data[]) override; /**< @brief Solves again, the roots cannot be edited. */
+
+    virtual void update() override; /**< @brief Updates the roots to adjust for changes of the parents, in the precision of the solver. */
+    /** @brief Takes the data of the parents and solves with the kernel of the type in the scalar type T. */
+    template <class T> void solve(const double data1[], const double data2[]);
+
+};
+
+#endif /* SOLVERNODE_H_ */
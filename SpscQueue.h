@@ -0,0 +1,68 @@
+/***************************************************************************
+This class, SpscQueue, is a bounded lock-free queue connecting exactly one
+producer thread with exactly one consumer thread (a ring buffer indexed by
+two atomic counters). Neither side ever waits on the other: push fails
+when the queue is full and pop fails when it is empty.
+****************************************************************************/
+
+#ifndef SPSCQUEUE_H_
+#define SPSCQUEUE_H_
+
+#include <atomic>
+#include <vector>
+
+template <typename T>
+class SpscQueue {
+
+public:
+    /** @brief Constructor, the capacity is rounded up to a power of two. */
+    explicit SpscQueue(unsigned int capacity = 1024);
+
+    bool push(const T& item); /**< @brief Producer side: appends a copy of item, returns false if the queue is full. */
+    bool pop(T& item); /**< @brief Consumer side: moves the oldest item into item, returns false if the queue is empty. */
+    bool empty() const; /**< @brief Returns whether the queue holds no items (exact only from the consumer thread). */
+
+private:
+    std::vector<T> buffer; /**< @brief Storage of the ring buffer. */
+    unsigned int mask {0}; /**< @brief Capacity minus one, used to wrap the counters into the buffer. */
+    alignas(64) std::atomic<unsigned int> head {0}; /**< @brief Number of items popped so far (written by the consumer only). */
+    alignas(64) std::atomic<unsigned int> tail {0}; /**< @brief Number of items pushed so far (written by the producer only). */
+};
+
+template <typename T>
+SpscQueue<T>::SpscQueue(unsigned int capacity) {
+    unsigned int size = 2;
+    while (size < capacity)
+        size <<= 1;
+    buffer.resize(size);
+    mask = size - 1;
+}
+
+template <typename T>
+bool SpscQueue<T>::push(const T& item) {
+    unsigned int t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) > mask)
+        return false;
+
+    buffer[t & mask] = item;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+bool SpscQueue<T>::pop(T& item) {
+    unsigned int h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire))
+        return false;
+
+    item = buffer[h & mask];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+bool SpscQueue<T>::empty() const {
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+}
+
+#endif /* SPSCQUEUE_H_ */
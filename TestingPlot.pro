@@ -1,6 +1,6 @@
 QT       += core gui
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport network
 
 CONFIG += c++11
 
@@ -15,7 +15,14 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# The loops of GeoBatch over the configurations are marked for vectorization (omp simd),
+# and their square roots need not set errno.
+*-g++ {
+    QMAKE_CXXFLAGS += -fopenmp-simd -fno-math-errno
+}
+
 SOURCES += \
+    ChangeStream.cpp \
     CircleNode.cpp \
     Dialogs/AddLineDialogs/addlinefirsttangent.cpp \
     Dialogs/AddLineDialogs/addlineparallel.cpp \
@@ -35,10 +42,28 @@ SOURCES += \
     Dialogs/AddCircleDialogs/addcirclethroughpoints.cpp \
     Dialogs/EditDialogs/edit.cpp \
     Dialogs/RemoveDialogs/remove.cpp \
+    DeltaSinks.cpp \
+    FigurePool.cpp \
+    GeoBatch.cpp \
+    GeoBench.cpp \
+    GeoChecker.cpp \
     GeoComponents.cpp \
+    GeoDescriptor.cpp \
+    GeoDiscovery.cpp \
+    GeoEngine.cpp \
+    GeoIntersections.cpp \
+    GeoLoadTest.cpp \
     GeoNode.cpp \
+    GeoPredicates.cpp \
+    GeoScript.cpp \
+    GeoServer.cpp \
+    GeoSnapping.cpp \
+    GeoVersions.cpp \
     LineNode.cpp \
+    PointClusters.cpp \
     PointNode.cpp \
+    ProgressiveDisplay.cpp \
+    SolverNode.cpp \
     TriangleCentersNode.cpp \
     TriangleNode.cpp \
     main.cpp \
@@ -46,6 +71,7 @@ SOURCES += \
     qcustomplot.cpp
 
 HEADERS += \
+    ChangeStream.h \
     CircleNode.h \
     Dialogs/AddLineDialogs/addlinefirsttangent.h \
     Dialogs/AddLineDialogs/addlineparallel.h \
@@ -65,12 +91,35 @@ HEADERS += \
     Dialogs/AddCircleDialogs/addcirclethroughpoints.h \
     Dialogs/EditDialogs/edit.h \
     Dialogs/RemoveDialogs/remove.h \
+    DeltaSinks.h \
+    FigurePool.h \
+    GeoBatch.h \
+    GeoBench.h \
+    GeoChecker.h \
     GeoComponents.h \
+    GeoDescriptor.h \
+    GeoDiscovery.h \
+    GeoEngine.h \
+    GeoIntersections.h \
+    GeoLoadTest.h \
     GeoNode.h \
+    GeoPredicates.h \
+    GeoScalar.h \
+    GeoScript.h \
+    GeoServer.h \
+    GeoSnapping.h \
+    GeoSnapshot.h \
+    GeoVersions.h \
     LineNode.h \
+    PointClusters.h \
     PointNode.h \
+    ProgressiveDisplay.h \
+    SharedRing.h \
+    SolverNode.h \
+    SpscQueue.h \
     TriangleCentersNode.h \
     TriangleNode.h \
+    TripleBuffer.h \
     mainwindow.h \
     qcustomplot.h
 
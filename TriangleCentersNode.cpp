@@ -4,8 +4,12 @@
  */
 #include <cmath>
 #include "TriangleCentersNode.h"
+#include "GeoDescriptor.h"
+#include "FigurePool.h"
+#include "GeoPredicates.h"
 
 TriangleCentersNode::TriangleCentersNode(TriangleCentersType type, GeoNode* geo1): GeoNode(1) {
+    this->type = type;
 
     // Identification of definition from TriangleCentersType
     switch(type) {
@@ -25,6 +29,10 @@ TriangleCentersNode::TriangleCentersNode(TriangleCentersType type, GeoNode* geo1
     update();
 }
 
+bool TriangleCentersNode::is_point() const {
+    return true;
+}
+
 void TriangleCentersNode::print() const {
     cout << "----------------------------------------\n";
     cout << "Identifier: " << this->get_label() << endl;
@@ -35,22 +43,33 @@ void TriangleCentersNode::print() const {
     cout << endl;
 }
 
-void TriangleCentersNode::display(Ui::MainWindow *ui) {
-    if(center == nullptr){ //Initialization
-        center = ui->custom_plot->addGraph();
-        center->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, QPen(Qt::black, 1.5), QBrush(Qt::white), 9));
-        center->setPen(QPen(QColor(120, 120, 120), 2));
-        center->setLayer("front");
+void TriangleCentersNode::display(Ui::MainWindow *ui, FigurePool* pool, const double data[], bool defined) {
+    if(center == nullptr){ //Initialization, only once there is something to be seen
+        if(!defined)
+            return;
+        center = pool->acquire_point(ui->custom_plot);
         center->setName(QString::fromStdString(this->get_label()));
     }
 
-    center->setVisible(well_defined);
+    center->setVisible(defined);
     center->data()->clear();
+    center->addData(data[0], data[1]);
+}
 
-    double coor[2];
-    this->cartesian(coor);
+void TriangleCentersNode::release(FigurePool* pool) {
+    if(center != nullptr){
+        pool->release(center);
+        center = nullptr;
+    }
+}
 
-    center->addData(coor[0], coor[1]);
+bool TriangleCentersNode::in_view(const double data[], const double view[4]) const {
+    return data[0] >= view[0] && data[0] <= view[1] && data[1] >= view[2] && data[1] <= view[3];
+}
+
+void TriangleCentersNode::bounds(const double data[], double box[4]) const {
+    box[0] = box[1] = data[0];
+    box[2] = box[3] = data[1];
 }
 
 void TriangleCentersNode::access(double data[]) const {
@@ -124,7 +143,8 @@ void TriangleCentersNode::orthocenter() {
 
     for (int i = 0; i < 3; ++i) {
         barycoeff[i] = sum - 2*triangle[6+i]*triangle[6+i];
-        if (abs(barycoeff[i]) < EPSILON) {
+        // Right angle at vertex i, relative to the size of the triangle
+        if (abs(barycoeff[i]) <= GeoPredicates::TOLERANCE * sum) {
             barycoeff[0] = barycoeff[1] = barycoeff[2] = 0;
             barycoeff[i] = 1;
         } else {
@@ -147,9 +167,9 @@ void TriangleCentersNode::ninepointcenter() {
     for(int i = 0; i < 3; ++i)
         triangle[6+i] *= triangle[6+i];
 
-    barycoeff_a = triangle[6] * (triangle[7] + triangle[8]) + (triangle[7] - triangle[8]) * (triangle[7] - triangle[8]);
-    barycoeff_b = triangle[7] * (triangle[8] + triangle[6]) + (triangle[8] - triangle[6]) * (triangle[8] - triangle[6]);
-    barycoeff_c = triangle[8] * (triangle[6] + triangle[7]) + (triangle[6] - triangle[7]) * (triangle[6] - triangle[7]);
+    barycoeff_a = triangle[6] * (triangle[7] + triangle[8]) - (triangle[7] - triangle[8]) * (triangle[7] - triangle[8]);
+    barycoeff_b = triangle[7] * (triangle[8] + triangle[6]) - (triangle[8] - triangle[6]) * (triangle[8] - triangle[6]);
+    barycoeff_c = triangle[8] * (triangle[6] + triangle[7]) - (triangle[6] - triangle[7]) * (triangle[6] - triangle[7]);
 }
 
 void TriangleCentersNode::symmedian() {
@@ -182,3 +202,9 @@ void TriangleCentersNode::cartesian(double coordinates []) const {
 void TriangleCentersNode::labels(vector<string>* point_labels, vector<string>*, vector<string>*, vector<string>*) const {
     point_labels->push_back(this->get_label());
 }
+
+bool TriangleCentersNode::structure(vector<unsigned int>* key) const {
+    bool symmetric = false;
+    make_structure(static_cast<unsigned int>(GeoKind::TRIANGLE_CENTER), static_cast<unsigned int>(type), symmetric, key);
+    return true;
+}
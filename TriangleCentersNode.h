@@ -21,6 +21,7 @@ class TriangleCentersNode: public GeoNode {
 
 public:
     TriangleCentersNode(TriangleCentersType type,GeoNode* geo1); /**< @brief Constructor of a triangle center with a single parent (The triangle). */
+    virtual bool is_point() const override; /**< @brief Returns true. */
     virtual ~TriangleCentersNode() override; /**< @brief Removes the associated figure (*center). */
 
 private:
@@ -31,15 +32,20 @@ private:
     QCPGraph *center {nullptr}; //!< Corresponding figure that represents a triangle center on the plot.
     /** @brief Function pointer indicating the definition of the point. */
     void (TriangleCentersNode::*definition)() {nullptr};
+    TriangleCentersType type; //!< Type of the triangle center, identifies its definition.
 
     virtual void print() const override; /**< @brief Prints all data components of the triangle center (Debugging purposes only). */
-    virtual void display(Ui::MainWindow *ui) override; /**< @brief Updates the corresponding figure on the plot (*center). */
+    virtual void display(Ui::MainWindow* ui, FigurePool* pool, const double data[], bool defined) override; /**< @brief Updates the corresponding figure on the plot (*center) from the given data, taking it from the pool on first need. */
+    virtual void release(FigurePool* pool) override; /**< @brief Gives the corresponding figure (*center) back to the pool. */
+    virtual bool in_view(const double data[], const double view[4]) const override; /**< @brief Returns whether the triangle center lies in the view rectangle. */
+    virtual void bounds(const double data[], double box[4]) const override; /**< @brief Sets box to the triangle center itself. */
     virtual void access(double data[]) const override; /**< @brief Sets the array data as {x coordinate, y coordinate} of the triangle center. */
     virtual void mutate(double data[]) override; /**< @brief Edits the triangle center based on data = {new bary_a, new bary_b, new bary_c}. */
 
     virtual void update() override; /**< @brief Updates the construction to adjust for changes of the parents. */
     /** @brief Takes a collection of string vectors and adds the label of the triangle center to the point_labels vector. */
     virtual void labels(vector<string>*point_labels, vector<string>*, vector<string>*, vector<string>*) const override;
+    virtual bool structure(vector<unsigned int>* key) const override; /**< @brief Sets key to {kind, type, parent pids}. */
 
     void cartesian(double data []) const; /**< @brief Performs conversion from barycentric coordinates to Cartesian coordinates. */
 
@@ -2,10 +2,15 @@
  * TriangleNode.cpp
  *
  */
+#include <algorithm>
 #include <cmath>
 #include "TriangleNode.h"
+#include "GeoDescriptor.h"
+#include "FigurePool.h"
+#include "GeoPredicates.h"
 
 TriangleNode::TriangleNode(TriangleType type, GeoNode* geo1, GeoNode* geo2, GeoNode* geo3): GeoNode(3) {
+    this->type = type;
 
     // Identification of definition from TriangleType
     switch(type) {
@@ -32,26 +37,40 @@ void TriangleNode::print() const {
     cout << endl;
 }
 
-void TriangleNode::display(Ui::MainWindow *ui) {
-    if(triangle == nullptr){
-        triangle = new QCPCurve(ui->custom_plot->xAxis, ui->custom_plot->yAxis);
-        triangle->setPen(Qt::NoPen);
-        triangle->setBrush(QColor(10, 100, 50, 160));
-        triangle->setLayer("main");
+void TriangleNode::display(Ui::MainWindow *ui, FigurePool* pool, const double data[], bool defined) {
+    if(triangle == nullptr){ //Initialization, only once there is something to be seen
+        if(!defined)
+            return;
+        triangle = pool->acquire_triangle(ui->custom_plot);
         triangle->setName(QString::fromStdString(this->get_label()));
     }
 
-    triangle->setVisible(well_defined);
-    double p1[2], p2[2], p3[2];
-    parents[0]->access(p1);
-    parents[1]->access(p2);
-    parents[2]->access(p3);
-
+    triangle->setVisible(defined);
     triangle->data()->clear();
-    triangle->addData(p1[0],p1[1]);
-    triangle->addData(p2[0],p2[1]);
-    triangle->addData(p3[0],p3[1]);
-    triangle->addData(p1[0],p1[1]);
+    triangle->addData(data[0],data[1]);
+    triangle->addData(data[2],data[3]);
+    triangle->addData(data[4],data[5]);
+    triangle->addData(data[0],data[1]);
+}
+
+void TriangleNode::release(FigurePool* pool) {
+    if(triangle != nullptr){
+        pool->release(triangle);
+        triangle = nullptr;
+    }
+}
+
+bool TriangleNode::in_view(const double data[], const double view[4]) const {
+    double box[4];
+    bounds(data, box);
+    return box[1] >= view[0] && box[0] <= view[1] && box[3] >= view[2] && box[2] <= view[3];
+}
+
+void TriangleNode::bounds(const double data[], double box[4]) const {
+    box[0] = min(data[0], min(data[2], data[4]));
+    box[1] = max(data[0], max(data[2], data[4]));
+    box[2] = min(data[1], min(data[3], data[5]));
+    box[3] = max(data[1], max(data[3], data[5]));
 }
 
 void TriangleNode::access(double data[]) const {
@@ -78,9 +97,10 @@ void TriangleNode::mutate(double data[]) {
 }
 
 void TriangleNode::update() {
+    // Points at infinity (homogeneous coordinates) have no Cartesian coordinates to build on
     well_defined = true;
     for (int i = 0; i < num_parents; ++i)
-        well_defined &= parents[i]->get_well_defined();
+        well_defined &= parents[i]->get_well_defined() && parents[i]->is_finite();
     if (well_defined)
         (this->*definition)();
 }
@@ -103,9 +123,17 @@ void TriangleNode::point_point_point_vertices() {
     side_b = sqrt((point3[0] - point1[0]) * (point3[0] - point1[0]) + (point3[1] - point1[1]) * (point3[1] - point1[1]));
     side_c = sqrt((point1[0] - point2[0]) * (point1[0] - point2[0]) + (point1[1] - point2[1]) * (point1[1] - point2[1]));
 
-    well_defined = (side_a > EPSILON && side_b > EPSILON && side_c > EPSILON);
+    well_defined = !GeoPredicates::coincident(point2, point3) && !GeoPredicates::coincident(point3, point1)
+            && !GeoPredicates::coincident(point1, point2);
 }
 
 void TriangleNode::labels(vector<string> *, vector<string> *, vector<string> *, vector<string> *triangle_labels) const {
     triangle_labels->push_back(this->get_label());
 }
+
+bool TriangleNode::structure(vector<unsigned int>* key) const {
+    // The order of the vertices is kept, the figure and the centers depend on it
+    bool symmetric = false;
+    make_structure(static_cast<unsigned int>(GeoKind::TRIANGLE), static_cast<unsigned int>(type), symmetric, key);
+    return true;
+}
@@ -25,14 +25,19 @@ private:
     QCPCurve *triangle {nullptr}; //!< Corresponding figure that represents the triangle on the plot.
     /** @brief Function pointer indicating the definition of the triangle. */
     void (TriangleNode::*definition)() {nullptr};
+    TriangleType type; //!< Type of the triangle, identifies its definition.
 
     virtual void print() const override; /**< @brief Prints all data components of the triangle (Debugging purposes only). */
-    virtual void display(Ui::MainWindow *ui) override; /**< @brief Updates the corresponding figure on the plot (*triangle). */
+    virtual void display(Ui::MainWindow* ui, FigurePool* pool, const double data[], bool defined) override; /**< @brief Updates the corresponding figure on the plot (*triangle) from the given data, taking it from the pool on first need. */
+    virtual void release(FigurePool* pool) override; /**< @brief Gives the corresponding figure (*triangle) back to the pool. */
+    virtual bool in_view(const double data[], const double view[4]) const override; /**< @brief Returns whether the bounding box of the triangle meets the view rectangle. */
+    virtual void bounds(const double data[], double box[4]) const override; /**< @brief Sets box to the bounding box of the vertices. */
     virtual void access(double data[]) const override; /**< @brief Sets the array data as coordinates of the three ponts together with the lenght of the sides. */
     virtual void mutate(double data[]) override; /**< @brief Edits the triangle center based on data = {new side_a, new side_b, new side_c}. */
     virtual void update() override; /**< @brief Updates the construction to adjust for changes of the parents. */
     /** @brief Takes a collection of string vectors and adds the label of the triangle to the triangle_labels vector. */
     virtual void labels(vector<string>*, vector<string>*, vector<string>*, vector<string>*) const override;
+    virtual bool structure(vector<unsigned int>* key) const override; /**< @brief Sets key to {kind, type, parent pids}. */
 
     void point_point_point_vertices(); /**< @brief Defines a triangle given by the three vertices. */
 };
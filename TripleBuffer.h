@@ -0,0 +1,48 @@
+/***************************************************************************
+This class, TripleBuffer, hands the latest value produced by one writer
+thread to one reader thread without locks. The writer fills its private
+slot and publishes it; the reader swaps in the newest published slot.
+Values published while the reader was busy are overwritten, so the reader
+only ever sees the most recent one (stale frames are dropped, not queued).
+****************************************************************************/
+
+#ifndef TRIPLEBUFFER_H_
+#define TRIPLEBUFFER_H_
+
+#include <atomic>
+
+template <typename T>
+class TripleBuffer {
+
+public:
+    TripleBuffer() {} /**< @brief Constructor */
+
+    T& write_buffer() { return slots[write_index]; } /**< @brief Writer side: slot to be filled before publish. */
+    void publish(); /**< @brief Writer side: makes the filled slot the newest value and takes back a free slot. */
+    bool fetch(); /**< @brief Reader side: swaps in the newest value, returns false if nothing was published since the last fetch. */
+    const T& read_buffer() const { return slots[read_index]; } /**< @brief Reader side: slot obtained by the last successful fetch. */
+
+private:
+    static const unsigned int FRESH = 4; /**< @brief Flag on the middle index telling the reader that it holds an unread value. */
+
+    T slots[3]; /**< @brief The three slots: one owned by the writer, one by the reader and one in the middle. */
+    std::atomic<unsigned int> middle {2}; /**< @brief Index of the slot in the middle, together with the FRESH flag. */
+    unsigned int write_index {0}; /**< @brief Index of the writer's slot (writer thread only). */
+    unsigned int read_index {1}; /**< @brief Index of the reader's slot (reader thread only). */
+};
+
+template <typename T>
+void TripleBuffer<T>::publish() {
+    write_index = middle.exchange(write_index | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
+
+template <typename T>
+bool TripleBuffer<T>::fetch() {
+    if (!(middle.load(std::memory_order_relaxed) & FRESH))
+        return false;
+
+    read_index = middle.exchange(read_index, std::memory_order_acq_rel) & ~FRESH;
+    return true;
+}
+
+#endif /* TRIPLEBUFFER_H_ */
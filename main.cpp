@@ -5,11 +5,214 @@
 #include "CircleNode.h"
 #include "TriangleNode.h"
 #include "TriangleCentersNode.h"
+#include "GeoBench.h"
+#include "GeoChecker.h"
+#include "GeoDiscovery.h"
+#include "GeoLoadTest.h"
+#include "GeoPredicates.h"
+#include "GeoScript.h"
+#include "GeoServer.h"
+#include "SharedRing.h"
 
 #include <QApplication>
+#include <QCoreApplication>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Headless mode: runs each script file on its own scene and prints the output of its print commands
+int run_scripts(int argc, char *argv[])
+{
+    unsigned int failed = 0, commands = 0, passes = 0, merged = 0, frozen = 0;
+    unsigned long long saved = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 2; i < argc; ++i) {
+        GeoComponents geo;
+        GeoScript script(&geo);
+        if (!script.run_file(argv[i])) {
+            std::cerr << argv[i] << ": " << script.get_error() << std::endl;
+            ++failed;
+        }
+        std::cout << script.get_output();
+        commands += script.get_commands();
+        passes += script.get_passes();
+        merged += geo.get_merged();
+        saved += geo.get_saved_evaluations();
+        frozen += geo.get_frozen();
+    }
+
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << (argc - 2) << " scripts (" << failed << " failed), " << commands << " commands in " << passes
+              << " passes, " << elapsed << " ms, " << merged << " duplicates merged (" << saved << " evaluations saved), "
+              << frozen << " constructions frozen, " << GeoPredicates::get_evaluations() << " predicates ("
+              << GeoPredicates::get_escalations() << " escalated to exact arithmetic)" << std::endl;
+    return (failed == 0) ? 0 : 1;
+}
+
+// Server mode: serves scenes on a local socket until killed
+int serve(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    GeoServer server((argc > 3) ? static_cast<unsigned int>(std::atoi(argv[3])) : std::thread::hardware_concurrency());
+    if (!server.listen(argv[2])) {
+        std::cerr << server.get_error().toStdString() << std::endl;
+        return 1;
+    }
+    return a.exec();
+}
+
+// Load test of a server: seconds per rate, then the rates (requests per second)
+int load_test(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    double seconds = (argc > 3) ? std::atof(argv[3]) : 5;
+    std::vector<double> rates;
+    for (int i = 4; i < argc; ++i)
+        rates.push_back(std::atof(argv[i]));
+    if (rates.empty())
+        rates = {100, 1000, 5000, 20000};
+
+    GeoLoadTest test(argv[2]);
+    if (!test.run(rates, seconds, std::cout)) {
+        std::cerr << "cannot reach server '" << argv[2] << "'" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Benchmarks of the propagation passes: name (or all), then the size of the scenes and the number of passes
+int bench(int argc, char *argv[])
+{
+    unsigned int size = (argc > 3) ? static_cast<unsigned int>(std::atoi(argv[3])) : 10000;
+    unsigned int passes = (argc > 4) ? static_cast<unsigned int>(std::atoi(argv[4])) : 100;
+
+    GeoBench bench(size, passes);
+    if (!bench.run(argv[2], std::cout)) {
+        std::cerr << "unknown benchmark '" << argv[2] << "', one of: all";
+        std::vector<std::string> names = GeoBench::names();
+        for (auto it = names.begin(); it != names.end(); ++it)
+            std::cerr << ' ' << *it;
+        std::cerr << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Monte-Carlo check of the conjectures of a script: the script file, then the number of samples and of threads
+int check(int argc, char *argv[])
+{
+    unsigned long long samples = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 1000000;
+    unsigned int threads = (argc > 4) ? static_cast<unsigned int>(std::atoi(argv[4])) : std::thread::hardware_concurrency();
+
+    std::ifstream file(argv[2]);
+    if (!file) {
+        std::cerr << "cannot read '" << argv[2] << "'" << std::endl;
+        return 1;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+
+    GeoChecker checker(samples, threads);
+    if (!checker.run(text.str(), std::cout)) {
+        std::cerr << argv[2] << ": " << checker.get_error() << std::endl;
+        return 1;
+    }
+    for (auto it = checker.get_outcomes().begin(); it != checker.get_outcomes().end(); ++it) {
+        if (it->failed > 0)
+            return 2;
+    }
+    return 0;
+}
+
+// Discovery of the relations among the points of a script: the script file, then the number of samples and of threads,
+// printed as the check commands that declare them
+int discover(int argc, char *argv[])
+{
+    unsigned int samples = (argc > 3) ? static_cast<unsigned int>(std::atoi(argv[3])) : 64;
+    unsigned int threads = (argc > 4) ? static_cast<unsigned int>(std::atoi(argv[4])) : std::thread::hardware_concurrency();
+
+    std::ifstream file(argv[2]);
+    if (!file) {
+        std::cerr << "cannot read '" << argv[2] << "'" << std::endl;
+        return 1;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+
+    GeoComponents geo;
+    GeoScript script(&geo);
+    if (!script.run(text.str())) {
+        std::cerr << argv[2] << ": " << script.get_error() << std::endl;
+        return 1;
+    }
+    GeoDiscovery discovery(&geo, threads, samples);
+    if (!discovery.run()) {
+        std::cerr << argv[2] << ": " << discovery.get_error() << std::endl;
+        return 1;
+    }
+    for (auto it = discovery.get_relations().begin(); it != discovery.get_relations().end(); ++it)
+        std::cout << "check " << it->text() << std::endl;
+    std::cerr << discovery.get_relations().size() << " relations among " << discovery.get_points() << " points, "
+              << discovery.get_candidates() << " candidates, " << discovery.get_elapsed() << " s" << std::endl;
+    return 0;
+}
+
+// Producer stand-in for the shared memory input: moves a point on a circle at the given rate (records per second)
+int produce(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    unsigned int handle = (argc > 3) ? static_cast<unsigned int>(std::atoi(argv[3])) : 0;
+    double rate = (argc > 4) ? std::atof(argv[4]) : 1000, seconds = (argc > 5) ? std::atof(argv[5]) : 10;
+
+    SharedRing<SharedRecord> ring(argv[2]);
+    if (!ring.attach()) {
+        std::cerr << "cannot attach to input '" << argv[2] << "'" << std::endl;
+        return 1;
+    }
+
+    qint64 period = static_cast<qint64>(1e9 / rate), start = SharedRing<SharedRecord>::now(), next = start;
+    unsigned long count = static_cast<unsigned long>(rate * seconds);
+    for (unsigned long i = 0; i < count; ++i) {
+        SharedRecord record;
+        record.handle = handle;
+        record.x = 50 * std::cos(2e-3 * i);
+        record.y = 50 * std::sin(2e-3 * i);
+        record.stamp = SharedRing<SharedRecord>::now();
+        ring.push(record);
+
+        next += period;
+        qint64 wait = next - SharedRing<SharedRecord>::now();
+        if (wait > 0)
+            std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+    }
+
+    std::cerr << count << " records in " << (SharedRing<SharedRecord>::now() - start) / 1e9 << " s, "
+              << ring.get_dropped() << " dropped in total" << std::endl;
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
+    if (argc > 2 && std::strcmp(argv[1], "--produce") == 0)
+        return produce(argc, argv);
+    if (argc > 1 && std::strcmp(argv[1], "--script") == 0)
+        return run_scripts(argc, argv);
+    if (argc > 2 && std::strcmp(argv[1], "--serve") == 0)
+        return serve(argc, argv);
+    if (argc > 2 && std::strcmp(argv[1], "--load-test") == 0)
+        return load_test(argc, argv);
+    if (argc > 2 && std::strcmp(argv[1], "--bench") == 0)
+        return bench(argc, argv);
+    if (argc > 2 && std::strcmp(argv[1], "--check") == 0)
+        return check(argc, argv);
+    if (argc > 2 && std::strcmp(argv[1], "--discover") == 0)
+        return discover(argc, argv);
+
     GeoComponents* geo = new GeoComponents;
 
     // Demo 1: Circles and Tangents
@@ -62,6 +265,18 @@ int main(int argc, char *argv[])
     // Application Setup
     QApplication a(argc, argv);
     MainWindow w(geo);
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--input") == 0 && i + 1 < argc)
+            w.open_input(argv[++i]);
+        else if (std::strcmp(argv[i], "--pull") == 0)
+            w.set_evaluation(Evaluation::PULL);
+        else if (std::strcmp(argv[i], "--budget") == 0 && i + 1 < argc)
+            w.set_frame_budget(std::atof(argv[++i]));
+        else if (std::strcmp(argv[i], "--intersections") == 0)
+            w.set_intersections(true);
+        else if (std::strcmp(argv[i], "--no-snap") == 0)
+            w.set_snapping(false);
+    }
     w.show();
     return a.exec();
 }
@@ -1,6 +1,12 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
+#include <QDockWidget>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPlainTextEdit>
+#include <QVBoxLayout>
+
 #include "Dialogs/AddPointDialogs/addpointindependent.h"
 #include "Dialogs/AddPointDialogs/addpointon.h"
 #include "Dialogs/AddPointDialogs/addpointoncircle.h"
@@ -30,6 +36,49 @@ MainWindow::MainWindow(GeoComponents* geo_components, QWidget *parent)
     //Setup Ui
     ui->setupUi(this);
 
+    //Evaluation of edits on a worker thread, frames are presented from the event loop
+    engine = new GeoEngine(this->geo_components, [this]() { QMetaObject::invokeMethod(this, "present_frame", Qt::QueuedConnection); });
+
+    //Progressive display of large scenes, one time slice per event loop iteration
+    progressive = new ProgressiveDisplay(this->geo_components);
+    progressive_timer = new QTimer(this);
+    progressive_timer->setInterval(0);
+    connect(progressive_timer, SIGNAL(timeout()), this, SLOT(progressive_step()));
+
+    //Level of detail for dense point clusters, regrouped on pan and zoom
+    clusters = new PointClusters(this->geo_components);
+    connect(ui->custom_plot->xAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(view_changed()));
+    connect(ui->custom_plot->yAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(view_changed()));
+
+    //Intersections of the lines and circles in view, shown on demand and updated with the clusters
+    intersections = new GeoIntersections(this->geo_components);
+
+    //Magnetic snapping of dragged points, shift held drags freely
+    snapping = new GeoSnapping(this->geo_components);
+
+    //Console for the construction scripting language, docked at the bottom
+    script = new GeoScript(this->geo_components);
+    QDockWidget* console = new QDockWidget(tr("Console"), this);
+    QWidget* console_widget = new QWidget(console);
+    QVBoxLayout* console_layout = new QVBoxLayout(console_widget);
+    console_log = new QPlainTextEdit(console_widget);
+    console_log->setReadOnly(true);
+    console_input = new QLineEdit(console_widget);
+    console_input->setPlaceholderText("P = intersect L1 C2");
+    console_layout->addWidget(console_log);
+    console_layout->addWidget(console_input);
+    console->setWidget(console_widget);
+    addDockWidget(Qt::BottomDockWidgetArea, console);
+    connect(console_input, SIGNAL(returnPressed()), this, SLOT(run_command()));
+
+    //Report of the viewport culling
+    culled_label = new QLabel(this);
+    ui->statusbar->addPermanentWidget(culled_label);
+
+    //Report of the duplicates merged by hash-consing
+    merged_label = new QLabel(this);
+    ui->statusbar->addPermanentWidget(merged_label);
+
     //Connect on ClickGraph for displaying Info
     connect(ui->custom_plot, SIGNAL(plottableClick(QCPAbstractPlottable*,int,QMouseEvent*)), this, SLOT(graphClicked(QCPAbstractPlottable*)));
     connect(ui->custom_plot, SIGNAL(itemClick(QCPAbstractItem*, QMouseEvent*)), this, SLOT(itemClicked(QCPAbstractItem*)));
@@ -66,6 +115,13 @@ MainWindow::MainWindow(GeoComponents* geo_components, QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    delete engine;
+    delete input;
+    delete progressive;
+    delete clusters;
+    delete intersections;
+    delete snapping;
+    delete script;
     delete geo_components;
     delete ui;
 }
@@ -82,9 +138,6 @@ void MainWindow::make_plot(){
     ui->custom_plot->xAxis->grid()->setLayer("back");
     ui->custom_plot->yAxis->grid()->setLayer("back");
 
-    // Draw the constructions
-    geo_components->display_all_constructions(this->ui);
-
     // Set some pens, brushes and backgrounds
     ui->custom_plot->xAxis->setBasePen(QPen(Qt::white, 1));
     ui->custom_plot->yAxis->setBasePen(QPen(Qt::white, 1));
@@ -124,6 +177,85 @@ void MainWindow::make_plot(){
     ui->custom_plot->rescaleAxes();
     ui->custom_plot->yAxis->setRange(-default_range_y, default_range_y);
     ui->custom_plot->xAxis->setRange(-default_range_x, default_range_x);
+
+    // Draw the constructions
+    engine->wait_idle();
+    take_frame();
+    engine->sync();
+    show_frame();
+}
+
+void MainWindow::take_frame(){
+    geo_components->take_snapshot(&frame);
+    merged_label->setText(QString("Merged: %1 (%2 evaluations saved)").arg(geo_components->get_merged()).arg(geo_components->get_saved_evaluations()));
+}
+
+void MainWindow::show_frame(){
+    // Figures are displayed right after, so the pids whose visibility changed need no special care
+    std::vector<unsigned int> changed;
+    update_visibility(&changed);
+
+    double view[4];
+    current_view(view);
+
+    if(frame.size() < progressive_threshold){
+        progressive->cancel();
+        progressive_timer->stop();
+        if(geo_components->display_snapshot(ui, frame))
+            ui->custom_plot->replot();
+        return;
+    }
+
+    progressive->start(frame, view);
+    progressive_timer->start();
+}
+
+void MainWindow::current_view(double view[4]) const {
+    QCPRange x_range = ui->custom_plot->xAxis->range(), y_range = ui->custom_plot->yAxis->range();
+    view[0] = x_range.lower;
+    view[1] = x_range.upper;
+    view[2] = y_range.lower;
+    view[3] = y_range.upper;
+}
+
+double MainWindow::pixel_size() const {
+    int width = ui->custom_plot->axisRect()->width();
+    return (width > 0) ? ui->custom_plot->xAxis->range().size() / width : 0;
+}
+
+void MainWindow::update_visibility(std::vector<unsigned int>* changed){
+    double view[4];
+    current_view(view);
+
+    clusters->update(ui, frame, view, pixel_size(), changed);
+    if(intersections->update(frame, view))
+        intersections->draw(ui);
+
+    unsigned int culled = geo_components->cull(frame, view, changed);
+    culled_label->setText(QString("Culled: %1").arg(culled));
+}
+
+void MainWindow::view_changed(){
+    if(clusters == nullptr)
+        return;
+
+    // In pull mode, the engine evaluates the constructions coming into view and presents them with a new frame
+    double view[4];
+    current_view(view);
+    engine->set_view(view);
+
+    // Figures that just became visible were skipped while hidden, they are displayed with the current frame
+    std::vector<unsigned int> changed;
+    update_visibility(&changed);
+    for(auto it = changed.begin(); it != changed.end(); ++it)
+        geo_components->display_construction(ui, *it, frame);
+    ui->custom_plot->replot(QCustomPlot::rpQueuedReplot);
+}
+
+void MainWindow::progressive_step(){
+    if(progressive->step(ui, progressive_budget))
+        progressive_timer->stop();
+    ui->custom_plot->replot(QCustomPlot::rpQueuedReplot);
 }
 
 // Display Info of Point Clicked
@@ -169,9 +301,21 @@ void MainWindow::onMousePress(QMouseEvent* event){
         if(plottable){
             QCPGraph *graph = qobject_cast<QCPGraph*>(plottable);
             if(graph){
-                ui->custom_plot->setInteraction(QCP::iRangeDrag, false);
                 std::string label = graph->name().toStdString();
-                this->point_to_drag = geo_components->get_pid(label);
+                // Glyphs without a construction (clusters, intersections, snap highlight) are not dragged
+                unsigned int pid = geo_components->get_pid(label);
+                if (pid == static_cast<unsigned int>(-1))
+                    return;
+                // Fixed points, and the points computed from their parents, stay where they are
+                if (!geo_components->is_movable(pid)) {
+                    ui->statusbar->showMessage(QString("Point '%1' cannot be moved").arg(QString::fromStdString(label)), 3000);
+                    return;
+                }
+                ui->custom_plot->setInteraction(QCP::iRangeDrag, false);
+                this->point_to_drag = pid;
+                double view[4];
+                current_view(view);
+                snapping->start(frame, view, pixel_size(), pid);
                 QString message = QString("Dragging point '%1'").arg(QString::fromStdString(label));
                 ui->statusbar->showMessage(message);
            }
@@ -185,16 +329,33 @@ void MainWindow::onMouseMove(QMouseEvent* event){
         data[0] = this->ui->custom_plot->xAxis->pixelToCoord(event->pos().x());
         data[1] = this->ui->custom_plot->yAxis->pixelToCoord(event->pos().y());
 
-        geo_components->edit_construction(point_to_drag, data);
+        // The nearest target within the tolerance attracts the point, its highlight is redrawn on its own layer
+        GeoSnap snap;
+        bool snapped = !(event->modifiers() & Qt::ShiftModifier) && snapping->query(data[0], data[1], &snap);
+        if(snapped){
+            data[0] = snap.x;
+            data[1] = snap.y;
+        }
+        snapping->highlight(ui, snapped ? &snap : nullptr);
 
-        geo_components->display_all_constructions(ui);
-        ui->custom_plot->replot();
+        // A pass displaying older data is abandoned, the next frame restarts it
+        progressive->cancel();
+        engine->post_edit(point_to_drag, data);
+    }
+}
+
+void MainWindow::present_frame(){
+    if(engine->fetch()){
+        frame = engine->get_frame();
+        show_frame();
     }
 }
 
 void MainWindow::onMouseRelease(){
     if(point_to_drag != static_cast<unsigned int>(-1)){
         point_to_drag = static_cast<unsigned int>(-1);
+        snapping->stop();
+        snapping->highlight(ui, nullptr);
         ui->custom_plot->setInteraction(QCP::iRangeDrag, true);
         ui->statusbar->clearMessage();
     }
@@ -228,10 +389,12 @@ void MainWindow::add_point(int type, double x, double y, std::string label) {
         return;
     }
 
+    engine->wait_idle();
     geo_components->add_construction(new PointNode(static_cast<PointType>(type), x, y), label);
+    take_frame();
+    engine->sync();
 
-    geo_components->display_all_constructions(ui);
-    ui->custom_plot->replot();
+    show_frame();
 
     QString message = QString("Created point '%1'").arg(QString::fromStdString(label));
     ui->statusbar->showMessage(message,3000);
@@ -252,10 +415,12 @@ void MainWindow::add_point(int type, std::string geo, double x, double y, std::s
         return;
     }
 
+    engine->wait_idle();
     geo_components->add_construction(new PointNode(static_cast<PointType>(type), parent_1, x, y), label);
+    take_frame();
+    engine->sync();
 
-    geo_components->display_all_constructions(ui);
-    ui->custom_plot->replot();
+    show_frame();
 
     QString message = QString("Created point '%1'").arg(QString::fromStdString(label));
     ui->statusbar->showMessage(message,3000);
@@ -277,10 +442,13 @@ void MainWindow::add_point(int type, std::string geo1, std::string geo2, std::st
         return;
     }
 
-    geo_components->add_construction(new PointNode(static_cast<PointType>(type), parent_1, parent_2), label);
+    // Through a descriptor, so that intersections share their solve (see GeoComponents::add_constructions)
+    engine->wait_idle();
+    geo_components->add_constructions(std::vector<GeoDescriptor>(1, GeoDescriptor(GeoKind::POINT, type, label, {geo1, geo2})));
+    take_frame();
+    engine->sync();
 
-    geo_components->display_all_constructions(ui);
-    ui->custom_plot->replot();
+    show_frame();
 
     QString message = QString("Created point '%1'").arg(QString::fromStdString(label));
     ui->statusbar->showMessage(message,3000);
@@ -304,10 +472,13 @@ void MainWindow::add_line(int type, std::string geo1, std::string geo2, std::str
         return;
     }
 
-    geo_components->add_construction(new LineNode(static_cast<LineType>(type), parent_1, parent_2), label);
+    // Through a descriptor, so that tangents share their solve (see GeoComponents::add_constructions)
+    engine->wait_idle();
+    geo_components->add_constructions(std::vector<GeoDescriptor>(1, GeoDescriptor(GeoKind::LINE, type, label, {geo1, geo2})));
+    take_frame();
+    engine->sync();
 
-    geo_components->display_all_constructions(ui);
-    ui->custom_plot->replot();
+    show_frame();
 
     QString message = QString("Created line '%1'").arg(QString::fromStdString(label));
     ui->statusbar->showMessage(message,3000);
@@ -331,10 +502,12 @@ void MainWindow::add_circle(int type, std::string geo1, std::string geo2, std::s
         return;
     }
 
+    engine->wait_idle();
     geo_components->add_construction(new CircleNode(static_cast<CircleType>(type), parent_1, parent_2), label);
+    take_frame();
+    engine->sync();
 
-    geo_components->display_all_constructions(ui);
-    ui->custom_plot->replot();
+    show_frame();
 
     QString message = QString("Created circle '%1'").arg(QString::fromStdString(label));
     ui->statusbar->showMessage(message,3000);
@@ -357,10 +530,12 @@ void MainWindow::add_circle(int type, std::string geo1, std::string geo2, std::s
         return;
     }
 
+    engine->wait_idle();
     geo_components->add_construction(new CircleNode(static_cast<CircleType>(type), parent_1, parent_2, parent_3), label);
+    take_frame();
+    engine->sync();
 
-    geo_components->display_all_constructions(ui);
-    ui->custom_plot->replot();
+    show_frame();
 
     QString message = QString("Created circle '%1'").arg(QString::fromStdString(label));
     ui->statusbar->showMessage(message,3000);
@@ -384,10 +559,12 @@ void MainWindow::add_triangle(int type, std::string geo1, std::string geo2, std:
         return;
     }
 
+    engine->wait_idle();
     geo_components->add_construction(new TriangleNode(static_cast<TriangleType>(type), parent_1, parent_2, parent_3), label);
+    take_frame();
+    engine->sync();
 
-    geo_components->display_all_constructions(ui);
-    ui->custom_plot->replot();
+    show_frame();
 
     QString message = QString("Created triangle '%1'").arg(QString::fromStdString(label));
     ui->statusbar->showMessage(message,3000);
@@ -410,25 +587,151 @@ void MainWindow::add_triangle_center(int type, std::string geo, std::string labe
         return;
     }
 
+    engine->wait_idle();
     geo_components->add_construction(new TriangleCentersNode(static_cast<TriangleCentersType>(type), parent_1), label);
+    take_frame();
+    engine->sync();
 
-    geo_components->display_all_constructions(ui);
-    ui->custom_plot->replot();
+    show_frame();
 
     QString message = QString("Created triangle center '%1'").arg(QString::fromStdString(label));
     ui->statusbar->showMessage(message,3000);
 }
 
+// Batches
+
+unsigned int MainWindow::add_constructions(const std::vector<GeoDescriptor>& batch){
+    engine->wait_idle();
+    unsigned int added = geo_components->add_constructions(batch);
+    if (added > 0)
+        take_frame();
+    engine->sync();
+    if (added > 0)
+        show_frame();
+
+    QString message;
+    if (added == batch.size())
+        message = QString("Created %1 constructions").arg(added);
+    else if (added == 0)
+        message = QString("Invalid parameters.");
+    else
+        message = QString("Created %1 of %2 constructions, '%3' is not well-defined").arg(added).arg(batch.size()).arg(QString::fromStdString(batch[added].label));
+    ui->statusbar->showMessage(message,3000);
+
+    return added;
+}
+
+// Evaluation mode
+
+void MainWindow::set_evaluation(Evaluation evaluation){
+    engine->wait_idle();
+    geo_components->set_evaluation(evaluation);
+    take_frame();
+    engine->sync();
+
+    show_frame();
+
+    ui->statusbar->showMessage(evaluation == Evaluation::PULL ? "Pull evaluation: constructions out of view are evaluated on demand" : "Push evaluation", 3000);
+}
+
+void MainWindow::set_frame_budget(double budget_ms){
+    engine->set_budget(budget_ms);
+    if (budget_ms > 0)
+        set_evaluation(Evaluation::PULL);
+}
+
+// Intersections
+
+void MainWindow::set_intersections(bool enabled){
+    // Only the intersections change, they are found in the frame last presented (the worker may be evaluating the constructions)
+    intersections->set_enabled(enabled);
+    double view[4];
+    current_view(view);
+    if(intersections->update(frame, view)){
+        intersections->draw(ui);
+        ui->custom_plot->replot();
+    }
+
+    QString message = enabled ? QString("Intersections: %1 in view").arg(static_cast<int>(intersections->get_intersections().size())) : QString("Intersections hidden");
+    ui->statusbar->showMessage(message, 3000);
+}
+
+// Snapping
+
+void MainWindow::set_snapping(bool enabled){
+    snapping->set_enabled(enabled);
+    ui->statusbar->showMessage(enabled ? "Snapping: dragged points snap to points, intersections, lines and circles" : "Snapping disabled", 3000);
+}
+
+// Shared memory input
+
+bool MainWindow::open_input(const QString& key){
+    if (input != nullptr)
+        return false;
+
+    input = new SharedRing<SharedRecord>(key);
+    if (!input->create()) {
+        ui->statusbar->showMessage(QString("Cannot create input '%1': %2").arg(key).arg(input->get_error()), 3000);
+        delete input;
+        input = nullptr;
+        return false;
+    }
+    engine->set_input(input);
+
+    input_label = new QLabel(this);
+    ui->statusbar->addPermanentWidget(input_label);
+    input_timer = new QTimer(this);
+    input_timer->setInterval(1000);
+    connect(input_timer, SIGNAL(timeout()), this, SLOT(report_input()));
+    input_timer->start();
+    return true;
+}
+
+void MainWindow::report_input(){
+    GeoInputStats stats = engine->get_input_stats();
+    input_label->setText(QString("Input: %1/s, %2 dropped, %3 rejected, latency %4 ms (max %5)")
+                         .arg(stats.received).arg(stats.dropped).arg(stats.rejected)
+                         .arg(stats.latency_mean, 0, 'f', 2).arg(stats.latency_max, 0, 'f', 2));
+}
+
+// Console
+
+void MainWindow::run_command(){
+    QString command = console_input->text();
+    if (command.trimmed().isEmpty())
+        return;
+    console_input->clear();
+    console_log->appendPlainText("> " + command);
+
+    // Pasted scripts of several lines run as a single script, in batches
+    engine->wait_idle();
+    unsigned int passes = script->get_passes();
+    bool valid = script->run(command.toStdString());
+    bool changed = (script->get_passes() != passes);
+    if (changed)
+        take_frame();
+    engine->sync();
+    if (changed)
+        show_frame();
+
+    if (!script->get_output().empty())
+        console_log->appendPlainText(QString::fromStdString(script->get_output()).trimmed());
+    if (!valid)
+        console_log->appendPlainText(QString::fromStdString(script->get_error()));
+}
+
 // Edit
 
 void MainWindow::edit(std::string geo, double x, double y){
     unsigned int to_edit = geo_components->get_pid(geo);
     double data [2] = {x,y};
+    if(!geo_components->is_movable(to_edit)){
+        QString message = QString("Point '%1' cannot be moved").arg(QString::fromStdString(geo));
+        ui->statusbar->showMessage(message,3000);
+        return;
+    }
 
-    geo_components->edit_construction(to_edit, data);
-
-    geo_components->display_all_constructions(ui);
-    ui->custom_plot->replot();
+    engine->post_edit(to_edit, data);
 
     QString message = QString("Edited point '%1'").arg(QString::fromStdString(geo));
     ui->statusbar->showMessage(message,3000);
@@ -436,11 +739,14 @@ void MainWindow::edit(std::string geo, double x, double y){
 
 // Remove
 void MainWindow::remove(std::string geo){
+    engine->wait_idle();
     unsigned int to_remove = geo_components->get_pid(geo);
-    geo_components->remove_construction(to_remove);
+    if(!geo_components->remove_alias(geo))
+        geo_components->remove_construction(to_remove);
+    take_frame();
+    engine->sync();
 
-    geo_components->display_all_constructions(ui);
-    ui->custom_plot->replot();
+    show_frame();
 
     QString message = QString("Removed construction '%1'").arg(QString::fromStdString(geo));
     ui->statusbar->showMessage(message,3000);
@@ -5,6 +5,7 @@ The main possible interations are:
     - Selection of constructions via click. (Displays label on statusbar.)
     - Creation/Edition of constructions via actions of the menus.
     - Click and drag points that updates the plot in real-time.
+    - Commands of the construction scripting language typed in the console.
 ****************************************************************************/
 
 #ifndef MAINWINDOW_H
@@ -12,6 +13,12 @@ The main possible interations are:
 
 #include <QMainWindow>
 #include "GeoComponents.h"
+#include "GeoEngine.h"
+#include "GeoIntersections.h"
+#include "GeoScript.h"
+#include "GeoSnapping.h"
+#include "PointClusters.h"
+#include "ProgressiveDisplay.h"
 #include "PointNode.h"
 #include "LineNode.h"
 #include "CircleNode.h"
@@ -20,6 +27,8 @@ The main possible interations are:
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
+class QLineEdit;
+class QPlainTextEdit;
 QT_END_NAMESPACE
 
 class MainWindow : public QMainWindow
@@ -29,6 +38,18 @@ class MainWindow : public QMainWindow
 public:
     MainWindow(GeoComponents *geo_components = nullptr, QWidget *parent = nullptr); //!< @brief Takes a pointer to a dynamically-initialized GeoComponents object, and sets the figures on the plot.
     ~MainWindow(); //!< @brief Deletes the GeoComponents object.
+    /** @brief Adds a batch of constructions at once (see GeoComponents::add_constructions), the plot is updated a single time at the end. Returns the number added. */
+    unsigned int add_constructions(const std::vector<GeoDescriptor>& batch);
+    /** @brief Creates the shared memory ring with the given key, through which another process can drive independent points. Returns false if it cannot. */
+    bool open_input(const QString& key);
+    /** @brief Sets the evaluation mode of the constructions (see GeoComponents::set_evaluation). In pull mode, drags only evaluate what is in view. */
+    void set_evaluation(Evaluation evaluation);
+    /** @brief Sets a time budget per frame in milliseconds (evaluation in pull mode): drags evaluate what is in view first, the rest within the budget and at idle. */
+    void set_frame_budget(double budget_ms);
+    /** @brief Shows (or hides) every intersection of the lines and circles in view as a single plottable, without creating points (see GeoIntersections). */
+    void set_intersections(bool enabled);
+    /** @brief Enables or disables magnetic snapping of the dragged points to the points, intersections, lines and circles in view (see GeoSnapping). */
+    void set_snapping(bool enabled);
 
 private slots:
     /** @brief Sets the configuration/parameters of the plot displayed. */
@@ -40,6 +61,11 @@ private slots:
     void onMousePress(QMouseEvent*); //!< @brief Handles edition of points by click and drag events: Identifies the underlying point, if any.
     void onMouseMove(QMouseEvent*); //!< @brief Handles edition of points by click and drag events: Edits the point that is currently being dragged, if any.
     void onMouseRelease(); //!< @brief Handles edition of points by click and drag events: Ends the drag event.
+    void present_frame(); //!< @brief Swaps in the newest snapshot evaluated by the engine and updates the plot.
+    void progressive_step(); //!< @brief Displays the next time slice of a progressive pass and shows the intermediate frame.
+    void view_changed(); //!< @brief Regroups the point clusters and culls the constructions after a pan or zoom, then updates the affected figures.
+    void run_command(); //!< @brief Executes the script command typed in the console and updates the plot once.
+    void report_input(); //!< @brief Shows the rate, drops and latency of the shared memory input on the statusbar.
 
     /** @brief Adjusts the proportion of the axis and updates the plot whenever the size of the window changes. */
     virtual void resizeEvent(QResizeEvent *event);
@@ -92,9 +118,55 @@ private slots:
 
 
 private:
+    /** @brief Takes the frame from the current constructions, between engine->wait_idle() and engine->sync() (the worker must not be evaluating). */
+    void take_frame();
+    /** @brief Updates all figures from the frame and replots, progressively for large scenes. */
+    void show_frame();
+    /** @brief Sets view to the visible rectangle {x_min, x_max, y_min, y_max} of the plot. */
+    void current_view(double view[4]) const;
+    /** @brief Returns the width of a pixel in plot coordinates. */
+    double pixel_size() const;
+    /** @brief Updates the clusters and the culling for the current view, adds to changed the pids whose visibility changed. */
+    void update_visibility(std::vector<unsigned int>* changed);
+
     Ui::MainWindow *ui; //!< Ui object of the MainWindow.
     /** @brief Pointer to the GeoComponents object containing the constructions. */
     GeoComponents* geo_components {nullptr};
+    /** @brief Evaluates the edits of geo_components on a worker thread. */
+    GeoEngine* engine {nullptr};
+    /** @brief Displays large scenes in time slices, driven by progressive_timer. */
+    ProgressiveDisplay* progressive {nullptr};
+    QTimer* progressive_timer {nullptr};
+    /** @brief Level-of-detail mode: aggregates points sharing a screen cell into a single glyph. */
+    PointClusters* clusters {nullptr};
+    /** @brief Intersections of all the lines and circles in view, updated with the clusters. */
+    GeoIntersections* intersections {nullptr};
+    /** @brief Magnetic snapping of the dragged point, indexed when the drag starts. */
+    GeoSnapping* snapping {nullptr};
+    /** @brief Snapshot of the constructions currently shown on the plot. */
+    GeoSnapshot frame;
+    /** @brief Executes the commands typed in the console. */
+    GeoScript* script {nullptr};
+    //@{
+    /** @brief Console: line where commands are typed and log of the commands and their output. */
+    QLineEdit* console_input {nullptr};
+    QPlainTextEdit* console_log {nullptr};
+    //@}
+    //@{
+    /** @brief Shared memory input, and the permanent statusbar label reporting on it every input_timer timeout. */
+    SharedRing<SharedRecord>* input {nullptr};
+    QTimer* input_timer {nullptr};
+    QLabel* input_label {nullptr};
+    //@}
+    /** @brief Permanent statusbar label reporting the number of constructions culled in the last frame. */
+    QLabel* culled_label {nullptr};
+    /** @brief Permanent statusbar label reporting the duplicates merged and the evaluations they saved, updated after structural changes. */
+    QLabel* merged_label {nullptr};
+    //@{
+    /** @brief Scenes with at least progressive_threshold constructions are displayed in slices of progressive_budget milliseconds. */
+    unsigned int progressive_threshold {5000};
+    int progressive_budget {8};
+    //@}
     //@{
     /** @brief Temporarily stores the labels of the constructions for ease of use. */
     std::vector<std::string> point_labels, line_labels, circle_labels, triangle_labels;